@@ -0,0 +1,68 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library benchmark helpers
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "redpitaya/rp.h"
+
+/* Monotonic time in nanoseconds */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Prints one result line: name, time per iteration and throughput */
+static inline void bench_report(const char *name, uint64_t elapsed_ns, uint32_t iterations, uint64_t samples)
+{
+    double per_iter = (double)elapsed_ns / iterations;
+    double msps = (double)samples * iterations / elapsed_ns * 1e3;
+    printf("%-40s %12.1f ns/iter %10.2f Msamples/s\n", name, per_iter, msps);
+}
+
+/* Initializes librp; on the simulated backend the ADC buffers are filled first */
+static inline void bench_init(void)
+{
+    int ret = rp_Init();
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_Init() failed: %s\n", rp_GetError(ret));
+        exit(EXIT_FAILURE);
+    }
+    if (rp_SimStep(0) == RP_OK) {
+        rp_AcqStart();
+        rp_SimStep(ADC_BUFFER_SIZE);
+    }
+}
+
+/* Shortest time of RUNS runs of ITERATIONS calls of the statement, both defined by the benchmark */
+#define BEST_OF(elapsed, statement) do { \
+    elapsed = UINT64_MAX; \
+    for (int run = 0; run < RUNS; ++run) { \
+        uint64_t start = bench_now_ns(); \
+        for (int i = 0; i < ITERATIONS; ++i) { \
+            statement; \
+        } \
+        uint64_t time = bench_now_ns() - start; \
+        elapsed = time < elapsed ? time : elapsed; \
+    } \
+} while (0)
+
+#endif /* __BENCH_H */
@@ -0,0 +1,54 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library acquisition read-out benchmark
+ *
+ * Measures the cost of reading the complete ADC buffer through the
+ * acquisition API, in raw counts and in volts.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include "bench.h"
+
+#define ITERATIONS 200
+
+int main(int argc, char **argv)
+{
+    static int16_t raw[ADC_BUFFER_SIZE];
+    static float volts1[ADC_BUFFER_SIZE], volts2[ADC_BUFFER_SIZE];
+    uint32_t size;
+    uint64_t start;
+
+    bench_init();
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataRaw(RP_CH_1, i, &size, raw);
+    }
+    bench_report("rp_AcqGetDataRaw", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataV(RP_CH_1, i, &size, volts1);
+    }
+    bench_report("rp_AcqGetDataV", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataV2(i, &size, volts1, volts2);
+    }
+    bench_report("rp_AcqGetDataV2 (both channels)", bench_now_ns() - start, ITERATIONS, 2 * ADC_BUFFER_SIZE);
+
+    rp_Release();
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library analog mixed signals sampler benchmark
+ *
+ * Compares the file access rp_AIpinGetValue() does for every value (open,
+ * fscanf, close) with rereading a descriptor kept open, as the sampler does,
+ * on a temporary file. The sampler is then run at 1 kHz: the time of
+ * rp_ApinGetAll() and the sweep rate reached are reported, and on the
+ * simulated backend the averages and extremes are checked against the
+ * model, whose ripple averages out over 16 sweeps.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define READS       20000
+#define CALLS       1000000
+#define PERIOD_US   1000
+#define WINDOW      16
+
+static const char *names[RP_AMS_CHANNELS] = { "AIN0", "AIN1", "AIN2", "AIN3", "TEMP", "VCCINT", "VCCAUX", "VCCBRAM" };
+
+int main(int argc, char **argv)
+{
+    char path[] = "/tmp/bench_ams_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1 || write(fd, "2048\n", 5) != 5) {
+        perror("temporary file");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < READS; ++i) {
+        int value;
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL || fscanf(fp, "%d", &value) != 1) {
+            return EXIT_FAILURE;
+        }
+        fclose(fp);
+    }
+    bench_report("fopen + fscanf + fclose per value", bench_now_ns() - start, READS, 1);
+
+    start = bench_now_ns();
+    for (int i = 0; i < READS; ++i) {
+        char buf[32];
+        ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+        if (len <= 0) {
+            return EXIT_FAILURE;
+        }
+        buf[len] = '\0';
+        strtol(buf, NULL, 10);
+    }
+    bench_report("pread of an open descriptor", bench_now_ns() - start, READS, 1);
+    close(fd);
+    unlink(path);
+
+    bench_init();
+    bool sim = rp_SimStep(0) == RP_OK;
+
+    start = bench_now_ns();
+    int ret = rp_ApinSamplerStart(PERIOD_US, WINDOW);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_ApinSamplerStart() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+    printf("%-40s %12.1f us\n", "rp_ApinSamplerStart", (bench_now_ns() - start) / 1e3);
+
+    rp_ams_snapshot_t snapshot;
+    start = bench_now_ns();
+    for (int i = 0; i < CALLS; ++i) {
+        rp_ApinGetAll(&snapshot);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report("rp_ApinGetAll", elapsed, CALLS, RP_AMS_CHANNELS);
+
+    // Sweep rate, over whole ripple periods so the averages settle on the nominal values
+    rp_ApinGetAll(&snapshot);
+    uint64_t sweeps = snapshot.sweeps, stamp = snapshot.timestamp_ns;
+    while (snapshot.sweeps < sweeps + 1000 || snapshot.sweeps % WINDOW != 0) {
+        usleep(PERIOD_US / 4);
+        rp_ApinGetAll(&snapshot);
+    }
+    printf("%-40s %12.1f sweeps/s (requested %d)\n", "sampler", (snapshot.sweeps - sweeps) * 1e9 / (snapshot.timestamp_ns - stamp),
+           1000000 / PERIOD_US);
+
+    bool ok = true;
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        const rp_ams_stat_t *stat = &snapshot.channel[c];
+        printf("  %-8s value %9.4f average %9.4f min %9.4f max %9.4f\n", names[c], stat->value, stat->average, stat->min, stat->max);
+        if (sim) {
+            // Nominal value +-0.5 % ripple, see the simulated backend
+            float nominal = stat->average;
+            ok &= fabsf(stat->min - nominal * 0.995f) < 1e-4f * nominal && fabsf(stat->max - nominal * 1.005f) < 1e-4f * nominal;
+        }
+    }
+
+    rp_ApinResetMinMax();
+    sweeps = snapshot.sweeps;
+    while (snapshot.sweeps < sweeps + 2) {
+        usleep(PERIOD_US);
+        rp_ApinGetAll(&snapshot);
+    }
+    ok &= snapshot.channel[RP_AMS_TEMP].max - snapshot.channel[RP_AMS_TEMP].min < 0.01f * 45.0f;
+    printf("averages and extremes %s\n", sim ? (ok ? "match the model" : "DO NOT match the model") : "not checked on hardware");
+
+    rp_ApinSamplerStop();
+    rp_Release();
+    return ok ? 0 : EXIT_FAILURE;
+}
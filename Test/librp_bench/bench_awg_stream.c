@@ -0,0 +1,130 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming generator playback benchmark
+ *
+ * Streams a signal many times longer than the AWG buffer through channel 1
+ * of the simulated generator at 125 Msamples/s. The simulated pointer is
+ * moved in steps of a quarter buffer, each once the refill thread has seen
+ * the previous one, and every sample played is compared with the stream
+ * written. The throughput of the refill path, the rate it would sustain on
+ * its own and the underrun counters are reported; the writer then stops so
+ * that underruns are exercised as well. Runs on the simulated backend only.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <unistd.h>
+
+#include "bench.h"
+
+#define AWG_SIZE        (16 * 1024)
+#define STREAM_SAMPLES  (4 * 1024 * 1024)
+#define STEP_SAMPLES    (AWG_SIZE / 4)
+#define CHUNK           4096
+
+static uint64_t checked = 0;
+static uint64_t mismatches = 0;
+static uint64_t silent = 0;
+
+/* Sample i of the stream, exactly representable in DAC counts */
+static int32_t stream_cnts(uint64_t i)
+{
+    return (int32_t)((i * 37) % AWG_SIZE) - AWG_SIZE / 2;
+}
+
+static void check_sink(rp_channel_t channel, uint64_t sample, const int16_t *buffer, uint32_t size, void *ctx)
+{
+    if (channel != RP_CH_1) {
+        return;
+    }
+    for (uint32_t i = 0; i < size; ++i, ++checked) {
+        if (checked >= STREAM_SAMPLES) {
+            silent += buffer[i] == 0;
+        }
+        else if (buffer[i] != stream_cnts(checked)) {
+            mismatches++;
+        }
+    }
+}
+
+/* Steps the simulated pointer and waits until the refill thread has seen it */
+static void step(uint64_t *stepped)
+{
+    rp_gen_stream_stats_t stats;
+    rp_SimStep(STEP_SAMPLES);
+    *stepped += STEP_SAMPLES;
+    for (rp_GenStreamGetStats(&stats); stats.played < *stepped; rp_GenStreamGetStats(&stats)) {
+        usleep(10);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static float chunk[CHUNK];
+
+    bench_init();
+    if (rp_SimStep(0) != RP_OK) {
+        fprintf(stderr, "bench_awg_stream needs the simulated backend (RP_BACKEND=sim)\n");
+        return EXIT_FAILURE;
+    }
+    rp_AcqSetDecimation(RP_DEC_1);
+    rp_SimSetOutputSink(check_sink, NULL);
+
+    rp_gen_stream_config_t config = { .channel = RP_CH_1, .sample_rate = 125e6, .queue_size = 4 * AWG_SIZE };
+    int ret = rp_GenStreamStart(&config);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_GenStreamStart() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+
+    uint64_t written = 0, stepped = 0;
+    uint64_t start = bench_now_ns();
+    while (stepped < STREAM_SAMPLES) {
+        // Keep the queue topped up, then play a quarter buffer
+        while (written < STREAM_SAMPLES) {
+            uint32_t size = CHUNK;
+            for (uint32_t i = 0; i < size; ++i) {
+                chunk[i] = stream_cnts(written + i) / (float) (AWG_SIZE / 2);
+            }
+            ret = rp_GenStreamWrite(chunk, &size, 0);
+            written += size;
+            if (ret == RP_ETIM) {
+                break;
+            }
+        }
+        if (written >= AWG_SIZE) {
+            step(&stepped);
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    rp_gen_stream_stats_t stats;
+    rp_GenStreamGetStats(&stats);
+    bench_report("rp_GenStreamWrite + refill", elapsed, STREAM_SAMPLES / STEP_SAMPLES, STEP_SAMPLES);
+    printf("%-40s %12.1f Msamples/s\n", "sustainable rate of the refill thread", stats.sustainable_rate / 1e6);
+    printf("played %llu, mismatches %llu, underruns %llu, late refills %llu\n",
+           (unsigned long long) checked, (unsigned long long) mismatches,
+           (unsigned long long) stats.underruns, (unsigned long long) stats.late_refills);
+    // The refill behind the end of the stream is already an underrun, earlier ones would be mismatches
+    bool ok = mismatches == 0 && stats.late_refills == 0 && checked == STREAM_SAMPLES;
+
+    // The writer has stopped: the buffer drains and the following halves are silent
+    for (int i = 0; i < 16; ++i) {
+        step(&stepped);
+    }
+    rp_GenStreamGetStats(&stats);
+    printf("after the end: underruns %llu, missing %llu, silent samples %llu\n",
+           (unsigned long long) stats.underruns, (unsigned long long) stats.missing, (unsigned long long) silent);
+    ok = ok && stats.underruns > 0 && stats.missing > 0 && silent > 0;
+
+    rp_GenStreamStop();
+    rp_Release();
+    return ok ? 0 : EXIT_FAILURE;
+}
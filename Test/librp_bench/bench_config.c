@@ -0,0 +1,184 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library configuration snapshot benchmark
+ *
+ * Reader threads convert a ramp to volts with rp_AcqGetDataV() while a
+ * writer thread keeps switching the gain of the channel, or keeps replacing
+ * its calibrated offset and full scale. The reader throughput is reported
+ * with and without the writer, together with the rate of changes, and every
+ * converted buffer must equal the conversion with one of the two settings for
+ * all of its samples. Runs on the simulated backend only.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define BLOCK_SIZE  1024
+#define READERS     2
+#define DURATION_NS 1000000000ULL
+
+static volatile bool running = true;
+static uint64_t conversions[READERS];
+static uint64_t changes = 0;
+static uint64_t errors = 0;
+
+/* Conversions with each of the two settings the writer switches between */
+static float expected[2][BLOCK_SIZE];
+static rp_calib_params_t calib[2];
+
+static void ramp_source(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        buffer[i] = (int16_t)((sample + i) % 16000) - 8000;
+    }
+}
+
+static bool matches(const float *buf, const float *ref, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        if (buf[i] != ref[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *reader(void *arg)
+{
+    static float buf[READERS][BLOCK_SIZE];
+    int id = (int)(intptr_t) arg;
+
+    while (running) {
+        uint32_t size = BLOCK_SIZE;
+        if (rp_AcqGetDataV(RP_CH_1, 0, &size, buf[id]) != RP_OK
+            || (!matches(buf[id], expected[0], size) && !matches(buf[id], expected[1], size))) {
+            __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+        }
+        conversions[id]++;
+    }
+    return NULL;
+}
+
+static void *gain_writer(void *arg)
+{
+    rp_pinState_t gain = RP_LOW;
+
+    while (running) {
+        gain = gain == RP_LOW ? RP_HIGH : RP_LOW;
+        rp_AcqSetGain(RP_CH_1, gain);
+        changes++;
+    }
+    return NULL;
+}
+
+/* Writes the other calibration and reloads it, as after a recalibration */
+static void *calib_writer(void *arg)
+{
+    int k = 0;
+
+    while (running) {
+        k ^= 1;
+        rp_CalibrationWriteParams(calib[k]);
+        rp_CalibInit();
+        changes++;
+    }
+    return NULL;
+}
+
+static void convert(float *ref)
+{
+    uint32_t size = BLOCK_SIZE;
+    rp_AcqGetDataV(RP_CH_1, 0, &size, ref);
+}
+
+static void run(const char *name, void *(*writer)(void *))
+{
+    pthread_t readers[READERS], writer_thread;
+
+    running = true;
+    changes = 0;
+    for (int i = 0; i < READERS; ++i) {
+        conversions[i] = 0;
+        pthread_create(&readers[i], NULL, reader, (void *)(intptr_t) i);
+    }
+    if (writer) {
+        pthread_create(&writer_thread, NULL, writer, NULL);
+    }
+
+    uint64_t start = bench_now_ns();
+    struct timespec ts = { DURATION_NS / 1000000000ULL, DURATION_NS % 1000000000ULL };
+    nanosleep(&ts, NULL);
+    running = false;
+    uint64_t elapsed = bench_now_ns() - start;
+
+    for (int i = 0; i < READERS; ++i) {
+        pthread_join(readers[i], NULL);
+    }
+    if (writer) {
+        pthread_join(writer_thread, NULL);
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < READERS; ++i) {
+        total += conversions[i];
+    }
+    bench_report(name, elapsed, total ? total : 1, BLOCK_SIZE);
+    if (writer) {
+        printf("%-40s %12.1f changes/s\n", "", changes / (elapsed / 1e9));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_init();
+    if (rp_SimStep(0) != RP_OK) {
+        fprintf(stderr, "bench_config needs the simulated backend (RP_BACKEND=sim)\n");
+        return EXIT_FAILURE;
+    }
+
+    rp_SimSetSignalSource(ramp_source, NULL);
+    rp_AcqStart();
+    rp_SimStep(ADC_BUFFER_SIZE);
+    rp_AcqStop();
+
+    // Low and high gain with the current calibration
+    rp_AcqSetGain(RP_CH_1, RP_LOW);
+    convert(expected[0]);
+    rp_AcqSetGain(RP_CH_1, RP_HIGH);
+    convert(expected[1]);
+    rp_AcqSetGain(RP_CH_1, RP_LOW);
+
+    run("rp_AcqGetDataV", NULL);
+    run("rp_AcqGetDataV while setting the gain", gain_writer);
+
+    // Low gain with the current and with a shifted, rescaled calibration
+    calib[0] = calib[1] = rp_GetCalibrationSettings();
+    calib[1].fe_ch1_lo_offs += 100;
+    calib[1].fe_ch1_hi_offs += 100;
+    calib[1].fe_ch1_fs_g_lo = calib[0].fe_ch1_fs_g_lo / 100 * 101;
+    calib[1].fe_ch1_fs_g_hi = calib[0].fe_ch1_fs_g_hi / 100 * 101;
+    rp_AcqSetGain(RP_CH_1, RP_LOW);
+    convert(expected[0]);
+    rp_CalibrationWriteParams(calib[1]);
+    rp_CalibInit();
+    convert(expected[1]);
+
+    run("rp_AcqGetDataV while recalibrating", calib_writer);
+    printf("inconsistent conversions %llu\n", (unsigned long long) errors);
+
+    rp_CalibrationWriteParams(calib[0]);
+    rp_CalibInit();
+    rp_Release();
+    return errors ? EXIT_FAILURE : 0;
+}
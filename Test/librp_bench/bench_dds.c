@@ -0,0 +1,132 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library software DDS benchmark
+ *
+ * Sets a series of frequencies with rp_GenFreq() and with rp_GenDdsFreq(),
+ * reporting the time per call and the frequency error: for rp_GenFreq() the
+ * error of the pointer step with one period in the whole buffer, for
+ * rp_GenDdsFreq() the error of the frequency it reports. A four tone FSK
+ * sequence is then played through the sweep engine with and without a DDS
+ * table chosen for its tones, and the time to start it is reported.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define POINTS      2000
+#define ACCURACY    0.001
+#define SYMBOLS     200
+#define DWELL_NS    1000000ULL
+
+static double frequencies[POINTS];
+
+static void report(const char *name, uint64_t elapsed, const double *errors)
+{
+    double sum = 0, max = 0;
+    int within = 0;
+    for (int i = 0; i < POINTS; ++i) {
+        sum += errors[i];
+        max = errors[i] > max ? errors[i] : max;
+        within += errors[i] <= ACCURACY;
+    }
+    printf("%-26s %10.1f ns/call   error mean %8.4f Hz max %8.4f Hz   within %.3f Hz %5.1f %%\n", name,
+           (double) elapsed / POINTS, sum / POINTS, max, ACCURACY, 100.0 * within / POINTS);
+}
+
+static int fsk(const char *name, double accuracy)
+{
+    static const double tones[4] = { 1000000.37, 1000100.11, 1000200.73, 1000300.59 };
+    static double freq_list[SYMBOLS];
+    static float amp_list[SYMBOLS];
+    uint32_t lfsr = 0xACE1u;
+
+    for (int i = 0; i < SYMBOLS; ++i) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        freq_list[i] = tones[lfsr & 3];
+        amp_list[i] = 0.8f;
+    }
+    rp_gen_sweep_config_t config = {
+        .channel = RP_CH_1,
+        .mode = RP_GEN_SWEEP_LIST,
+        .steps = SYMBOLS,
+        .freq_list = freq_list,
+        .amp_list = amp_list,
+        .dwell_ns = DWELL_NS,
+        .dds_accuracy = accuracy
+    };
+
+    uint64_t start = bench_now_ns();
+    int ret = rp_GenSweepStart(&config, NULL, NULL);
+    uint64_t started = bench_now_ns();
+    if (ret != RP_OK) {
+        fprintf(stderr, "%s: rp_GenSweepStart() failed: %s\n", name, rp_GetError(ret));
+        return ret;
+    }
+    bool running = true;
+    while (running) {
+        usleep(1000);
+        rp_GenSweepIsRunning(&running);
+    }
+    uint64_t end = bench_now_ns();
+    rp_GenSweepStop();
+    printf("%-26s start %8.1f us   %u symbols of %llu us in %8.1f us\n", name, (started - start) / 1e3,
+           SYMBOLS, DWELL_NS / 1000, (end - started) / 1e3);
+    return RP_OK;
+}
+
+int main(int argc, char **argv)
+{
+    static double errors[POINTS];
+    const double resolution = 125e6 / 1073741824.0;   // one period in 16384 samples
+
+    bench_init();
+
+    // Frequencies with a fractional part, spread logarithmically over 1 kHz .. 20 MHz
+    for (int i = 0; i < POINTS; ++i) {
+        frequencies[i] = floor(1e3 * pow(2e4, (double) i / POINTS) * 1000 + (i * 7919) % 1000) / 1000;
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < POINTS; ++i) {
+        rp_GenFreq(RP_CH_1, frequencies[i]);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    for (int i = 0; i < POINTS; ++i) {
+        errors[i] = fabs(round(frequencies[i] / resolution) * resolution - frequencies[i]);
+    }
+    report("rp_GenFreq", elapsed, errors);
+
+    elapsed = 0;
+    for (int i = 0; i < POINTS; ++i) {
+        double actual;
+        start = bench_now_ns();
+        int ret = rp_GenDdsFreq(RP_CH_1, frequencies[i], ACCURACY, &actual);
+        elapsed += bench_now_ns() - start;
+        if (ret != RP_OK) {
+            fprintf(stderr, "rp_GenDdsFreq(%f) failed: %s\n", frequencies[i], rp_GetError(ret));
+            return EXIT_FAILURE;
+        }
+        errors[i] = fabs(actual - frequencies[i]);
+    }
+    report("rp_GenDdsFreq", elapsed, errors);
+
+    rp_GenFreq(RP_CH_1, 1e6);
+    if (fsk("FSK sweep", 0) != RP_OK || fsk("FSK sweep, DDS table", ACCURACY) != RP_OK) {
+        return EXIT_FAILURE;
+    }
+
+    rp_Release();
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library digital pin benchmark
+ *
+ * Shows a pattern on the LED bar and bit-bangs a byte on the DIO_P pins,
+ * once pin by pin with rp_DpinSetState() and once with rp_DpinSetStateMask(),
+ * and reads all pins with rp_DpinGetState() and rp_DpinGetStateAll(). A
+ * sequence of LED transitions is then played from user code with usleep()
+ * between them and with rp_DpinSequenceStart(); the mean and largest delay
+ * of the transitions past their time is reported for both.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define ITERATIONS      100000
+#define TRANSITIONS     500
+#define SPACING_NS      200000ULL
+
+static rp_dpin_transition_t transitions[TRANSITIONS];
+
+int main(int argc, char **argv)
+{
+    bench_init();
+    for (rp_dpin_t pin = RP_DIO0_P; pin <= RP_DIO7_P; ++pin) {
+        rp_DpinSetDirection(pin, RP_OUT);
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        for (rp_dpin_t pin = RP_LED0; pin <= RP_LED7; ++pin) {
+            rp_DpinSetState(pin, (i >> pin) & 1);
+        }
+    }
+    bench_report("LED bar, rp_DpinSetState", bench_now_ns() - start, ITERATIONS, 8);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        rp_DpinSetStateMask(0xFF, i);
+    }
+    bench_report("LED bar, rp_DpinSetStateMask", bench_now_ns() - start, ITERATIONS, 8);
+
+    // Clock on DIO0_P, data bits on DIO1_P: two edges per bit
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS / 8; ++i) {
+        for (int bit = 7; bit >= 0; --bit) {
+            rp_DpinSetState(RP_DIO1_P, (i >> bit) & 1);
+            rp_DpinSetState(RP_DIO0_P, RP_HIGH);
+            rp_DpinSetState(RP_DIO0_P, RP_LOW);
+        }
+    }
+    bench_report("bit-bang byte, rp_DpinSetState", bench_now_ns() - start, ITERATIONS / 8, 8);
+
+    const uint32_t clk = RP_DPIN_MASK(RP_DIO0_P), data = RP_DPIN_MASK(RP_DIO1_P);
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS / 8; ++i) {
+        for (int bit = 7; bit >= 0; --bit) {
+            uint32_t level = (i >> bit) & 1 ? data : 0;
+            rp_DpinSetStateMask(clk | data, clk | level);
+            rp_DpinSetStateMask(clk, 0);
+        }
+    }
+    bench_report("bit-bang byte, rp_DpinSetStateMask", bench_now_ns() - start, ITERATIONS / 8, 8);
+
+    uint32_t all = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        for (rp_dpin_t pin = RP_LED0; pin <= RP_DIO7_N; ++pin) {
+            rp_pinState_t state;
+            rp_DpinGetState(pin, &state);
+            all ^= state << pin;
+        }
+    }
+    bench_report("read all pins, rp_DpinGetState", bench_now_ns() - start, ITERATIONS, 24);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        uint32_t state;
+        rp_DpinGetStateAll(&state);
+        all ^= state;
+    }
+    bench_report("read all pins, rp_DpinGetStateAll", bench_now_ns() - start, ITERATIONS, 24);
+
+    // A light running along the LED bar
+    for (int i = 0; i < TRANSITIONS; ++i) {
+        transitions[i] = (rp_dpin_transition_t) {
+            .time_ns = i * SPACING_NS,
+            .mask = 0xFF,
+            .state = RP_DPIN_MASK(i % 8)
+        };
+    }
+
+    double sum = 0;
+    uint64_t max = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < TRANSITIONS; ++i) {
+        uint64_t due = start + transitions[i].time_ns, now = bench_now_ns();
+        if (due > now) {
+            usleep((due - now) / 1000);
+        }
+        uint64_t late = bench_now_ns() - due;
+        rp_DpinSetStateMask(transitions[i].mask, transitions[i].state);
+        sum += late;
+        max = late > max ? late : max;
+    }
+    printf("%-40s delay mean %8.1f us max %8.1f us\n", "sequence, usleep loop", sum / TRANSITIONS / 1e3, max / 1e3);
+
+    int ret = rp_DpinSequenceStart(transitions, TRANSITIONS);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_DpinSequenceStart() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+    bool running = true;
+    while (running) {
+        usleep(1000);
+        rp_DpinSequenceIsRunning(&running);
+    }
+    rp_DpinSequenceGetLateness(&max);
+    rp_DpinSequenceStop();
+    printf("%-40s delay max %8.1f us\n", "sequence, rp_DpinSequenceStart", max / 1e3);
+
+    uint32_t state;
+    rp_DpinGetStateAll(&state);
+    printf("final LED state 0x%02x (expected 0x%02x)\n", state & 0xFF, RP_DPIN_MASK((TRANSITIONS - 1) % 8));
+
+    rp_Release();
+    return (state & 0xFF) == RP_DPIN_MASK((TRANSITIONS - 1) % 8) && all != 0xFFFFFFFF ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,144 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library FFT benchmark
+ *
+ * Times 16k sample complex and real transforms, the size of the ADC buffer,
+ * with the kiss_fft and the radix-4 backends, each as the best of several
+ * runs, and compares every result with a double precision reference
+ * transform. A 10000 sample complex transform checks the kiss_fft fallback
+ * of RP_FFT_AUTO, and the time of a cached plan lookup is reported.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define LEN         (16 * 1024)
+#define ODD_LEN     10000
+#define ITERATIONS  50
+#define RUNS        10
+#define LOOKUPS     1000000
+
+static rp_fft_cpx_t in[LEN], out[LEN];
+static double complex ref[LEN];
+
+/* Double precision reference: radix-2 for powers of two, direct DFT otherwise */
+static void reference(const rp_fft_cpx_t *x, uint32_t n, bool real, double complex *y)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        y[i] = real ? ((const float *)x)[i] : x[i].r + I * x[i].i;
+    }
+    if (n & (n - 1)) {
+        static double complex t[LEN];
+        for (uint32_t k = 0; k < n; ++k) {
+            double complex s = 0;
+            for (uint32_t i = 0; i < n; ++i) {
+                s += y[i] * cexp(-2 * M_PI * I * ((uint64_t)i * k % n) / n);
+            }
+            t[k] = s;
+        }
+        for (uint32_t k = 0; k < n; ++k) {
+            y[k] = t[k];
+        }
+        return;
+    }
+    for (uint32_t i = 1, j = 0; i < n; ++i) {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            double complex t = y[i]; y[i] = y[j]; y[j] = t;
+        }
+    }
+    for (uint32_t len = 2; len <= n; len <<= 1) {
+        for (uint32_t i = 0; i < n; i += len) {
+            for (uint32_t k = 0; k < len / 2; ++k) {
+                double complex w = cexp(-2 * M_PI * I * k / len);
+                double complex a = y[i + k], b = y[i + k + len / 2] * w;
+                y[i + k] = a + b;
+                y[i + k + len / 2] = a - b;
+            }
+        }
+    }
+}
+
+/* Error of the bins relative to the largest reference bin, in dB */
+static double compare(const rp_fft_cpx_t *y, const double complex *r, uint32_t bins)
+{
+    double peak = 0, err = 0;
+    for (uint32_t k = 0; k < bins; ++k) {
+        peak = fmax(peak, cabs(r[k]));
+        err = fmax(err, cabs(y[k].r + I * y[k].i - r[k]));
+    }
+    return 20 * log10(err / peak);
+}
+
+static bool run(const char *name, rp_fft_backend_t backend, uint32_t size, rp_fft_type_t type)
+{
+    rp_fft_plan_t *plan;
+    uint32_t bins = type == RP_FFT_REAL ? size / 2 + 1 : size;
+    char label[64];
+
+    rp_FftSetBackend(backend);
+    int ret = rp_FftPlanGet(size, type, &plan);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_FftPlanGet(%u) failed: %s\n", size, rp_GetError(ret));
+        return false;
+    }
+
+    uint64_t elapsed;
+    BEST_OF(elapsed, rp_FftExecute(plan, in, out));
+    snprintf(label, sizeof(label), "%s %u %s", name, size, type == RP_FFT_REAL ? "real" : "complex");
+    bench_report(label, elapsed, ITERATIONS, size);
+
+    reference(in, size, type == RP_FFT_REAL, ref);
+    double err = compare(out, ref, bins);
+    printf("%-40s %12.1f dB below the peak\n", "  largest error", -err);
+    return err < -100;
+}
+
+int main(int argc, char **argv)
+{
+    // Two tones and noise of ADC counts; the real transforms read the same memory as 2*LEN floats
+    uint32_t lfsr = 1;
+    for (int i = 0; i < LEN; ++i) {
+        lfsr = lfsr * 1664525u + 1013904223u;
+        in[i].r = round(4000 * sin(2 * M_PI * 1000.3 * i / LEN) + (lfsr >> 8) / 16777216.0 * 4 - 2);
+        in[i].i = round(100 * cos(2 * M_PI * 5000.7 * i / LEN));
+    }
+
+    bool ok = true;
+    ok &= run("kiss", RP_FFT_KISS, LEN, RP_FFT_COMPLEX);
+    ok &= run("radix4", RP_FFT_RADIX4, LEN, RP_FFT_COMPLEX);
+    ok &= run("kiss", RP_FFT_KISS, LEN, RP_FFT_REAL);
+    ok &= run("radix4", RP_FFT_RADIX4, LEN, RP_FFT_REAL);
+    ok &= run("radix4", RP_FFT_RADIX4, LEN / 2, RP_FFT_COMPLEX);
+    ok &= run("auto", RP_FFT_AUTO, ODD_LEN, RP_FFT_COMPLEX);
+
+    rp_fft_plan_t *plan;
+    ok &= rp_FftPlanGet(ODD_LEN, RP_FFT_COMPLEX, &plan) == RP_OK;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; ++i) {
+        rp_FftPlanGet(LEN, RP_FFT_COMPLEX, &plan);
+    }
+    bench_report("rp_FftPlanGet, cached", bench_now_ns() - start, LOOKUPS, 1);
+
+    rp_FftSetBackend(RP_FFT_RADIX4);
+    ok &= rp_FftPlanGet(ODD_LEN, RP_FFT_COMPLEX, &plan) == RP_EIPV;
+    rp_FftCleanup();
+    printf("results %s\n", ok ? "match the reference" : "DO NOT match the reference");
+    return ok ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,111 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library signal generator benchmark
+ *
+ * Times the generator setters in the way parameter sweeps use them: stepping
+ * the frequency, amplitude, phase and duty cycle, switching between
+ * waveforms that were used before, and uploading arbitrary waveforms either
+ * copied by the library or handed over to it.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "bench.h"
+
+#define STEPS 2000
+
+static void sweep(const char *name, rp_waveform_t waveform, int (*step)(uint32_t i))
+{
+    rp_GenWaveform(RP_CH_1, waveform);
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < STEPS; ++i) {
+        int ret = step(i);
+        if (ret != RP_OK) {
+            fprintf(stderr, "%s: step %u failed: %s\n", name, i, rp_GetError(ret));
+            exit(EXIT_FAILURE);
+        }
+    }
+    bench_report(name, bench_now_ns() - start, STEPS, ADC_BUFFER_SIZE);
+}
+
+static int step_freq(uint32_t i)
+{
+    return rp_GenFreq(RP_CH_1, 1000 + 10 * i);
+}
+
+static int step_amp(uint32_t i)
+{
+    return rp_GenAmp(RP_CH_1, 0.1 + 0.8 * i / STEPS);
+}
+
+static int step_phase(uint32_t i)
+{
+    return rp_GenPhase(RP_CH_1, 360.0 * i / STEPS);
+}
+
+static int step_duty(uint32_t i)
+{
+    return rp_GenDutyCycle(RP_CH_1, 0.1 + 0.8 * i / STEPS);
+}
+
+static int step_waveform(uint32_t i)
+{
+    static const rp_waveform_t waveforms[] = {
+        RP_WAVEFORM_SINE, RP_WAVEFORM_TRIANGLE, RP_WAVEFORM_SQUARE, RP_WAVEFORM_RAMP_UP
+    };
+    return rp_GenWaveform(RP_CH_1, waveforms[i % 4]);
+}
+
+/* Two distinct user waveforms, so that every upload rewrites the whole buffer */
+static float arb_tables[2][ADC_BUFFER_SIZE];
+
+static int step_arb(uint32_t i)
+{
+    static float data[ADC_BUFFER_SIZE];
+    memcpy(data, arb_tables[i % 2], sizeof(data));
+    return rp_GenArbWaveform(RP_CH_1, data, ADC_BUFFER_SIZE);
+}
+
+static int step_arb_move(uint32_t i)
+{
+    float *data = malloc(sizeof(arb_tables[0]));
+    memcpy(data, arb_tables[i % 2], sizeof(arb_tables[0]));
+    int ret = rp_GenArbWaveformMove(RP_CH_1, data, ADC_BUFFER_SIZE);
+    if (ret != RP_OK) {
+        free(data);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    bench_init();
+
+    for (int i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        arb_tables[0][i] = sinf(2 * M_PI * i / ADC_BUFFER_SIZE);
+        arb_tables[1][i] = 0.5f * cosf(6 * M_PI * i / ADC_BUFFER_SIZE);
+    }
+
+    sweep("rp_GenFreq sweep (sine)", RP_WAVEFORM_SINE, step_freq);
+    sweep("rp_GenFreq sweep (square)", RP_WAVEFORM_SQUARE, step_freq);
+    sweep("rp_GenAmp sweep (sine)", RP_WAVEFORM_SINE, step_amp);
+    sweep("rp_GenPhase sweep (sine)", RP_WAVEFORM_SINE, step_phase);
+    sweep("rp_GenDutyCycle sweep (PWM)", RP_WAVEFORM_PWM, step_duty);
+    sweep("rp_GenWaveform cycling", RP_WAVEFORM_SINE, step_waveform);
+    sweep("rp_GenArbWaveform upload", RP_WAVEFORM_ARBITRARY, step_arb);
+    sweep("rp_GenArbWaveformMove upload", RP_WAVEFORM_ARBITRARY, step_arb_move);
+
+    rp_Release();
+    return 0;
+}
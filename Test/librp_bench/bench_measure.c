@@ -0,0 +1,208 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library stimulus-response measurement benchmark
+ *
+ * Plays a sine burst on both generator channels and captures both inputs,
+ * averaged over a number of repeats: once with the call sequence user code
+ * needs today (burst setup, arm, trigger source, generator trigger, polling
+ * with usleep() and a readout per repeat) and once with rp_MeasureResponse().
+ * The simulated inputs are looped back from the generator outputs, so every
+ * capture must start at the first sample of the burst and all repeats must
+ * be identical. The burst settings of the generator must be those of the
+ * user again afterwards. A second thread steps the simulation in real time.
+ * Runs on the simulated backend only.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define SIZE        4096
+#define REPEATS     50
+#define BURSTS      4
+#define FREQUENCY   125e6 / 1024
+#define STEP        256
+#define LOOP_SIZE   (64 * 1024)
+
+static int16_t loop_data[2][LOOP_SIZE];
+static uint64_t loop_stamp[2][LOOP_SIZE];
+static volatile bool running = true;
+
+/* Generator output, kept with the clock it was played at */
+static void loop_sink(rp_channel_t channel, uint64_t sample, const int16_t *buffer, uint32_t size, void *ctx)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        loop_data[channel][(sample + i) % LOOP_SIZE] = buffer[i];
+        loop_stamp[channel][(sample + i) % LOOP_SIZE] = sample + i + 1;
+    }
+}
+
+/* Input sampled at decimation 1: the output of the same clock, 0 V while the generator is idle */
+static void loop_source(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t k = (sample + i) % LOOP_SIZE;
+        buffer[i] = loop_stamp[channel][k] == sample + i + 1 ? loop_data[channel][k] : 0;
+    }
+}
+
+static void *stepper(void *arg)
+{
+    struct timespec idle = { 0, 20000 };
+    while (running) {
+        rp_SimStep(STEP);
+        nanosleep(&idle, NULL);
+    }
+    return NULL;
+}
+
+static int manual(float *sum1, float *sum2)
+{
+    static float buf1[SIZE], buf2[SIZE];
+
+    rp_GenMode(RP_CH_1, RP_GEN_MODE_BURST);
+    rp_GenMode(RP_CH_2, RP_GEN_MODE_BURST);
+    rp_GenBurstCount(RP_CH_1, BURSTS);
+    rp_GenBurstCount(RP_CH_2, BURSTS);
+    rp_AcqSetTriggerDelay(SIZE - ADC_BUFFER_SIZE / 2);
+    memset(sum1, 0, SIZE * sizeof(float));
+    memset(sum2, 0, SIZE * sizeof(float));
+
+    for (int r = 0; r < REPEATS; ++r) {
+        rp_AcqStart();
+        rp_AcqSetTriggerSrc(RP_TRIG_SRC_AWG_PE);
+        rp_GenTrigger(3);
+
+        rp_acq_trig_src_t source = RP_TRIG_SRC_AWG_PE;
+        uint64_t start = bench_now_ns();
+        while (source != RP_TRIG_SRC_DISABLED) {
+            if (bench_now_ns() - start > 1000000000ULL) {
+                return RP_ETIM;
+            }
+            usleep(1000);
+            rp_AcqGetTriggerSrc(&source);
+        }
+
+        uint32_t pos, size = SIZE;
+        rp_AcqGetWritePointerAtTrig(&pos);
+        rp_AcqGetDataV2(pos, &size, buf1, buf2);
+        for (int i = 0; i < SIZE; ++i) {
+            sum1[i] += buf1[i];
+            sum2[i] += buf2[i];
+        }
+    }
+    return RP_OK;
+}
+
+/* Burst settings of a channel as read back through the API */
+typedef struct {
+    rp_gen_mode_t mode;
+    int count;
+    int repetitions;
+    uint32_t period;
+} burst_settings_t;
+
+static void get_bursts(burst_settings_t *settings)
+{
+    for (rp_channel_t ch = RP_CH_1; ch <= RP_CH_2; ++ch) {
+        rp_GenGetMode(ch, &settings[ch].mode);
+        rp_GenGetBurstCount(ch, &settings[ch].count);
+        rp_GenGetBurstRepetitions(ch, &settings[ch].repetitions);
+        rp_GenGetBurstPeriod(ch, &settings[ch].period);
+    }
+}
+
+/* Largest difference of the averages from a single capture, and whether the burst starts at sample 0 */
+static float compare(const float *sum, const float *single, bool *aligned)
+{
+    float max = 0;
+    for (int i = 0; i < SIZE; ++i) {
+        max = fmaxf(max, fabsf(sum[i] / REPEATS - single[i]));
+    }
+    // Sine burst from phase 0: near 0 V at the start, a quarter period later at its peak
+    *aligned = fabsf(single[0]) < 0.01 && single[256] > 0.5;
+    return max;
+}
+
+int main(int argc, char **argv)
+{
+    static float sum1[SIZE], sum2[SIZE], single1[SIZE], single2[SIZE];
+
+    bench_init();
+    if (rp_SimStep(0) != RP_OK) {
+        fprintf(stderr, "bench_measure needs the simulated backend (RP_BACKEND=sim)\n");
+        return EXIT_FAILURE;
+    }
+    rp_SimSetOutputSink(loop_sink, NULL);
+    rp_SimSetSignalSource(loop_source, NULL);
+    rp_AcqSetDecimation(RP_DEC_1);
+    for (rp_channel_t ch = RP_CH_1; ch <= RP_CH_2; ++ch) {
+        rp_GenWaveform(ch, RP_WAVEFORM_SINE);
+        rp_GenFreq(ch, FREQUENCY);
+        rp_GenAmp(ch, 0.8);
+        rp_GenOutEnable(ch);
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, stepper, NULL);
+
+    uint64_t start = bench_now_ns();
+    int ret = manual(sum1, sum2);
+    uint64_t elapsed = bench_now_ns() - start;
+    if (ret != RP_OK) {
+        fprintf(stderr, "manual sequence failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+    bench_report("manual sequence + usleep poll", elapsed, REPEATS, SIZE);
+
+    // User settings that differ from the measurement bursts
+    burst_settings_t before[2], after[2];
+    for (rp_channel_t ch = RP_CH_1; ch <= RP_CH_2; ++ch) {
+        rp_GenBurstCount(ch, BURSTS + 3);
+        rp_GenBurstRepetitions(ch, 3);
+        rp_GenBurstPeriod(ch, 1000);
+    }
+    get_bursts(before);
+
+    rp_measure_config_t config = { .burst_count = BURSTS, .size = SIZE, .repeats = 1, .timeout_us = 1000000 };
+    ret = rp_MeasureResponse(&config, single1, single2);
+    bool aligned;
+    float manual_err = compare(sum1, single1, &aligned);
+
+    config.repeats = REPEATS;
+    start = bench_now_ns();
+    ret = ret == RP_OK ? rp_MeasureResponse(&config, sum1, sum2) : ret;
+    elapsed = bench_now_ns() - start;
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_MeasureResponse() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+    bench_report("rp_MeasureResponse", elapsed, REPEATS, SIZE);
+
+    float err1 = compare(sum1, single1, &aligned);
+    float err2 = compare(sum2, single2, &aligned);
+    printf("burst at sample 0: %s, max deviation from one capture: manual %.4f V, rp_MeasureResponse %.4f V\n",
+           aligned ? "yes" : "no", manual_err, fmaxf(err1, err2));
+
+    get_bursts(after);
+    bool restored = memcmp(before, after, sizeof(before)) == 0;
+    printf("generator burst settings restored: %s\n", restored ? "yes" : "no");
+
+    running = false;
+    pthread_join(thread, NULL);
+    rp_Release();
+    return aligned && restored && err1 < 1e-4 && err2 < 1e-4 ? 0 : EXIT_FAILURE;
+}
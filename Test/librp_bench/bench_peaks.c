@@ -0,0 +1,152 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library spectrum display path benchmark
+ *
+ * Times the reduction of 8k FFT magnitudes to the 2k displayed bins with
+ * rp_spectr_decimate() against the former per bin pow() evaluation, and the
+ * conversion of the bins to dBm with rp_spectr_dBm_peaks(), which finds the
+ * highest peaks in the same pass, against log10() and a search for the
+ * maximum. The error of rp_spectr_log10f() is measured over the whole float
+ * range, and the interpolated peaks of tones between bins are compared with
+ * their true frequency and level.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "bench.h"
+#include "spec_dsp.h"
+
+#define LEN         4096
+#define BINS        (LEN / 2)
+#define FFT_BINS    (4 * BINS)
+#define TONES       5
+#define ITERATIONS  200
+#define RUNS        10
+
+static double mag_a[FFT_BINS], mag_b[FFT_BINS];
+static float in_a[LEN], in_b[LEN], pow_a[BINS], pow_b[BINS], out_a[BINS], out_b[BINS];
+static volatile float sink;
+
+/* rp_spectr_decimate() before the scale was taken out of the loop */
+static void decimate_pow(const double *cha_in, const double *chb_in, float *cha_o, float *chb_o,
+                         int in_len, int out_len)
+{
+    int step = in_len / out_len;
+    for (int i = 0, j = 0; i < out_len; i++, j += step) {
+        cha_o[i] = 0;
+        chb_o[i] = 0;
+        double c2v = 0.5 / (float)((int)(1 << 13));
+        for (int k = j; k < j + step; k++) {
+            double cha_p = pow(cha_in[k] * c2v, 2) / 50 / (double)(2 * in_len) / (double)(2 * in_len) * 2;
+            double chb_p = pow(chb_in[k] * c2v, 2) / 50 / (double)(2 * in_len) / (double)(2 * in_len) * 2;
+            cha_o[i] += (float)cha_p;
+            chb_o[i] += (float)chb_p;
+        }
+    }
+}
+
+/* dBm conversion with log10() and the highest bin */
+static int dBm_max(const float *in, float *out, int len)
+{
+    int max = 0;
+    for (int i = 0; i < len; i++) {
+        out[i] = in[i] * 1000 > 1.0e-12 ? 10 * log10(in[i] * 1000) : 10 * log10(1.0e-12);
+        if (out[i] > out[max]) {
+            max = i;
+        }
+    }
+    return max;
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = true;
+    uint64_t elapsed;
+
+    // rp_spectr_log10f() over all exponents, 1024 mantissas each
+    double err = 0;
+    for (int e = -126; e < 128; ++e) {
+        for (int m = 0; m < 1024; ++m) {
+            float x = ldexpf(1 + m / 1024.0f + 1 / 4096.0f, e);
+            err = fmax(err, fabs(rp_spectr_log10f(x) - log10((double)x)));
+        }
+    }
+    printf("%-40s %12.2e (%.2e dB)\n", "rp_spectr_log10f largest error", err, 10 * err);
+    ok &= err < 1e-5;
+
+    // Magnitudes of 8k FFT bins and power of BINS bins, with TONES tones between bins
+    const double tone_bin[TONES] = { 100.3, 250.5, 612.8, 1024.1, 1800.45 };
+    const double tone_amp[TONES] = { 1000, 10, 300, 3, 2000 };
+    uint32_t lfsr = 1;
+    for (int i = 0; i < FFT_BINS; ++i) {
+        lfsr = lfsr * 1664525u + 1013904223u;
+        mag_a[i] = mag_b[i] = (lfsr >> 8) / 16.0;
+    }
+    for (int i = 0; i < LEN; ++i) {
+        double x = 0;
+        for (int t = 0; t < TONES; ++t) {
+            x += tone_amp[t] * cos(2 * M_PI * tone_bin[t] * i / LEN);
+        }
+        lfsr = lfsr * 1664525u + 1013904223u;
+        in_a[i] = in_b[i] = x + ((lfsr >> 8) / 16777216.0 - 0.5) * 1e-3;
+    }
+    rp_spectr_fft_power_f(in_a, in_b, pow_a, pow_b, LEN);
+    // Counts^2 -> W: a full scale tone of 8192 counts is 10 dBm
+    const float scale = 10e-3 / pow(8192 * 0.8165 * LEN / 2, 2);
+    for (int i = 0; i < BINS; ++i) {
+        pow_a[i] *= scale;
+    }
+
+    double *ma = mag_a, *mb = mag_b;
+    float *oa = out_a, *ob = out_b;
+    BEST_OF(elapsed, decimate_pow(mag_a, mag_b, out_a, out_b, FFT_BINS, BINS));
+    bench_report("decimate, pow() per bin", elapsed, ITERATIONS, 2 * FFT_BINS);
+    BEST_OF(elapsed, rp_spectr_decimate(ma, mb, &oa, &ob, FFT_BINS, BINS));
+    bench_report("rp_spectr_decimate", elapsed, ITERATIONS, 2 * FFT_BINS);
+
+    float x = 0;
+    BEST_OF(elapsed, for (int k = 0; k < BINS; ++k) x += log10f(pow_a[k]));
+    bench_report("log10f", elapsed, ITERATIONS, BINS);
+    BEST_OF(elapsed, for (int k = 0; k < BINS; ++k) x += rp_spectr_log10f(pow_a[k]));
+    bench_report("rp_spectr_log10f", elapsed, ITERATIONS, BINS);
+    sink = x;
+
+    rp_spectr_peak_t peaks[TONES];
+    int max = 0, found = 0;
+    BEST_OF(elapsed, max = dBm_max(pow_a, out_b, BINS));
+    bench_report("dBm with log10() + maximum", elapsed, ITERATIONS, BINS);
+    BEST_OF(elapsed, found = rp_spectr_dBm_peaks(pow_a, out_a, BINS, peaks, TONES));
+    bench_report("rp_spectr_dBm_peaks, 5 peaks", elapsed, ITERATIONS, BINS);
+
+    double db_err = 0;
+    for (int i = 0; i < BINS; ++i) {
+        db_err = fmax(db_err, fabs(out_a[i] - out_b[i]));
+    }
+    printf("%-40s %12.2e dB\n", "  largest dBm difference", db_err);
+    ok &= db_err < 1e-4 && found == TONES && lrintf(peaks[0].bin) == max;
+
+    // Peaks from the highest tone down, against the true tones
+    const int order[TONES] = { 4, 0, 2, 1, 3 };
+    for (int p = 0; p < found; ++p) {
+        int t = order[p];
+        double level = 10 + 20 * log10(tone_amp[t] / 8192);
+        double raw = out_a[lrint(tone_bin[t])];
+        printf("  tone %7.2f %6.1f dBm: bin %+7.3f, level %+7.3f dB, nearest bin %+7.3f dB\n",
+               tone_bin[t], level, peaks[p].bin - tone_bin[t], peaks[p].level - level, raw - level);
+        ok &= fabs(peaks[p].bin - tone_bin[t]) < 0.1 && fabs(peaks[p].level - level) < 0.4;
+    }
+
+    rp_spectr_fft_f_clean();
+    printf("results %s\n", ok ? "match the reference" : "DO NOT match the reference");
+    return ok ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,102 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library raw read-out benchmark
+ *
+ * Compares rp_AcqGetDataRaw() (burst copy of at most two ring spans and a
+ * vectorized calibration kernel) with the former scalar path, which wrapped,
+ * masked and calibrated every sample separately. The scalar path runs on a
+ * cached snapshot of the ring, so on the board it is an optimistic reference.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <string.h>
+
+#include "bench.h"
+
+#define ITERATIONS 500
+#define ADC_BITS   14
+
+/* Former per-sample implementation of cmn_CalibCnts() */
+static int32_t scalar_calib(uint32_t field_len, uint32_t cnts, int calib_dc_off)
+{
+    int32_t m;
+
+    if (cnts & (1 << (field_len - 1))) {
+        m = -1 * ((cnts ^ ((1 << field_len) - 1)) + 1);
+    } else {
+        m = cnts;
+    }
+    m -= calib_dc_off;
+    if (m < (-1 * (1 << (field_len - 1))))
+        m = (-1 * (1 << (field_len - 1)));
+    else if (m > (1 << (field_len - 1)))
+        m = (1 << (field_len - 1));
+    return m;
+}
+
+/* Former scalar loop of acq_GetDataRaw() */
+static void scalar_raw(const volatile uint32_t *raw, uint32_t pos, uint32_t size, int16_t *buffer, int dc_offs)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t cnts = raw[(pos + i) % ADC_BUFFER_SIZE] & 0x3FFF;
+        buffer[i] = scalar_calib(ADC_BITS, cnts, dc_offs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static uint16_t raw16[ADC_BUFFER_SIZE], unused[ADC_BUFFER_SIZE];
+    static uint32_t raw[ADC_BUFFER_SIZE];
+    static int16_t ref[ADC_BUFFER_SIZE], out[ADC_BUFFER_SIZE];
+    uint32_t size;
+    uint64_t start;
+
+    bench_init();
+
+    /* snapshot of the ring for the reference path */
+    size = ADC_BUFFER_SIZE;
+    rp_AcqGetDataRawV2(0, &size, raw16, unused);
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        raw[i] = raw16[i];
+    }
+
+    rp_pinState_t gain;
+    rp_AcqGetGain(RP_CH_1, &gain);
+    rp_calib_params_t calib = rp_GetCalibrationSettings();
+    int dc_offs = gain == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
+
+    /* both paths must agree for every wrap position */
+    for (uint32_t pos = 0; pos < ADC_BUFFER_SIZE; pos += 1021) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataRaw(RP_CH_1, pos, &size, out);
+        scalar_raw(raw, pos, ADC_BUFFER_SIZE, ref, dc_offs);
+        if (memcmp(ref, out, sizeof(out)) != 0) {
+            fprintf(stderr, "mismatch at position %u\n", pos);
+            return EXIT_FAILURE;
+        }
+    }
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        scalar_raw(raw, i * 97, ADC_BUFFER_SIZE, ref, dc_offs);
+    }
+    bench_report("scalar wrap/mask/calibrate", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataRaw(RP_CH_1, i * 97, &size, out);
+    }
+    bench_report("rp_AcqGetDataRaw", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    rp_Release();
+    return 0;
+}
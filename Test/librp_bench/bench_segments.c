@@ -0,0 +1,152 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library segmented capture benchmark
+ *
+ * A pulse train of decreasing period is fed into channel A of the simulated
+ * backend, which a second thread advances in real time at decimation 64. For
+ * every period rp_AcqCaptureSegments() captures a batch of segments on the
+ * rising edges; the trigger positions are checked against the pulses and the
+ * missed pulses are counted. The highest pulse rate captured without a miss
+ * is the sustained trigger rate. Runs on the simulated backend only.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define SEGMENTS    200
+#define PRE         64
+#define POST        192
+#define SAMPLE_RATE (125e6 / 64)
+#define STEP_MAX    16
+#define TIMEOUT_NS  2000000000ULL
+
+static volatile bool running = true;
+static volatile uint32_t period = 0;
+
+/* Channel A: pulses of a quarter period; channel B: the same, inverted */
+static void pulse_source(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx)
+{
+    uint32_t p = period;
+    for (uint32_t i = 0; i < size; ++i) {
+        int16_t v = (sample + i) % p < p / 4 ? 4000 : -4000;
+        buffer[i] = channel == RP_CH_1 ? v : -v;
+    }
+}
+
+/* Advances the model at the sampling rate of decimation 64 */
+static void *stepper(void *arg)
+{
+    uint64_t start = bench_now_ns();
+    uint64_t produced = 0;
+
+    while (running) {
+        uint64_t target = (bench_now_ns() - start) * SAMPLE_RATE / 1e9;
+        if (target > produced) {
+            uint32_t n = target - produced > STEP_MAX ? STEP_MAX : target - produced;
+            rp_SimStep(n);
+            produced += n;
+        }
+        /* on a single core the capture loop must get the CPU between steps */
+        sched_yield();
+    }
+    return NULL;
+}
+
+/* Captures one batch; returns the number of missed pulses or -1 on error */
+static int64_t run(rp_acq_seg_source_t source, uint32_t p)
+{
+    static int16_t buf1[SEGMENTS * (PRE + POST)], buf2[SEGMENTS * (PRE + POST)];
+    static rp_acq_segment_t segments[SEGMENTS];
+    rp_acq_seg_config_t config = {
+        .source = source,
+        .trigger_source = RP_TRIG_SRC_CHA_PE,
+        .pre_samples = PRE,
+        .post_samples = POST,
+        .segments = SEGMENTS
+    };
+    uint32_t count;
+    int64_t missed = 0;
+
+    period = p;
+    int ret = rp_AcqCaptureSegments(&config, TIMEOUT_NS, buf1, buf2, segments, &count);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_AcqCaptureSegments() failed: %s (%u segments)\n", rp_GetError(ret), count);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const int16_t *s1 = &buf1[i * (PRE + POST)];
+        const int16_t *s2 = &buf2[i * (PRE + POST)];
+        /* the trigger sample is the first one of a pulse */
+        if (!segments[i].valid || s1[PRE - 1] >= 0 || s1[PRE] <= 0 || s2[PRE] >= 0) {
+            fprintf(stderr, "segment %u is not aligned to the trigger\n", i);
+            return -1;
+        }
+        if (i > 0) {
+            uint64_t gap = segments[i].trig_sample - segments[i - 1].trig_sample;
+            if (gap % p != 0) {
+                fprintf(stderr, "segment %u: trigger %llu samples after the previous one\n", i, (unsigned long long) gap);
+                return -1;
+            }
+            missed += gap / p - 1;
+        }
+    }
+
+    uint64_t span = segments[count - 1].timestamp_ns - segments[0].timestamp_ns;
+    printf("%-6s pulse rate %8.1f kHz   captured %3u   missed %5lld   capture rate %8.1f kHz\n",
+           source == RP_SEG_SRC_BUFFER ? "buffer" : "DDR", SAMPLE_RATE / p / 1e3, count,
+           (long long) missed, (count - 1) / (span / 1e9) / 1e3);
+    return missed;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thread;
+    double sustained[2] = { 0, 0 };
+
+    bench_init();
+    if (rp_SimStep(0) != RP_OK) {
+        fprintf(stderr, "bench_segments needs the simulated backend (RP_BACKEND=sim)\n");
+        return EXIT_FAILURE;
+    }
+
+    period = 4096;
+    rp_SimSetSignalSource(pulse_source, NULL);
+    rp_AcqSetDecimation(RP_DEC_64);
+    rp_AcqSetTriggerLevel(0);
+    pthread_create(&thread, NULL, stepper, NULL);
+
+    for (int s = 0; s < 2; ++s) {
+        rp_acq_seg_source_t source = s == 0 ? RP_SEG_SRC_BUFFER : RP_SEG_SRC_DDR;
+        for (uint32_t p = 4096; p >= 8; p /= 2) {
+            int64_t missed = run(source, p);
+            if (missed < 0) {
+                running = false;
+                pthread_join(thread, NULL);
+                return EXIT_FAILURE;
+            }
+            if (missed == 0) {
+                sustained[s] = SAMPLE_RATE / p;
+            }
+        }
+    }
+
+    running = false;
+    pthread_join(thread, NULL);
+
+    printf("sustained trigger rate: buffer %.1f kHz, DDR %.1f kHz\n", sustained[0] / 1e3, sustained[1] / 1e3);
+    rp_Release();
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library spectrum pipeline benchmark
+ *
+ * Runs the spectrum processing of two 16k sample channels with the double
+ * precision functions (rp_spectr_hann_filter(), two real FFTs in
+ * rp_spectr_fft(), rp_spectr_decimate()) and with the single precision
+ * pipeline (rp_spectr_fft_power_f(), which transforms both channels in one
+ * complex FFT, and rp_spectr_decimate_f()). Each pipeline is timed as the
+ * best of several runs. The power of the bins within 80 dB and 100 dB of the
+ * channel peak is compared between the two, in dB.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "bench.h"
+#include "spec_dsp.h"
+
+#define LEN         (16 * 1024)
+#define BINS        (LEN / 2)
+#define OUT_LEN     SPECTR_OUT_SIG_LEN
+#define ITERATIONS  20
+#define RUNS        10
+
+static double in_a[LEN], in_b[LEN], win_a[LEN], win_b[LEN], mag_a[BINS], mag_b[BINS];
+static float in_af[LEN], in_bf[LEN], pow_a[BINS], pow_b[BINS], out_a[OUT_LEN], out_b[OUT_LEN];
+
+/* Largest difference in dB of the bins within depth_db of the peak */
+static double compare(const double *mag, const float *power, double depth_db)
+{
+    double peak = 0, max = 0;
+    for (int i = 0; i < BINS; ++i) {
+        peak = fmax(peak, mag[i] * mag[i]);
+    }
+    for (int i = 0; i < BINS; ++i) {
+        if (mag[i] * mag[i] > peak * pow(10, -depth_db / 10)) {
+            max = fmax(max, fabs(10 * log10(power[i] / (mag[i] * mag[i]))));
+        }
+    }
+    return max;
+}
+
+int main(int argc, char **argv)
+{
+    // A tone between two bins on channel A, two tones on channel B, both with ADC noise
+    uint32_t lfsr = 1;
+    for (int i = 0; i < LEN; ++i) {
+        double noise[2];
+        for (int c = 0; c < 2; ++c) {
+            lfsr = lfsr * 1664525u + 1013904223u;
+            noise[c] = (lfsr >> 8) / 16777216.0 * 4 - 2;
+        }
+        in_a[i] = round(4000 * sin(2 * M_PI * 1000.3 * i / LEN) + noise[0]);
+        in_b[i] = round(2000 * sin(2 * M_PI * 123.0 * i / LEN) + 100 * cos(2 * M_PI * 5000.7 * i / LEN) + noise[1]);
+        in_af[i] = in_a[i];
+        in_bf[i] = in_b[i];
+    }
+
+    double *wa = win_a, *wb = win_b, *ma = mag_a, *mb = mag_b;
+    float *oa = out_a, *ob = out_b;
+    rp_spectr_hann_init();
+    rp_spectr_fft_init();
+
+    uint64_t elapsed;
+    BEST_OF(elapsed,
+            rp_spectr_hann_filter(in_a, in_b, &wa, &wb);
+            rp_spectr_fft(wa, wb, &ma, &mb);
+            rp_spectr_decimate(ma, mb, &oa, &ob, BINS, OUT_LEN));
+    bench_report("double: hann + 2x fftr + decimate", elapsed, ITERATIONS, 2 * LEN);
+
+    BEST_OF(elapsed,
+            rp_spectr_hann_filter(in_a, in_b, &wa, &wb);
+            rp_spectr_fft(wa, wb, &ma, &mb));
+    bench_report("double: hann + 2x fftr + magnitude", elapsed, ITERATIONS, 2 * LEN);
+
+    // The first call creates the plan
+    uint64_t start = bench_now_ns();
+    rp_spectr_fft_power_f(in_af, in_bf, pow_a, pow_b, LEN);
+    printf("%-40s %12.1f us\n", "float: first call, plan created", (bench_now_ns() - start) / 1e3);
+
+    BEST_OF(elapsed,
+            rp_spectr_fft_power_f(in_af, in_bf, pow_a, pow_b, LEN);
+            rp_spectr_decimate_f(pow_a, pow_b, out_a, out_b, BINS, OUT_LEN));
+    bench_report("float: fft_power_f + decimate_f", elapsed, ITERATIONS, 2 * LEN);
+
+    BEST_OF(elapsed, rp_spectr_fft_power_f(in_af, in_bf, pow_a, pow_b, LEN));
+    bench_report("float: window + 1x complex fft + power", elapsed, ITERATIONS, 2 * LEN);
+
+    // Both pipelines leave the spectrum of the same input behind
+    bool ok = true;
+    for (int i = 0; i < 2; ++i) {
+        double depth = i == 0 ? 80 : 100, limit = i == 0 ? 0.001 : 0.1;
+        double err_a = compare(mag_a, pow_a, depth), err_b = compare(mag_b, pow_b, depth);
+        printf("largest difference to double within %3.0f dB of the peak: A %.5f dB, B %.5f dB\n", depth, err_a, err_b);
+        ok &= err_a < limit && err_b < limit;
+    }
+
+    rp_spectr_fft_f_clean();
+    rp_spectr_fft_clean();
+    rp_spectr_hann_clean();
+    return ok ? 0 : EXIT_FAILURE;
+}
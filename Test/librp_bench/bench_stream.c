@@ -0,0 +1,119 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming acquisition benchmark
+ *
+ * Streams both channels through rp_StreamRead() with several reader threads
+ * and reports the sustained throughput and the overrun counters. On the
+ * simulated backend a ramp is recorded and every block is checked for gaps.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define BLOCK_SIZE  16384
+#define RING_BLOCKS 16
+#define READERS     3
+#define DURATION_NS 2000000000ULL
+
+static volatile bool running = true;
+static bool sim = false;
+static uint64_t blocks_read[READERS];
+static uint64_t errors = 0;
+
+/* Ramp over the 14 bit range, so the content of every block is predictable */
+static void ramp_source(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        buffer[i] = (int16_t)(((sample + i) & 0x3FFF) - 0x2000);
+    }
+}
+
+static void *reader(void *arg)
+{
+    static int16_t buf[READERS][2][BLOCK_SIZE];
+    int id = (int)(intptr_t) arg;
+    rp_stream_block_t block;
+
+    while (running) {
+        if (rp_StreamRead(&block, buf[id][0], buf[id][1], 100000) != RP_OK) {
+            continue;
+        }
+        blocks_read[id]++;
+        if (!sim) {
+            continue;
+        }
+        for (uint32_t i = 1; i < block.size; ++i) {
+            if (((buf[id][0][i] - buf[id][0][i - 1]) & 0x3FFF) != 1 || buf[id][1][i] != buf[id][0][i]) {
+                __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[READERS];
+    rp_stream_config_t config = { .block_size = BLOCK_SIZE, .ring_blocks = RING_BLOCKS };
+    rp_stream_stats_t stats;
+
+    bench_init();
+    sim = rp_SimStep(0) == RP_OK;
+    if (sim) {
+        rp_SimSetSignalSource(ramp_source, NULL);
+    }
+
+    int ret = rp_StreamStart(&config);
+    if (ret != RP_OK) {
+        fprintf(stderr, "rp_StreamStart() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < READERS; ++i) {
+        pthread_create(&threads[i], NULL, reader, (void *)(intptr_t) i);
+    }
+
+    uint64_t start = bench_now_ns();
+    while (bench_now_ns() - start < DURATION_NS) {
+        if (sim) {
+            rp_SimStep(BLOCK_SIZE);
+        }
+        else {
+            struct timespec ts = { 0, 1000000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    running = false;
+    for (int i = 0; i < READERS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    rp_StreamGetStats(&stats);
+    rp_StreamStop();
+
+    uint64_t total = 0;
+    for (int i = 0; i < READERS; ++i) {
+        total += blocks_read[i];
+    }
+    bench_report("rp_StreamRead (both channels)", elapsed, total ? total : 1, 2 * BLOCK_SIZE);
+    printf("produced %llu consumed %llu ring overruns %llu dma overruns %llu corrupted blocks %llu\n",
+           (unsigned long long) stats.produced, (unsigned long long) stats.consumed,
+           (unsigned long long) stats.ring_overruns, (unsigned long long) stats.dma_overruns,
+           (unsigned long long) errors);
+
+    rp_Release();
+    return errors ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library generator sweep benchmark
+ *
+ * Sweeps the frequency and amplitude of channel 1 twice: from user code with
+ * rp_GenFreq(), rp_GenAmp() and usleep() between the steps, as the Bode
+ * tools do, and with rp_GenSweepStart(). For every step the time it was
+ * applied at is compared with the ideal schedule; the mean and maximum error
+ * and the overrun of the whole sweep are reported.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define STEPS       200
+#define DWELL_NS    1000000ULL
+#define START_FREQ  1000.0
+#define STOP_FREQ   1000000.0
+
+static uint64_t applied_ns[STEPS];
+
+static void on_step(const rp_gen_sweep_step_t *step, void *ctx)
+{
+    applied_ns[step->index] = step->timestamp_ns;
+}
+
+static void report(const char *name, uint64_t start, uint64_t end)
+{
+    double sum = 0, max = 0;
+    for (int i = 0; i < STEPS; ++i) {
+        double err = fabs((double) applied_ns[i] - (double)(start + i * DWELL_NS));
+        sum += err;
+        max = err > max ? err : max;
+    }
+    printf("%-28s step error mean %8.1f us max %8.1f us   sweep overrun %8.1f us\n", name,
+           sum / STEPS / 1e3, max / 1e3, ((double) end - start - STEPS * DWELL_NS) / 1e3);
+}
+
+int main(int argc, char **argv)
+{
+    bench_init();
+
+    /* user code loop */
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < STEPS; ++i) {
+        double t = (double) i / (STEPS - 1);
+        rp_GenFreq(RP_CH_1, START_FREQ * pow(STOP_FREQ / START_FREQ, t));
+        rp_GenAmp(RP_CH_1, 0.2 + 0.6 * t);
+        applied_ns[i] = bench_now_ns();
+        usleep(DWELL_NS / 1000);
+    }
+    report("rp_GenFreq + usleep loop", start, bench_now_ns());
+
+    /* sweep engine, waiting on its event descriptor */
+    rp_gen_sweep_config_t config = {
+        .channel = RP_CH_1,
+        .mode = RP_GEN_SWEEP_LOG,
+        .steps = STEPS,
+        .start_freq = START_FREQ,
+        .stop_freq = STOP_FREQ,
+        .start_amp = 0.2,
+        .stop_amp = 0.8,
+        .dwell_ns = DWELL_NS
+    };
+    int fd, ret;
+    bool running = true;
+    uint64_t events = 0;
+
+    start = bench_now_ns();
+    if ((ret = rp_GenSweepStart(&config, on_step, NULL)) != RP_OK) {
+        fprintf(stderr, "rp_GenSweepStart() failed: %s\n", rp_GetError(ret));
+        return EXIT_FAILURE;
+    }
+    rp_GenSweepGetEventFd(&fd);
+    while (running) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        uint64_t count;
+        if (poll(&pfd, 1, 1) > 0 && read(fd, &count, sizeof(count)) == sizeof(count)) {
+            events += count;
+        }
+        rp_GenSweepIsRunning(&running);
+    }
+    uint64_t end = bench_now_ns();
+    rp_GenSweepStop();
+    report("rp_GenSweepStart", applied_ns[0], end);
+
+    float freq;
+    rp_GenGetFreq(RP_CH_1, &freq);
+    printf("steps signalled %llu, final frequency %.0f Hz\n", (unsigned long long) events, freq);
+
+    rp_Release();
+    return events == STEPS ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,170 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library trigger wait benchmark
+ *
+ * A second thread raises a trigger after a varying delay, the main thread
+ * waits for it. For every wait strategy the wall time from the trigger to the
+ * wake-up and the CPU time the waiter spent are reported: the former polling
+ * loops with usleep(1000) and without any sleep, and rp_AcqWaitTrigger() with
+ * the adaptive poller and with the trigger interrupt. Runs on the simulated
+ * backend only, which provides the trigger and its interrupt.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define ROUNDS      200
+#define TIMEOUT_NS  1000000000ULL
+
+typedef enum {
+    WAIT_USLEEP,
+    WAIT_SPIN,
+    WAIT_LIBRP
+} wait_mode_t;
+
+static volatile uint32_t armed_round = 0;
+static volatile uint32_t stepped_round = 0;
+static volatile uint64_t trigger_ns = 0;
+static volatile bool running = true;
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Raises the trigger of every armed round 0.2 to 5 ms after arming */
+static void *stepper(void *arg)
+{
+    struct timespec idle = { 0, 20000 };
+    uint32_t round = 1;
+
+    while (running) {
+        if (armed_round != round) {
+            nanosleep(&idle, NULL);
+            continue;
+        }
+        struct timespec gap = { 0, 200000 + (round * 7919) % 4800000 };
+        nanosleep(&gap, NULL);
+
+        trigger_ns = bench_now_ns();
+        rp_SimStep(16);
+        __atomic_store_n(&stepped_round, round, __ATOMIC_RELEASE);
+        round++;
+    }
+    return NULL;
+}
+
+static int wait_trigger(wait_mode_t mode)
+{
+    rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+
+    switch (mode) {
+    case WAIT_USLEEP:
+        while (state != RP_TRIG_STATE_TRIGGERED) {
+            usleep(1000);
+            rp_AcqGetTriggerState(&state);
+        }
+        return RP_OK;
+    case WAIT_SPIN:
+        while (state != RP_TRIG_STATE_TRIGGERED) {
+            rp_AcqGetTriggerState(&state);
+        }
+        return RP_OK;
+    default:
+        return rp_AcqWaitTrigger(TIMEOUT_NS, NULL);
+    }
+}
+
+static int run(const char *name, wait_mode_t mode)
+{
+    pthread_t thread;
+    uint64_t latency_sum = 0, latency_max = 0, cpu = 0, wall = 0;
+    struct timespec idle = { 0, 20000 };
+
+    armed_round = 0;
+    stepped_round = 0;
+    running = true;
+    pthread_create(&thread, NULL, stepper, NULL);
+
+    /* long trigger delay keeps the trigger state set after the trigger */
+    rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE);
+
+    for (uint32_t round = 1; round <= ROUNDS; ++round) {
+        /* the model applies stop and arm on the next step, as the FPGA does on the next clock */
+        rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED);
+        rp_AcqStop();
+        rp_SimStep(1);
+        rp_AcqStart();
+        rp_SimStep(1);
+        rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+        armed_round = round;
+
+        uint64_t cpu_start = thread_cpu_ns();
+        uint64_t wall_start = bench_now_ns();
+        int ret = wait_trigger(mode);
+        uint64_t wake = bench_now_ns();
+        cpu += thread_cpu_ns() - cpu_start;
+        wall += wake - wall_start;
+
+        if (ret != RP_OK) {
+            fprintf(stderr, "%s: wait failed: %s\n", name, rp_GetError(ret));
+            running = false;
+            pthread_join(thread, NULL);
+            return ret;
+        }
+        while (__atomic_load_n(&stepped_round, __ATOMIC_ACQUIRE) != round) {
+            nanosleep(&idle, NULL);
+        }
+
+        uint64_t latency = wake > trigger_ns ? wake - trigger_ns : 0;
+        latency_sum += latency;
+        latency_max = latency > latency_max ? latency : latency_max;
+    }
+
+    running = false;
+    pthread_join(thread, NULL);
+
+    printf("%-34s latency mean %8.1f us max %8.1f us   CPU %5.1f %%\n", name,
+           latency_sum / 1e3 / ROUNDS, latency_max / 1e3, 100.0 * cpu / wall);
+    return RP_OK;
+}
+
+int main(int argc, char **argv)
+{
+    bench_init();
+    if (rp_SimStep(0) != RP_OK) {
+        fprintf(stderr, "bench_trigger needs the simulated backend (RP_BACKEND=sim)\n");
+        return EXIT_FAILURE;
+    }
+
+    if (run("poll with usleep(1000)", WAIT_USLEEP) != RP_OK ||
+        run("poll without sleep", WAIT_SPIN) != RP_OK ||
+        run("rp_AcqWaitTrigger (interrupt)", WAIT_LIBRP) != RP_OK) {
+        return EXIT_FAILURE;
+    }
+
+    /* without the interrupt rp_AcqWaitTrigger() falls back to polling */
+    rp_Release();
+    rp_SimSetTriggerIrq(false);
+    bench_init();
+    if (run("rp_AcqWaitTrigger (adaptive poll)", WAIT_LIBRP) != RP_OK) {
+        return EXIT_FAILURE;
+    }
+
+    rp_Release();
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library count to voltage conversion benchmark
+ *
+ * Compares rp_AcqGetDataV() and rp_AcqGetDataV2(), which look the voltage up
+ * in per channel and gain tables, with the former per-sample conversion
+ * through rp_CmnCnvCntToV(). The first call includes building the table.
+ * rp_AcqGetDataV2Scratch() is checked and timed with a small scratch buffer.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include "bench.h"
+
+#define ITERATIONS 200
+#define ADC_BITS   14
+
+int main(int argc, char **argv)
+{
+    static uint16_t raw1[ADC_BUFFER_SIZE], raw2[ADC_BUFFER_SIZE];
+    static float ref[ADC_BUFFER_SIZE], volts1[ADC_BUFFER_SIZE], volts2[ADC_BUFFER_SIZE];
+    uint32_t size;
+    uint64_t start;
+
+    bench_init();
+
+    size = ADC_BUFFER_SIZE;
+    rp_AcqGetDataRawV2(0, &size, raw1, raw2);
+
+    rp_pinState_t gain;
+    rp_AcqGetGain(RP_CH_1, &gain);
+    rp_calib_params_t calib = rp_GetCalibrationSettings();
+    float gainV = gain == RP_HIGH ? 20.0 : 1.0;
+    int dc_offs = gain == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
+    uint32_t calibScale = gain == RP_HIGH ? calib.fe_ch1_fs_g_hi : calib.fe_ch1_fs_g_lo;
+
+    start = bench_now_ns();
+    size = ADC_BUFFER_SIZE;
+    rp_AcqGetDataV(RP_CH_1, 0, &size, volts1);
+    bench_report("rp_AcqGetDataV (first call)", bench_now_ns() - start, 1, ADC_BUFFER_SIZE);
+
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        ref[i] = rp_CmnCnvCntToV(ADC_BITS, raw1[i], gainV, calibScale, dc_offs, 0.0);
+        if (ref[i] != volts1[i]) {
+            fprintf(stderr, "mismatch at sample %u: %f != %f\n", i, ref[i], volts1[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        for (uint32_t j = 0; j < ADC_BUFFER_SIZE; ++j) {
+            ref[j] = rp_CmnCnvCntToV(ADC_BITS, raw1[(i + j) % ADC_BUFFER_SIZE], gainV, calibScale, dc_offs, 0.0);
+        }
+    }
+    bench_report("per-sample rp_CmnCnvCntToV", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataV(RP_CH_1, i, &size, volts1);
+    }
+    bench_report("rp_AcqGetDataV", bench_now_ns() - start, ITERATIONS, ADC_BUFFER_SIZE);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataV2(i, &size, volts1, volts2);
+    }
+    bench_report("rp_AcqGetDataV2 (both channels)", bench_now_ns() - start, ITERATIONS, 2 * ADC_BUFFER_SIZE);
+
+    /* fixed footprint variant with a small scratch must give the same result */
+    static float check1[ADC_BUFFER_SIZE], check2[ADC_BUFFER_SIZE];
+    uint32_t scratch[64];
+    size = ADC_BUFFER_SIZE;
+    rp_AcqGetDataV2Scratch(ITERATIONS - 1, &size, check1, check2, scratch, sizeof(scratch));
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        if (check1[i] != volts1[i] || check2[i] != volts2[i]) {
+            fprintf(stderr, "scratch read-out mismatch at sample %u\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        size = ADC_BUFFER_SIZE;
+        rp_AcqGetDataV2Scratch(i, &size, volts1, volts2, scratch, sizeof(scratch));
+    }
+    bench_report("rp_AcqGetDataV2Scratch (256 B scratch)", bench_now_ns() - start, ITERATIONS, 2 * ADC_BUFFER_SIZE);
+
+    rp_Release();
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library spectrum averaging benchmark
+ *
+ * Times rp_FftAvgAdd() per frame of the 2048 bins the spectrum application
+ * shows, in every averaging mode, and rp_FftWelch() over a 1M sample deep
+ * memory capture with 16k segments overlapping by half. On white noise the
+ * Welch estimate must keep the level of a single periodogram while the spread
+ * of its bins in dB shrinks roughly with the square root of the segments.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define BINS        2048
+#define FRAMES      100
+#define CAPTURE     (1024 * 1024)
+#define SEG_LEN     (16 * 1024)
+#define OVERLAP     (SEG_LEN / 2)
+#define RUNS        5
+
+static float capture[CAPTURE];
+static float frames[FRAMES][BINS], acc[BINS];
+static float power[SEG_LEN / 2 + 1], single[SEG_LEN / 2 + 1];
+
+/* Mean and standard deviation in dB of the bins, without DC and Nyquist */
+static void stats_db(const float *p, uint32_t bins, double *mean, double *std)
+{
+    double s = 0, s2 = 0;
+    for (uint32_t k = 1; k < bins - 1; ++k) {
+        double db = 10 * log10(p[k]);
+        s += db;
+        s2 += db * db;
+    }
+    *mean = s / (bins - 2);
+    *std = sqrt(s2 / (bins - 2) - *mean * *mean);
+}
+
+static bool avg_run(const char *name, rp_fft_avg_mode_t mode)
+{
+    rp_fft_avg_t avg = { mode, FRAMES, 0 };
+    uint64_t elapsed = UINT64_MAX;
+
+    for (int r = 0; r < RUNS; ++r) {
+        avg.frames = 0;
+        uint64_t start = bench_now_ns();
+        for (int f = 0; f < FRAMES; ++f) {
+            rp_FftAvgAdd(&avg, acc, frames[f], BINS);
+        }
+        uint64_t time = bench_now_ns() - start;
+        elapsed = time < elapsed ? time : elapsed;
+    }
+    bench_report(name, elapsed, FRAMES, BINS);
+
+    // Compare with the direct computation over all frames
+    double err = 0;
+    for (int k = 0; k < BINS; ++k) {
+        double ref = mode == RP_FFT_AVG_PEAK ? -INFINITY : mode == RP_FFT_AVG_MIN ? INFINITY : 0;
+        for (int f = 0; f < FRAMES; ++f) {
+            if (mode == RP_FFT_AVG_PEAK) {
+                ref = fmax(ref, frames[f][k]);
+            } else if (mode == RP_FFT_AVG_MIN) {
+                ref = fmin(ref, frames[f][k]);
+            } else {
+                ref += frames[f][k] / (double)FRAMES;
+            }
+        }
+        err = fmax(err, fabs(acc[k] - ref) / ref);
+    }
+    printf("%-40s %12.2e relative\n", "  largest error", err);
+    return err < 1e-5;
+}
+
+int main(int argc, char **argv)
+{
+    // Uniform white noise with variance 1/3
+    uint32_t lfsr = 1;
+    for (int i = 0; i < CAPTURE; ++i) {
+        lfsr = lfsr * 1664525u + 1013904223u;
+        capture[i] = (lfsr >> 8) / 8388608.0f - 1;
+    }
+    for (int f = 0; f < FRAMES; ++f) {
+        for (int k = 0; k < BINS; ++k) {
+            lfsr = lfsr * 1664525u + 1013904223u;
+            frames[f][k] = 1e-9f * (1 + (lfsr >> 8) / 16777216.0f);
+        }
+    }
+
+    bool ok = true;
+    ok &= avg_run("rp_FftAvgAdd linear", RP_FFT_AVG_LINEAR);
+    ok &= avg_run("rp_FftAvgAdd exponential", RP_FFT_AVG_EXP);
+    ok &= avg_run("rp_FftAvgAdd peak", RP_FFT_AVG_PEAK);
+    ok &= avg_run("rp_FftAvgAdd min", RP_FFT_AVG_MIN);
+
+    // A linear average holds after count frames
+    rp_fft_avg_t avg = { RP_FFT_AVG_LINEAR, FRAMES, FRAMES };
+    float held = acc[0];
+    rp_FftAvgAdd(&avg, acc, frames[0], BINS);
+    ok &= acc[0] == held && avg.frames == FRAMES;
+
+    uint32_t segments = (CAPTURE - SEG_LEN) / (SEG_LEN - OVERLAP) + 1;
+    uint64_t elapsed = UINT64_MAX;
+    for (int r = 0; r < RUNS; ++r) {
+        uint64_t start = bench_now_ns();
+        ok &= rp_FftWelch(capture, CAPTURE, SEG_LEN, OVERLAP, power) == RP_OK;
+        uint64_t time = bench_now_ns() - start;
+        elapsed = time < elapsed ? time : elapsed;
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "rp_FftWelch %u x %u", segments, SEG_LEN);
+    bench_report(label, elapsed, 1, CAPTURE);
+
+    // One segment is a single Hann windowed periodogram
+    ok &= rp_FftWelch(capture, SEG_LEN, SEG_LEN, 0, single) == RP_OK;
+    double mean1, std1, mean, std;
+    stats_db(single, SEG_LEN / 2 + 1, &mean1, &std1);
+    stats_db(power, SEG_LEN / 2 + 1, &mean, &std);
+    // Expected level: variance times the sum of the squared window, 3/8 N for Hann
+    double level = 10 * log10(1.0 / 3 * 3.0 / 8 * SEG_LEN);
+    printf("%-40s %8.2f dB mean %6.2f dB std\n", "  single periodogram", mean1, std1);
+    printf("%-40s %8.2f dB mean %6.2f dB std, %.1f x lower\n", "  Welch", mean, std, std1 / std);
+    // Log of the exponential distribution is 2.5 dB low; averaging removes the bias
+    printf("%-40s %8.2f dB\n", "  expected level", level);
+    ok &= fabs(mean - level) < 0.1;
+    ok &= std1 / std > sqrt(segments) / 2;
+
+    ok &= rp_FftWelch(capture, SEG_LEN - 1, SEG_LEN, OVERLAP, power) == RP_EIPV;
+    ok &= rp_FftWelch(capture, CAPTURE, SEG_LEN, SEG_LEN, power) == RP_EIPV;
+    rp_FftCleanup();
+    printf("results %s\n", ok ? "match the reference" : "DO NOT match the reference");
+    return ok ? 0 : EXIT_FAILURE;
+}
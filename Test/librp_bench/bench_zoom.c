@@ -0,0 +1,147 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library zoom FFT benchmark
+ *
+ * Resolves the band around a carrier with rp_FftZoom() and, by brute force,
+ * with one Hann windowed real FFT of the whole decimation * fft_len samples,
+ * which has the same bins. The capture holds a tone on a bin, a tone between
+ * two bins, noise and a strong tone outside the zoomed span. The levels of
+ * the tones and of the noise floor in the middle 80 % of the zoomed span must
+ * match the long FFT, and the outside tone must not alias into it.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "bench.h"
+
+#define FFT_LEN     4096
+#define MAX_DEC     256
+#define CAPTURE     (MAX_DEC * (FFT_LEN + 33))
+#define RUNS        5
+
+static float capture[CAPTURE];
+static float zoom[FFT_LEN], full[MAX_DEC * FFT_LEN / 2 + 1];
+
+/* Mean power in dB of the bins from..to of the zoomed span, without the tones */
+static double floor_db(const float *p, int from, int to, const int *tones, int ntones)
+{
+    double sum = 0;
+    int n = 0;
+    for (int j = from; j < to; ++j) {
+        bool near = false;
+        for (int t = 0; t < ntones; ++t) {
+            near |= abs(j - tones[t]) < 8;
+        }
+        if (!near) {
+            sum += p[j];
+            n++;
+        }
+    }
+    return 10 * log10(sum / n);
+}
+
+/* Largest power in dB of the bins around j */
+static double peak_db(const float *p, int j)
+{
+    float m = 0;
+    for (int k = j - 2; k <= j + 2; ++k) {
+        m = p[k] > m ? p[k] : m;
+    }
+    return 10 * log10(m);
+}
+
+static uint64_t best_of(int (*run)(uint32_t), uint32_t dec)
+{
+    uint64_t elapsed = UINT64_MAX;
+    for (int r = 0; r < RUNS; ++r) {
+        uint64_t start = bench_now_ns();
+        if (run(dec) != RP_OK) {
+            return 0;
+        }
+        uint64_t time = bench_now_ns() - start;
+        elapsed = time < elapsed ? time : elapsed;
+    }
+    return elapsed;
+}
+
+/* Carrier at bin CARRIER of the long FFT */
+#define CARRIER(dec)    (dec * FFT_LEN / 8 + 12345 % (dec * FFT_LEN / 4))
+
+static int run_zoom(uint32_t dec)
+{
+    float center = CARRIER(dec) / (float)(dec * FFT_LEN);
+    return rp_FftZoom(capture, CAPTURE, center, dec, FFT_LEN, zoom);
+}
+
+static int run_full(uint32_t dec)
+{
+    return rp_FftWelch(capture, dec * FFT_LEN, dec * FFT_LEN, 0, full);
+}
+
+static bool run(uint32_t dec)
+{
+    const uint32_t n = dec * FFT_LEN, carrier = CARRIER(dec);
+    char label[64];
+
+    // Tones at +100 and -300.5 bins of the carrier, noise, a 40 dB
+    // stronger tone 0.75 decimated sample rates above the carrier, whose alias
+    // would land 0.25 decimated sample rates below it
+    uint32_t lfsr = 1;
+    for (uint32_t i = 0; i < CAPTURE; ++i) {
+        lfsr = lfsr * 1664525u + 1013904223u;
+        capture[i] = sin(2 * M_PI * (carrier + 100.0) / n * i)
+                   + sin(2 * M_PI * (carrier - 300.5) / n * i)
+                   + 100 * sin(2 * M_PI * (carrier + 0.75 * FFT_LEN) / n * i)
+                   + 0.1 * ((lfsr >> 8) / 8388608.0 - 1);
+    }
+
+    uint64_t t_zoom = best_of(run_zoom, dec);
+    uint64_t t_full = best_of(run_full, dec);
+    if (t_zoom == 0 || t_full == 0) {
+        fprintf(stderr, "rp_FftZoom() or rp_FftWelch() failed\n");
+        return false;
+    }
+    snprintf(label, sizeof(label), "rp_FftZoom %u x %u", dec, FFT_LEN);
+    bench_report(label, t_zoom, 1, n);
+    snprintf(label, sizeof(label), "real FFT %u", n);
+    bench_report(label, t_full, 1, n);
+    printf("%-40s %12.1f x faster\n", "  zoom", (double)t_full / t_zoom);
+
+    // Zoom bin j is bin carrier + j - FFT_LEN/2 of the long FFT
+    const int half = FFT_LEN / 2, off = (int)carrier - half;
+    const int tones[] = { half + 100, half - 300, half - FFT_LEN / 4 };
+    double e1 = peak_db(zoom, tones[0]) - peak_db(full + off, tones[0]);
+    double e2 = peak_db(zoom, tones[1]) - peak_db(full + off, tones[1]);
+    double fz = floor_db(zoom, FFT_LEN / 10, FFT_LEN * 9 / 10, tones, 3);
+    double ff = floor_db(full + off, FFT_LEN / 10, FFT_LEN * 9 / 10, tones, 3);
+    double alias = 10 * log10(full[carrier + 3 * FFT_LEN / 4]) - peak_db(zoom, tones[2]);
+    printf("%-40s %+8.3f dB on a bin, %+8.3f dB between bins\n", "  tone level", e1, e2);
+    printf("%-40s %+8.3f dB, %.1f dB below the tones\n", "  noise floor", fz - ff,
+           peak_db(full + off, tones[0]) - ff);
+    printf("%-40s %8.1f dB\n", "  alias rejection", alias);
+    return fabs(e1) < 0.05 && fabs(e2) < 0.05 && fabs(fz - ff) < 0.5 && alias > 74;
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = true;
+    ok &= run(16);
+    ok &= run(MAX_DEC);
+
+    ok &= rp_FftZoom(capture, CAPTURE, 0.1, 6, FFT_LEN, zoom) == RP_EIPV;
+    ok &= rp_FftZoom(capture, 16 * FFT_LEN, 0.1, 16, FFT_LEN, zoom) == RP_EIPV;
+    ok &= rp_FftZoom(capture, CAPTURE, 0.6, 16, FFT_LEN, zoom) == RP_EIPV;
+    rp_FftCleanup();
+    printf("results %s\n", ok ? "match the reference" : "DO NOT match the reference");
+    return ok ? 0 : EXIT_FAILURE;
+}
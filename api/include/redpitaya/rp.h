@@ -24,7 +24,11 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "rp_fft.h"
+
 #define ADC_BUFFER_SIZE             (16*1024)
+/** Scratch size in bytes used by rp_AcqGetDataV2(), read-out runs in bursts of 512 samples per channel */
+#define RP_ACQ_SCRATCH_SIZE         (2*512*4)
 
 /** @name Error codes
  *  Various error codes returned by the API.
@@ -77,6 +81,8 @@ extern "C" {
 #define RP_EFRB   21
 /** Failed to write to the bus */
 #define RP_EFWB   22
+/** Timeout expired */
+#define RP_ETIM   23
 
 #define SPECTR_OUT_SIG_LEN (2*1024)
 
@@ -128,6 +134,20 @@ typedef enum {
     RP_OUT //!< Output direction
 } rp_pinDirection_t;
 
+/**
+ * Mask of digital pins: bit n stands for pin n of rp_dpin_t.
+ */
+#define RP_DPIN_MASK(pin)   (1u << (pin))
+
+/**
+ * A transition of a digital pin sequence, see rp_DpinSequenceStart().
+ */
+typedef struct {
+    uint64_t time_ns;   //!< Time from the start of the sequence
+    uint32_t mask;      //!< Pins that change, see RP_DPIN_MASK()
+    uint32_t state;     //!< New states of the pins in mask, 1 for RP_HIGH
+} rp_dpin_transition_t;
+
 /**
  * Type representing analog input output pins.
  */
@@ -142,6 +162,40 @@ typedef enum {
     RP_AIN3        //!< Analog input 3
 } rp_apin_t;
 
+/**
+ * Channels of the analog mixed signals (XADC) sampler, see rp_ApinSamplerStart().
+ */
+typedef enum {
+    RP_AMS_AIN0,        //!< Analog input 0 [V]
+    RP_AMS_AIN1,        //!< Analog input 1 [V]
+    RP_AMS_AIN2,        //!< Analog input 2 [V]
+    RP_AMS_AIN3,        //!< Analog input 3 [V]
+    RP_AMS_TEMP,        //!< FPGA die temperature [deg C]
+    RP_AMS_VCCINT,      //!< FPGA internal supply [V]
+    RP_AMS_VCCAUX,      //!< FPGA auxiliary supply [V]
+    RP_AMS_VCCBRAM,     //!< FPGA block RAM supply [V]
+    RP_AMS_CHANNELS     //!< Number of channels
+} rp_ams_channel_t;
+
+/**
+ * Statistics of one sampled channel. All values are NAN for a channel the system does not provide.
+ */
+typedef struct {
+    float value;        //!< Value of the last sweep
+    float average;      //!< Mean of the last 'window' sweeps, of all sweeps until there are as many
+    float min;          //!< Smallest value since the start or rp_ApinResetMinMax()
+    float max;          //!< Largest value since the start or rp_ApinResetMinMax()
+} rp_ams_stat_t;
+
+/**
+ * Snapshot of all sampled channels, see rp_ApinGetAll().
+ */
+typedef struct {
+    rp_ams_stat_t channel[RP_AMS_CHANNELS];    //!< Indexed by rp_ams_channel_t
+    uint64_t sweeps;                           //!< Sweeps since the sampler started
+    uint64_t timestamp_ns;                     //!< CLOCK_MONOTONIC time of the last sweep
+} rp_ams_snapshot_t;
+
 typedef enum {
     RP_WAVEFORM_SINE,       //!< Wave form sine
     RP_WAVEFORM_SQUARE,     //!< Wave form square
@@ -226,6 +280,164 @@ typedef enum {
     RP_TRIG_STATE_WAITING,   //!< Trigger is set up and waiting (to be triggered)
 } rp_acq_trig_state_t;
 
+/**
+ * Streaming acquisition parameters, see rp_StreamStart().
+ */
+typedef struct {
+    uint32_t block_size;  //!< Samples per channel in one block, a multiple of 4
+    uint32_t ring_blocks; //!< Number of blocks buffered for readers, at least 2
+} rp_stream_config_t;
+
+/**
+ * Description of a block returned by rp_StreamRead().
+ */
+typedef struct {
+    uint64_t sequence;     //!< Block number since rp_StreamStart(); gaps mean lost blocks
+    uint64_t first_sample; //!< Index of the first sample since rp_StreamStart()
+    uint32_t size;         //!< Samples per channel
+} rp_stream_block_t;
+
+/**
+ * Streaming acquisition counters.
+ */
+typedef struct {
+    uint64_t produced;      //!< Blocks copied out of the DDR buffers
+    uint64_t consumed;      //!< Blocks handed to readers
+    uint64_t ring_overruns; //!< Blocks overwritten before any reader took them
+    uint64_t dma_overruns;  //!< Times the recorders overwrote data that was not copied yet
+} rp_stream_stats_t;
+
+/**
+ * Spacing of the steps of a generator sweep.
+ */
+typedef enum {
+    RP_GEN_SWEEP_LINEAR, //!< Frequencies evenly spaced between start and stop
+    RP_GEN_SWEEP_LOG,    //!< Frequencies evenly spaced on a logarithmic scale
+    RP_GEN_SWEEP_LIST    //!< Frequencies and amplitudes taken from user lists
+} rp_gen_sweep_mode_t;
+
+/**
+ * Generator sweep parameters, see rp_GenSweepStart().
+ * In linear and log mode the amplitude moves linearly from start_amp to stop_amp.
+ */
+typedef struct {
+    rp_channel_t channel;        //!< Channel swept
+    rp_gen_sweep_mode_t mode;    //!< Spacing of the steps
+    uint32_t steps;              //!< Number of steps, including start and stop
+    double start_freq;           //!< Frequency of the first step [Hz], linear and log mode
+    double stop_freq;            //!< Frequency of the last step [Hz], linear and log mode
+    float start_amp;             //!< Amplitude of the first step [V], linear and log mode
+    float stop_amp;              //!< Amplitude of the last step [V], linear and log mode
+    const double* freq_list;     //!< Frequency of every step [Hz], list mode
+    const float* amp_list;       //!< Amplitude of every step [V], list mode
+    uint64_t dwell_ns;           //!< Time every step is held
+    double dds_accuracy;         //!< Above 0, the steps use a DDS table chosen for them, see rp_GenDdsFreq() [Hz]
+} rp_gen_sweep_config_t;
+
+/**
+ * Description of a sweep step passed to the step callback.
+ */
+typedef struct {
+    uint32_t index;        //!< Step number, from 0
+    double frequency;      //!< Frequency applied [Hz]
+    float amplitude;       //!< Amplitude applied [V]
+    uint64_t timestamp_ns; //!< CLOCK_MONOTONIC time the step was applied at
+} rp_gen_sweep_step_t;
+
+/**
+ * Called from the sweep thread right after a step is applied. It must return quickly,
+ * as the time it takes delays the following steps once it exceeds the dwell time.
+ */
+typedef void (*rp_gen_sweep_callback_t)(const rp_gen_sweep_step_t* step, void* ctx);
+
+/**
+ * Generator streaming parameters, see rp_GenStreamStart().
+ */
+typedef struct {
+    rp_channel_t channel;  //!< Channel played
+    float sample_rate;     //!< Output rate [samples/s], at most 125e6
+    uint32_t queue_size;   //!< Samples queued ahead of the AWG buffer, a power of two of at least 16384
+} rp_gen_stream_config_t;
+
+/**
+ * Generator streaming counters.
+ */
+typedef struct {
+    uint64_t played;          //!< Samples the generator pointer has passed since playback began
+    uint64_t queued;          //!< Samples waiting in the queue
+    uint64_t underruns;       //!< Half buffers refilled while the queue held less than half a buffer
+    uint64_t missing;         //!< Samples replaced by 0 V in those refills
+    uint64_t late_refills;    //!< Half buffers replayed with old samples because a refill came too late
+    float sustainable_rate;   //!< Lowest rate [samples/s] any refill so far would have kept up with
+} rp_gen_stream_stats_t;
+
+/**
+ * Stimulus-response measurement parameters, see rp_MeasureResponse().
+ */
+typedef struct {
+    int burst_count;       //!< Periods of the generator signal in the burst, 1 to 50000
+    uint32_t size;         //!< Samples captured per channel from the start of the burst, at most ADC_BUFFER_SIZE
+    uint32_t repeats;      //!< Bursts played and captured, at least 1
+    bool accumulate;       //!< Add the captures to the buffer contents instead of overwriting them
+    uint32_t timeout_us;   //!< Time to wait for each capture in microseconds
+} rp_measure_config_t;
+
+/**
+ * Memory the segments of rp_AcqCaptureSegments() are taken from.
+ */
+typedef enum {
+    RP_SEG_SRC_BUFFER, //!< ADC buffers of the oscilloscope (16k samples)
+    RP_SEG_SRC_DDR,    //!< DDR buffers written by the AXI recorders
+} rp_acq_seg_source_t;
+
+/**
+ * Segmented capture parameters, see rp_AcqCaptureSegments().
+ */
+typedef struct {
+    rp_acq_seg_source_t source;       //!< Memory the segments are taken from
+    rp_acq_trig_src_t trigger_source; //!< Trigger source re-armed after every trigger
+    uint32_t pre_samples;             //!< Samples before the trigger in every segment
+    uint32_t post_samples;            //!< Samples from the trigger on in every segment
+    uint32_t segments;                //!< Number of segments to capture
+} rp_acq_seg_config_t;
+
+/**
+ * Description of one captured segment.
+ */
+typedef struct {
+    uint64_t trig_sample;  //!< Index of the trigger sample since the start of the capture
+    uint64_t timestamp_ns; //!< Trigger time since the start of the capture, counted by the sample clock
+    uint32_t trig_pos;     //!< Write pointer at the trigger: buffer index or byte offset in the DDR buffer
+    uint32_t first_pos;    //!< Position of the first segment sample, in the same units as trig_pos
+    bool valid;            //!< False if samples were overwritten before they were copied
+} rp_acq_segment_t;
+
+/**
+ * Acquisition settings applied together by rp_AcqConfigure().
+ * Channel arrays are indexed by rp_channel_t.
+ */
+typedef struct {
+    rp_acq_decimation_t decimation; //!< Decimation
+    bool averaging;                 //!< Average samples at decimation
+    rp_pinState_t gain[2];          //!< Input gain (jumper setting)
+    float threshold[2];             //!< Trigger threshold in Volts
+    float hysteresis[2];            //!< Trigger hysteresis in Volts
+    int32_t trigger_delay;          //!< Trigger delay in decimated samples, see rp_AcqSetTriggerDelay()
+} rp_acq_config_t;
+
+/**
+ * Read-only view into the ADC buffer of one channel.
+ * The requested range is described by up to two contiguous spans; the second one
+ * is used only when the range wraps around the end of the buffer. Every word holds
+ * an uncalibrated ADC count in its lower 14 bits (two's complement).
+ */
+typedef struct {
+    const volatile uint32_t *span[2]; //!< Start of each span, NULL when unused
+    uint32_t span_size[2];            //!< Number of samples in each span
+    uint32_t trig_pos;                //!< Write pointer at trigger when the view was taken
+    uint32_t generation;              //!< Acquisition generation when the view was taken
+} rp_acq_view_t;
+
 
 /**
  * Calibration parameters, stored in the EEPROM device
@@ -246,6 +458,37 @@ typedef struct {
     int32_t  fe_ch2_hi_offs; //!< Front end DC offset, channel B
 } rp_calib_params_t;
 
+/**
+ * Type representing the backend used to access FPGA registers.
+ */
+typedef enum {
+    RP_BACKEND_DEVMEM, //!< Registers are mapped from /dev/mem (Red Pitaya board)
+    RP_BACKEND_SIM     //!< Registers are simulated in process memory
+} rp_backend_t;
+
+/**
+ * Signal source used by the simulated backend to fill the ADC buffers.
+ * @param channel    Channel the samples are produced for.
+ * @param sample     Index of the first decimated sample since the model was initialized.
+ * @param decimation Currently set decimation factor.
+ * @param buffer     Output buffer for ADC counts (14 bit signed values).
+ * @param size       Number of samples to produce.
+ * @param ctx        User context given at rp_SimSetSignalSource().
+ */
+typedef void (*rp_sim_source_t)(rp_channel_t channel, uint64_t sample, uint32_t decimation,
+                                int16_t *buffer, uint32_t size, void *ctx);
+
+/**
+ * Output sink the simulated backend hands the samples played by the generator to.
+ * @param channel    Channel the samples were played on.
+ * @param sample     Index of the first sample, in DAC clocks since the model was initialized.
+ * @param buffer     Buffer contents read at the pointer (14 bit signed values), before amplitude and offset.
+ * @param size       Number of samples.
+ * @param ctx        User context given at rp_SimSetOutputSink().
+ */
+typedef void (*rp_sim_sink_t)(rp_channel_t channel, uint64_t sample, const int16_t *buffer,
+                              uint32_t size, void *ctx);
+
 typedef struct wf_func_table_t {
     int (*rp_spectr_wf_init)();
     int (*rp_spectr_wf_clean)();
@@ -267,6 +510,15 @@ typedef struct wf_func_table_t {
  */
 int rp_Init();
 
+/**
+ * Initializes the library with the given register access backend. Without this call, rp_Init()
+ * uses /dev/mem unless environment variable RP_BACKEND is set to "sim".
+ * @param backend Backend used to access FPGA registers.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_InitBackend(rp_backend_t backend);
+
 int rp_CalibInit();
 
 /**
@@ -299,6 +551,55 @@ const char* rp_GetVersion();
 const char* rp_GetError(int errorCode);
 
 
+///@}
+/** @name Simulation
+ */
+///@{
+
+/**
+ * Sets the signal source the simulated backend samples into the ADC buffers.
+ * The default source is a 1 MHz sine, with channel B shifted by 90 degrees.
+ * @param source Signal source or NULL to restore the default source.
+ * @param ctx    User context passed to every source call.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SimSetSignalSource(rp_sim_source_t source, void *ctx);
+
+/**
+ * Sets the sink the simulated backend passes the samples played by the generator to.
+ * Samples are only produced by rp_SimStep() and only while a channel runs.
+ * @param sink Output sink or NULL to drop the samples.
+ * @param ctx  User context passed to every sink call.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SimSetOutputSink(rp_sim_sink_t sink, void *ctx);
+
+/**
+ * Enables the simulated trigger interrupt used by rp_AcqWaitTrigger(). It is enabled by default.
+ * The setting takes effect at the next rp_Init().
+ * @param enable True to signal triggers with an interrupt, false to make waiters poll.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SimSetTriggerIrq(bool enable);
+
+/**
+ * Advances the simulated oscilloscope by the given number of decimated samples. The write pointer
+ * moves, triggers are detected on the sampled signal and the trigger write pointer is latched as
+ * on the FPGA. External trigger sources are never raised by the model; software triggers of
+ * generator channel 1 raise the generator trigger sources at the first sample of the next step.
+ * The generator read pointers advance by the same time, in continuous wrap mode only, and
+ * restart from the start offset on software triggers.
+ * Only valid with the RP_BACKEND_SIM backend.
+ * @param samples Number of decimated samples to produce.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_SimStep(uint32_t samples);
+
+
 ///@}
 /** @name Digital loop
 */
@@ -498,6 +799,81 @@ int rp_DpinSetDirection(rp_dpin_t pin, rp_pinDirection_t direction);
  */
 int rp_DpinGetDirection(rp_dpin_t pin, rp_pinDirection_t* direction);
 
+/**
+ * Sets the states of several digital output pins with one access to each register they are in.
+ * @param mask   Pins to set, see RP_DPIN_MASK(). Other pins keep their state.
+ * @param state  States of the pins in mask, bit set for RP_HIGH.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EWIP if a pin in mask is an input, nothing is written then.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSetStateMask(uint32_t mask, uint32_t state);
+
+/**
+ * Gets the states of all digital pins, reading each register once.
+ * @param state  States of the pins, see RP_DPIN_MASK(), bit set for RP_HIGH.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinGetStateAll(uint32_t* state);
+
+/**
+ * Sets the directions of several digital pins with one access to each register they are in.
+ * @param mask       Pins to set, see RP_DPIN_MASK(). Other pins keep their direction.
+ * @param direction  Directions of the pins in mask, bit set for RP_OUT.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ELID if mask sets a LED to input, nothing is written then.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSetDirectionMask(uint32_t mask, uint32_t direction);
+
+/**
+ * Gets the directions of all digital pins, reading each register once. LEDs are always outputs.
+ * @param direction  Directions of the pins, see RP_DPIN_MASK(), bit set for RP_OUT.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinGetDirectionAll(uint32_t* direction);
+
+/**
+ * Starts playing a sequence of digital pin transitions.
+ * A library thread, with real-time priority when the process is allowed to, applies each
+ * transition at its time from the start on an absolute schedule, like rp_GenSweepStart().
+ * Transitions with the same time are applied together. Pin directions are checked once here,
+ * the pins must stay outputs while the sequence plays. Pins keep their last state at the end.
+ * @param transitions  Transitions, in order of time. The array may be freed once the call returns.
+ * @param count        Number of transitions.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if a sequence is already playing, RP_EIPV if the times are not in order,
+ * RP_EWIP if a pin in a mask is an input.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSequenceStart(const rp_dpin_transition_t* transitions, uint32_t count);
+
+/**
+ * Returns whether the sequence thread still has transitions to apply.
+ * @param running The output state.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSequenceIsRunning(bool* running);
+
+/**
+ * Gets the largest delay of a transition past its time in the last sequence started.
+ * @param max_late_ns The output delay [ns].
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSequenceGetLateness(uint64_t* max_late_ns);
+
+/**
+ * Stops the sequence if it is still playing and releases its resources; also needed once a
+ * sequence has completed. rp_DpinReset() stops it as well.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DpinSequenceStop();
+
 ///@}
 
 
@@ -556,6 +932,44 @@ int rp_ApinSetValueRaw(rp_apin_t pin, uint32_t value);
  */
 int rp_ApinGetRange(rp_apin_t pin, float* min_val,  float* max_val);
 
+/**
+ * Starts sampling all analog inputs, the FPGA temperature and supplies in the background.
+ * A library thread reads every channel once per period, keeping the system files it reads
+ * open, and publishes the values with their moving averages and extremes for rp_ApinGetAll().
+ * The first sweep is done before the function returns.
+ * @param period_us  Time between sweeps [us]. Sweeps that cannot be kept up with are skipped.
+ * @param window     Number of sweeps averaged, up to 4096.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if the sampler is already running, RP_EOMD if none of the channels can be read.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ApinSamplerStart(uint32_t period_us, uint32_t window);
+
+/**
+ * Stops the background sampler. rp_Release() stops it as well.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ApinSamplerStop();
+
+/**
+ * Restarts the minimum and maximum of all channels from the next sweep.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if the sampler is not running.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ApinResetMinMax();
+
+/**
+ * Gets the latest values of all sampled channels. The call does not access the hardware and
+ * never waits for the sampler thread; the snapshot is always from a single sweep.
+ * @param snapshot  Values of all channels.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if the sampler is not running.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_ApinGetAll(rp_ams_snapshot_t* snapshot);
+
 
 /** @name Analog Inputs
  */
@@ -745,6 +1159,20 @@ int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source);
  */
 int rp_AcqGetTriggerState(rp_acq_trig_state_t* state);
 
+/**
+ * Blocks until the trigger arrives or the timeout expires. The calling thread sleeps on the trigger
+ * interrupt when the FPGA provides one. Otherwise the trigger state is polled, first busy for a few
+ * microseconds and then with sleeps growing up to one millisecond.
+ * Like rp_AcqGetTriggerState(), the function returns immediately when no trigger source is set.
+ * @param timeout_ns Maximal time to wait in nanoseconds.
+ * @param latency_ns Optional, time from the trigger to the wake-up in nanoseconds. It is measured in
+ * samples written since the trigger, so it is a lower bound once the trigger delay has expired.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM if the trigger did not arrive in time.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqWaitTrigger(uint64_t timeout_ns, uint64_t* latency_ns);
+
 /**
  * Sets the number of decimated data after trigger written into memory.
  * @param decimated_data_num Number of decimated data. It must not be higher than the ADC buffer size.
@@ -849,6 +1277,38 @@ int rp_AcqGetGain(rp_channel_t channel, rp_pinState_t* state);
  */
 int rp_AcqGetGainV(rp_channel_t channel, float* voltage);
 
+/**
+ * Returns the current acquisition settings.
+ * Settings are served from the library's copy of the configuration registers, without bus reads.
+ * The copy is per process; call rp_AcqSyncShadow() first if another process may have changed them.
+ * @param config The output acquisition settings.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetConfig(rp_acq_config_t* config);
+
+/**
+ * Applies all acquisition settings in one pass.
+ * Every parameter is validated before anything is written, so on error the acquisition
+ * configuration is left unchanged. The register copy is reloaded from the FPGA first and then
+ * only registers whose value changes are written.
+ * The trigger delay is interpreted in samples, as with rp_AcqSetTriggerDelay().
+ * @param config Acquisition settings to apply.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqConfigure(const rp_acq_config_t* config);
+
+/**
+ * Reloads the library's copy of the acquisition configuration registers from the FPGA.
+ * The acquisition setters and getters use a per process copy of these registers; a setter
+ * skips the bus write when the copy already holds the value. Call this after another
+ * process (e.g. the SCPI server or a web application) may have reconfigured the scope.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSyncShadow();
+
 /**
  * Returns current position of ADC write pointer.
  * @param pos Write pointer position
@@ -943,6 +1403,31 @@ int rp_AcqGetDataRaw(rp_channel_t channel,  uint32_t pos, uint32_t* size, int16_
  */
 int rp_AcqGetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* buffer2);
 
+/**
+ * Returns a read-only view into the mapped ADC buffer from specified position and desired size,
+ * so the caller can process the samples in place instead of copying them.
+ * The view also records the write pointer at trigger and the acquisition generation;
+ * use rp_AcqIsRawViewValid() after processing to detect that the data was overwritten meanwhile.
+ * @param channel Channel A or B for which we want to retrieve the ADC buffer.
+ * @param pos Starting position of the ADC buffer to retrieve.
+ * @param size Length of the ADC buffer to retrieve, at most ADC_BUFFER_SIZE.
+ * @param view The output view describing one or two spans of the ADC buffer.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetRawView(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_view_t* view);
+
+/**
+ * Checks whether the data described by a view is still the data the view was taken of.
+ * The view is valid while writing into the ADC buffer is stopped, the write pointer at trigger
+ * is unchanged and the acquisition was not restarted or reset since rp_AcqGetRawView().
+ * @param view View returned by rp_AcqGetRawView().
+ * @param valid Set to true if the spans still hold the captured data.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqIsRawViewValid(const rp_acq_view_t* view, bool* valid);
+
 /**
  * Returns the ADC buffer in raw units from the oldest sample to the newest one.
  * Output buffer must be at least 'size' long.
@@ -981,6 +1466,7 @@ int rp_AcqGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* bu
 /**
  * Returns the ADC buffer in Volt units from specified position and desired size.
  * Output buffer must be at least 'size' long.
+ * The read-out uses RP_ACQ_SCRATCH_SIZE (4 KiB) of stack, independent of 'size'.
  * @param pos Starting position of the ADC buffer to retrieve
  * @param size Length of the ADC buffer to retrieve. Returns length of filled buffer. In case of too small buffer, required size is returned.
  * @param buffer1 The output buffer gets filled with the selected part of the ADC buffer for channel 1.
@@ -990,6 +1476,26 @@ int rp_AcqGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* bu
  */
 int rp_AcqGetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2);
 
+/**
+ * Returns the ADC buffer of both channels in Volt units, using caller provided scratch memory.
+ * Both channels are fetched and converted in a single pass over bursts of scratch_size / 8 samples
+ * per channel; apart from the scratch the call needs no heap and only a few bytes of stack,
+ * so it can run from small-stack threads. RP_ACQ_SCRATCH_SIZE gives the throughput of rp_AcqGetDataV2().
+ * The count to volt tables are allocated statically in the library. The first read after a gain or
+ * calibration change rebuilds a channel's table (16k conversions), and waits if another read still
+ * uses the table it replaces.
+ * Output buffers must be at least 'size' long.
+ * @param pos Starting position of the ADC buffer to retrieve
+ * @param size Length of the ADC buffer to retrieve. Returns length of filled buffer.
+ * @param buffer1 The output buffer gets filled with the selected part of the ADC buffer for channel 1.
+ * @param buffer2 The output buffer gets filled with the selected part of the ADC buffer for channel 2.
+ * @param scratch Scratch memory, 4 byte aligned.
+ * @param scratch_size Size of the scratch memory in bytes, at least 8.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetDataV2Scratch(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2, void* scratch, uint32_t scratch_size);
+
 /**
  * Returns the ADC buffer in Volt units from the oldest sample to the newest one.
  * Output buffer must be at least 'size' long.
@@ -1016,6 +1522,74 @@ int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int rp_AcqGetBufSize(uint32_t* size);
 
+/**
+ * Captures a number of trigger windows into preallocated buffers. The acquisition keeps writing
+ * (see rp_AcqSetArmKeep()) and the trigger source is re-armed right after every trigger, so no
+ * pre-trigger fill is needed between segments. Triggers arriving before the re-arm are missed.
+ * Segments are taken from the ADC buffers, which limits them to ADC_BUFFER_SIZE samples,
+ * or from the DDR buffers of the AXI recorders, which are not available while streaming.
+ * Samples are calibrated ADC counts like with rp_AcqGetDataRaw(). The trigger delay is
+ * restored and the acquisition is stopped on return.
+ * @param config Memory, trigger source and size and number of the segments.
+ * @param timeout_ns Maximal time for the whole capture in nanoseconds.
+ * @param buffer1 Output buffer of segments * (pre_samples + post_samples) samples for channel 1.
+ * @param buffer2 Output buffer of the same size for channel 2.
+ * @param segments Output array of 'segments' descriptions, in trigger order.
+ * @param count Returns the number of segments captured completely.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM if not all segments were captured in time.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqCaptureSegments(const rp_acq_seg_config_t* config, uint64_t timeout_ns, int16_t* buffer1, int16_t* buffer2,
+                          rp_acq_segment_t* segments, uint32_t* count);
+
+
+///@}
+/** @name Streaming
+ */
+///@{
+
+/**
+ * Starts gap-free acquisition of both channels into the DDR buffers reserved for the AXI recorders.
+ * Samples are recorded continuously with the current decimation, gain and filter settings;
+ * the trigger source is disabled. A library thread copies every completed block out of DDR
+ * and hands it to rp_StreamRead() callers, which may run in any number of threads.
+ * @param config Block size and number of buffered blocks.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_StreamStart(const rp_stream_config_t* config);
+
+/**
+ * Takes the oldest unread block. Each block is returned to exactly one caller.
+ * When readers fall behind, the oldest blocks are dropped and counted in rp_stream_stats_t.
+ * Samples are uncalibrated ADC counts (14 bit, sign extended).
+ * @param block The output description of the block.
+ * @param buffer1 Output buffer of block_size samples for channel 1.
+ * @param buffer2 Output buffer of block_size samples for channel 2.
+ * @param timeout_us Time to wait for a block in microseconds, 0 to return immediately.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM if no block became available in time,
+ * RP_EUF if streaming is not running or was stopped while waiting.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_StreamRead(rp_stream_block_t* block, int16_t* buffer1, int16_t* buffer2, uint32_t timeout_us);
+
+/**
+ * Returns the streaming counters since rp_StreamStart().
+ * @param stats The output counters.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_StreamGetStats(rp_stream_stats_t* stats);
+
+/**
+ * Stops streaming acquisition and releases its buffers.
+ * Waits for rp_StreamRead() calls in other threads to return first.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_StreamStop();
 
 ///@}
 /** @name Generate
@@ -1107,6 +1681,22 @@ int rp_GenFreq(rp_channel_t channel, float frequency);
 */
 int rp_GenGetFreq(rp_channel_t channel, float *frequency);
 
+/**
+* Sets channel signal frequency in DDS mode, with a resolution finer than rp_GenFreq().
+* With one period in the whole buffer, frequencies are multiples of 125 MHz / 2^30 (0.116 Hz).
+* In DDS mode the waveform is resampled to the table length, between 8192 and 16384 samples,
+* whose pointer step comes closest to the requested frequency; the longest table within
+* 'accuracy' is taken. The buffer is only rewritten when the table length changes.
+* rp_GenFreq() and arbitrary waveforms leave DDS mode.
+* @param channel Channel A or B for witch we want to set frequency.
+* @param frequency Frequency of the generated signal in Hz.
+* @param accuracy Largest acceptable difference from the requested frequency in Hz.
+* @param actual Frequency generated in Hz.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_GenDdsFreq(rp_channel_t channel, double frequency, double accuracy, double *actual);
+
 /**
 * Sets channel signal phase. This shifts the signal in time.
 * @param channel Channel A or B for witch we want to set phase.
@@ -1153,6 +1743,21 @@ int rp_GenGetWaveform(rp_channel_t channel, rp_waveform_t *type);
 */
 int rp_GenArbWaveform(rp_channel_t channel, float *waveform, uint32_t length);
 
+/**
+* Sets user defined waveform without copying it: the library takes over the buffer.
+* The samples are range checked and converted to DAC counts in one pass, as by rp_GenArbWaveform().
+* On success the buffer belongs to the library, which frees it with free() when the waveform of
+* the channel is replaced or in rp_Release(); the caller must not use it any more.
+* On failure the buffer stays with the caller. This includes a waveform that was accepted but could
+* not be applied to the generator: the library then keeps a copy, as rp_GenArbWaveform() does.
+* @param channel Channel A or B for witch we want to set waveform.
+* @param waveform Use defined wave form, where min is -1V an max is 1V, allocated with malloc().
+* @param length Length of waveform.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_GenArbWaveformMove(rp_channel_t channel, float *waveform, uint32_t length);
+
 /**
 * Gets user defined waveform.
 * @param channel Channel A or B for witch we want to get waveform.
@@ -1280,6 +1885,113 @@ int rp_GenGetTriggerSource(rp_channel_t channel, rp_trig_src_t *src);
 */
 int rp_GenTrigger(uint32_t channel);
 
+/**
+ * Starts a frequency and amplitude sweep of a generator channel.
+ * The register values of all steps are computed beforehand; a library thread, with real-time
+ * priority when the process is allowed to, applies one step per dwell time on an absolute
+ * schedule, so the timing error does not accumulate. Steps only change the frequency and the
+ * amplitude registers: the signal keeps its phase across steps and the waveform table is not
+ * rewritten, so square wave edges stay as they were at the start. With dds_accuracy set, the
+ * table length is chosen for all steps of the sweep before it starts, which gives chirps and
+ * FSK sequences the finer frequency resolution of rp_GenDdsFreq().
+ * Step completion is signalled to the callback and through the descriptor of rp_GenSweepGetEventFd().
+ * @param config Sweep parameters.
+ * @param callback Function called after every step, or NULL.
+ * @param ctx Argument passed to the callback.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if a sweep is already running.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenSweepStart(const rp_gen_sweep_config_t* config, rp_gen_sweep_callback_t callback, void* ctx);
+
+/**
+ * Returns an eventfd that becomes readable after every step of the running sweep. Reading it
+ * returns the number of steps applied since the previous read. The descriptor is valid until
+ * rp_GenSweepStop() and may be used with poll() or select().
+ * @param fd The output file descriptor.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenSweepGetEventFd(int* fd);
+
+/**
+ * Returns whether the sweep thread still has steps to apply or dwell times to wait for.
+ * @param running The output state.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenSweepIsRunning(bool* running);
+
+/**
+ * Stops the sweep if it is still running and releases its resources; also needed once a sweep has completed.
+ * The generator keeps the frequency and amplitude of the last step applied.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenSweepStop();
+
+/**
+ * Starts streaming playback on a generator channel, for signals longer than the AWG buffer.
+ * Samples written with rp_GenStreamWrite() pass through a lock-free queue; a library thread
+ * follows the read pointer of the channel and refills the half of the AWG buffer that was just
+ * played. The channel is held until playback begins, in the rp_GenStreamWrite() call that
+ * completes the first whole AWG buffer (16384 samples). Samples are in volts like arbitrary
+ * waveforms and are scaled by the amplitude and offset of the channel.
+ * Calls that rewrite the buffer of the channel, such as rp_GenWaveform(), rp_GenFreq() or
+ * rp_GenPhase(), must not be made while streaming.
+ * @param config Channel, sample rate and queue size.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EUF if streaming is already running.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenStreamStart(const rp_gen_stream_config_t* config);
+
+/**
+ * Queues samples for streaming playback. Only one thread may write.
+ * When the queue runs dry, the generator plays 0 V and the refill is counted as an underrun.
+ * @param data Samples in [V], clipped to [-1, 1].
+ * @param size Number of samples to queue; on return the number of samples queued.
+ * @param timeout_us Time to wait for space in the queue in microseconds, 0 to return immediately.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM if not all samples could be queued in time.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenStreamWrite(const float* data, uint32_t* size, uint32_t timeout_us);
+
+/**
+ * Returns the generator streaming counters since rp_GenStreamStart().
+ * @param stats The output counters.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenStreamGetStats(rp_gen_stream_stats_t* stats);
+
+/**
+ * Stops streaming playback, releases the queue and restores the waveform set on the channel.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GenStreamStop();
+
+/**
+ * Plays a burst on both generator channels and captures both inputs from the moment it starts.
+ * The waveforms, frequencies, amplitudes and offsets set on the channels are kept; both channels
+ * are put in burst mode with the given burst count and wait for a trigger. Each repeat arms the
+ * acquisition on the generator trigger (RP_TRIG_SRC_AWG_PE, raised by channel 1) and triggers
+ * both channels with a single register write, so every capture starts at the same sample of
+ * the burst. The captures are summed in place; divide by the repeats for the average.
+ * The acquisition trigger delay and the burst mode, count, repetitions, period and trigger source
+ * of both generator channels are restored on return.
+ * @param config Burst count, capture size, repeats and timeout.
+ * @param buffer1 Channel 1 samples in [V]; holds config->size samples.
+ * @param buffer2 Channel 2 samples in [V]; holds config->size samples.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETIM if a capture did not complete in time.
+ * RP_EUF if a generator sweep or streaming playback is running.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_MeasureResponse(const rp_measure_config_t* config, float* buffer1, float* buffer2);
+
 float rp_CmnCnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
 
 #ifdef __cplusplus
@@ -0,0 +1,186 @@
+/**
+ * $Id: $
+ *
+ * @file rp_fft.h
+ * @brief Red Pitaya library FFT interface
+ *
+ * Forward single precision FFT shared by librp and the applications, with
+ * spectrum averaging. It is included by rp.h and can be included on its own
+ * by code that does not use the rest of the API; it does not need rp_Init().
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __RP_FFT_H
+#define __RP_FFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * Implementation the FFT plans are built with, see rp_FftSetBackend().
+ */
+typedef enum {
+    RP_FFT_AUTO,    //!< Radix-4 for power of two sizes, kiss_fft for the others
+    RP_FFT_KISS,    //!< kiss_fft, any size
+    RP_FFT_RADIX4   //!< Radix-4 with NEON or SSE2 butterflies, power of two sizes
+} rp_fft_backend_t;
+
+/**
+ * Transform computed by an FFT plan.
+ */
+typedef enum {
+    RP_FFT_COMPLEX, //!< size complex samples to size bins
+    RP_FFT_REAL     //!< size real samples to size/2+1 bins, size even
+} rp_fft_type_t;
+
+/**
+ * Complex sample or bin, laid out as kiss_fft_cpx with float scalars.
+ */
+typedef struct {
+    float r;        //!< Real part
+    float i;        //!< Imaginary part
+} rp_fft_cpx_t;
+
+/**
+ * Opaque FFT plan, see rp_FftPlanGet().
+ */
+typedef struct rp_fft_plan rp_fft_plan_t;
+
+/**
+ * Averaging of successive spectra, see rp_FftAvgAdd().
+ */
+typedef enum {
+    RP_FFT_AVG_LINEAR,  //!< Mean of the first count frames, then held until reset
+    RP_FFT_AVG_EXP,     //!< Mean of the frames until count, then exponential with weight 1/count
+    RP_FFT_AVG_PEAK,    //!< Largest value of every bin
+    RP_FFT_AVG_MIN      //!< Smallest value of every bin
+} rp_fft_avg_mode_t;
+
+/**
+ * Averaging state of one accumulator. Set mode and count and clear frames to
+ * start or restart averaging.
+ */
+typedef struct {
+    rp_fft_avg_mode_t mode; //!< Averaging mode
+    uint32_t count;         //!< Frames averaged (linear) or time constant in frames (exponential), at least 1
+    uint32_t frames;        //!< Frames added since the start
+} rp_fft_avg_t;
+
+/**
+ * Selects the implementation plans are built with from now on. Plans obtained
+ * before keep their implementation. The default is RP_FFT_AUTO.
+ * @param backend Implementation of the FFT.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftSetBackend(rp_fft_backend_t backend);
+
+/**
+ * Returns the implementation plans are built with.
+ * @param backend The output implementation.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftGetBackend(rp_fft_backend_t* backend);
+
+/**
+ * Returns the plan of a forward transform. Plans are cached by size, type and
+ * implementation, so every caller asking for the same transform shares one
+ * plan and only the first call computes the twiddle factors. A plan is not
+ * modified when it is executed and can be executed from several threads at
+ * once; it stays valid until rp_FftCleanup().
+ * @param size Number of input samples.
+ * @param type Complex or real input.
+ * @param plan The output plan.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * RP_EIPV if the size is 0, odd for RP_FFT_REAL, or not a power of two for RP_FFT_RADIX4.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftPlanGet(uint32_t size, rp_fft_type_t type, rp_fft_plan_t** plan);
+
+/**
+ * Computes a forward transform, without scaling.
+ * @param plan Plan from rp_FftPlanGet().
+ * @param in size rp_fft_cpx_t samples for RP_FFT_COMPLEX, size floats for RP_FFT_REAL.
+ * @param out size bins for RP_FFT_COMPLEX, size/2+1 bins for RP_FFT_REAL; must not overlap the input.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftExecute(const rp_fft_plan_t* plan, const void* in, rp_fft_cpx_t* out);
+
+/**
+ * Adds one frame to an accumulator, in place. The first frame is copied; after
+ * that every bin costs one multiply-add (linear, exponential) or one compare
+ * (peak, min). Average power spectra, not dB values.
+ * @param avg Averaging state, frames is advanced.
+ * @param acc Accumulator of bins values, holding the average on return.
+ * @param frame Bins of the new frame.
+ * @param bins Number of bins.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * RP_EIPV if the mode or the count are not valid.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftAvgAdd(rp_fft_avg_t* avg, float* acc, const float* frame, uint32_t bins);
+
+/**
+ * Welch power spectrum of a long real capture: the mean of |FFT|^2 of
+ * overlapping segments, each multiplied by the Hann window
+ * 0.5 * (1 - cos(2 pi n / (seg_len - 1))). The power is not scaled otherwise.
+ * Segments start every seg_len - overlap samples; samples after the last
+ * whole segment are not used.
+ * @param in Capture of in_len samples.
+ * @param in_len Number of samples, at least seg_len.
+ * @param seg_len Samples per segment, even; see rp_FftPlanGet() for the sizes of each backend.
+ * @param overlap Samples shared by successive segments, less than seg_len; seg_len/2 is usual.
+ * @param power seg_len/2+1 output bins.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * RP_EIPV if the lengths are not valid.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftWelch(const float* in, uint32_t in_len, uint32_t seg_len, uint32_t overlap, float* power);
+
+/**
+ * Zoom power spectrum of a real capture: fft_len bins around a center
+ * frequency, decimation times finer than an FFT of fft_len samples. The
+ * capture is mixed down by center with a numerically controlled oscillator,
+ * decimated by a CIC style chain of halving filters and a FIR filter, and
+ * multiplied by a Hann window before the FFT. Bin j is at the frequency
+ * center + (j - fft_len/2) / (decimation * fft_len) times the sample rate; the
+ * droop of the filters is corrected and the power is scaled to the bins of a
+ * real FFT of decimation * fft_len samples with the same window, like one
+ * segment of rp_FftWelch(). Aliases stay at least 74 dB down in the middle
+ * 80 % of the bins; the outer bins are not alias free.
+ * @param in Capture of in_len samples.
+ * @param in_len Number of samples; decimation * (fft_len + 33) samples are always enough.
+ * @param center Center frequency relative to the sample rate, -0.5 to 0.5.
+ * @param decimation Power of two from 4 to 65536.
+ * @param fft_len Number of bins; see rp_FftPlanGet() for the sizes of each backend.
+ * @param power fft_len output bins.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * RP_EIPV if a parameter is not valid or the capture is too short.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftZoom(const float* in, uint32_t in_len, float center, uint32_t decimation, uint32_t fft_len, float* power);
+
+/**
+ * Frees all cached plans, windows and zoom filters. Plans obtained before must not be used afterwards.
+ * @return If the function is successful, the return value is RP_OK (0).
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_FftCleanup();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__RP_FFT_H
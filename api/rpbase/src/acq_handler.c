@@ -14,7 +14,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "calib.h"
@@ -39,17 +41,83 @@ static const uint64_t ADC_SAMPLE_PERIOD = 8;
 /* @brief Number of ADC acquisition bits. */
 static const int ADC_BITS = 14;
 
+/* @brief Trigger wait without interrupt: busy polling time, then sleeps of a fraction of the time waited [ns]. */
+static const uint64_t TRIG_WAIT_SPIN_NS        = 20000;
+static const uint64_t TRIG_WAIT_SLEEP_MIN_NS   = 10000;
+static const uint64_t TRIG_WAIT_SLEEP_MAX_NS   = 1000000;
+static const uint64_t TRIG_WAIT_SLEEP_FRACTION = 16;
+
+/* @brief Incremented whenever the acquisition is (re)armed, invalidating raw views. */
+static uint32_t acq_generation = 0;
+
+/* @brief Number of samples copied from the FPGA buffer into cacheable memory per burst. */
+#define ACQ_BURST_SIZE 1024
+
 /* @brief ADC acquisition bits mask. */
 static const int ADC_BITS_MAK = 0x3FFF;
 
-/* @brief Currently set Gain state */
-static rp_pinState_t gain_ch_a = RP_LOW;
-static rp_pinState_t gain_ch_b = RP_LOW;
+/* @brief Number of distinct ADC codes, one lookup table entry each. */
+#define VOLT_LUT_SIZE (1 << 14)
+
+/**
+ * @brief Count to voltage lookup table for one (channel, gain) pair and the inputs it was built from.
+ * A published table is never modified. Its reference count covers the slot
+ * publishing it and every conversion using it; a table is rebuilt only at zero.
+ */
+typedef struct {
+    uint32_t refs;
+    float gainV;
+    uint32_t calibScale;
+    int32_t dc_offs;
+    float volts[VOLT_LUT_SIZE];
+} volt_lut_t;
+
+/* @brief Published table of a (channel, gain) pair and the spare the next one is built in. */
+typedef struct {
+    volt_lut_t tables[2];
+    volt_lut_t* current;    // NULL until the first read
+} volt_lut_slot_t;
+
+/* @brief Lookup tables indexed by channel and gain, allocated statically so a read needs no heap. */
+static volt_lut_slot_t volt_lut[2][2];
+static pthread_mutex_t volt_lut_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t volt_lut_free = PTHREAD_COND_INITIALIZER;   // a table reached zero references
+
+/* @brief Acquisition settings kept by the library rather than the FPGA. */
+typedef struct {
+    rp_pinState_t gain[2];          // currently set gain state of each channel
+    bool trig_delay_in_ns;          // whether the trigger delay was set in time or sample units
+    rp_acq_trig_src_t trig_src;     // last trigger source set
+} acq_state_t;
 
-/* @brief Determines whether TriggerDelay was set in time or sample units */
-static bool triggerDelayInNs = false;
+/**
+ * @brief Acquisition context: the settings and the seqlock publishing them.
+ * Setters are serialized by the writer mutex, readers copy a consistent
+ * snapshot without locking and never hold up a setter.
+ */
+typedef struct {
+    uint32_t seq;
+    pthread_mutex_t writer;
+    acq_state_t state;
+} acq_ctx_t;
+
+static acq_ctx_t acq_ctx = {
+    .seq = 0,
+    .writer = PTHREAD_MUTEX_INITIALIZER,
+    .state = {
+        .gain = { RP_LOW, RP_LOW },
+        .trig_delay_in_ns = false,
+        .trig_src = RP_TRIG_SRC_DISABLED
+    }
+};
 
-rp_acq_trig_src_t last_trig_src = RP_TRIG_SRC_DISABLED;
+/* @brief Inputs of the count to voltage conversion of one channel. */
+typedef struct {
+    rp_pinState_t gain;
+    float gainV;
+    uint32_t calibScale;
+    int32_t dc_offs;
+} acq_scale_t;
 
 /* @brief Default filter equalization coefficients */
 static const uint32_t GAIN_LO_CHA_FILT_AA = 0x7D93;
@@ -74,6 +142,78 @@ static const uint32_t GAIN_HI_CHB_FILT_KK = 0xd9999a;
 #define GET_OFFSET_CH2(gain, calib) (gain == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs)
 #define GET_OFFSET(channel, gain, calib) (channel == RP_CH_1 ? GET_OFFSET_CH1(gain, calib) : GET_OFFSET_CH2(gain, calib) )
 
+#define GET_SCALE_CH1(gain, calib) (gain == RP_HIGH ? calib.fe_ch1_fs_g_hi : calib.fe_ch1_fs_g_lo)
+#define GET_SCALE_CH2(gain, calib) (gain == RP_HIGH ? calib.fe_ch2_fs_g_hi : calib.fe_ch2_fs_g_lo)
+#define GET_SCALE(channel, gain, calib) (channel == RP_CH_1 ? GET_SCALE_CH1(gain, calib) : GET_SCALE_CH2(gain, calib) )
+
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Copies the current acquisition settings
+ *
+ * The copy is retried when a setter published new settings meanwhile, so it
+ * is always consistent without blocking the setter.
+ *
+ * @param[out] state settings snapshot
+ */
+static void acqGetState(acq_state_t* state)
+{
+    uint32_t seq;
+    do {
+        seq = cmn_SeqReadBegin(&acq_ctx.seq);
+        *state = acq_ctx.state;
+    } while (cmn_SeqReadRetry(&acq_ctx.seq, seq));
+}
+
+/**
+ * @brief Starts changing the acquisition settings
+ *
+ * Must be paired with acqWriteEnd(). The settings must not be read in between,
+ * as readers wait for the update to complete.
+ *
+ * @retval acq_state_t* settings to modify
+ */
+static acq_state_t* acqWriteBegin()
+{
+    pthread_mutex_lock(&acq_ctx.writer);
+    cmn_SeqWriteBegin(&acq_ctx.seq);
+    return &acq_ctx.state;
+}
+
+/**
+ * @brief Publishes the settings modified since acqWriteBegin()
+ */
+static void acqWriteEnd()
+{
+    cmn_SeqWriteEnd(&acq_ctx.seq);
+    pthread_mutex_unlock(&acq_ctx.writer);
+}
+
+/**
+ * @brief Returns the conversion inputs of a channel for the given gain
+ *
+ * Offset and full scale come from the same calibration snapshot.
+ */
+static void getScaleForGain(rp_channel_t channel, rp_pinState_t gain, acq_scale_t* scale)
+{
+    rp_calib_params_t calib = calib_GetParams();
+
+    scale->gain = gain;
+    scale->gainV = gain == RP_LOW ? 1.0 : 20.0;
+    scale->calibScale = GET_SCALE(channel, gain, calib);
+    scale->dc_offs = GET_OFFSET(channel, gain, calib);
+}
+
+/**
+ * @brief Returns the conversion inputs of a channel for its current gain
+ */
+static void getScale(rp_channel_t channel, acq_scale_t* scale)
+{
+    acq_state_t state;
+    acqGetState(&state);
+    getScaleForGain(channel, state.gain[channel == RP_CH_1 ? 0 : 1], scale);
+}
+
 
 /*----------------------------------------------------------------------------*/
 /**
@@ -115,13 +255,11 @@ static int64_t cnvSmplsToTime(int32_t samples)
 /**
  * Sets equalization filter with default coefficients per channel
  * @param channel Channel A or B
+ * @param gain Gain the coefficients are selected for
  * @return 0 when successful
  */
-static int setEqFilters(rp_channel_t channel)
+static int setEqFilters(rp_channel_t channel, rp_pinState_t gain)
 {
-    rp_pinState_t gain;
-    ECHECK(acq_GetGain(channel, &gain));
-
     // Update equalization filter with default coefficients
     if (channel == RP_CH_1)
     {
@@ -172,25 +310,18 @@ int acq_SetArmKeep(bool enable) {
 int acq_SetGain(rp_channel_t channel, rp_pinState_t state)
 {
 
-    rp_pinState_t *gain = NULL;
-
-    if (channel == RP_CH_1) {
-        gain = &gain_ch_a;
-    }
-
-    else {
-        gain = &gain_ch_b;
-    }
+    int idx = channel == RP_CH_1 ? 0 : 1;
 
     // Read old values which are dependent on the gain...
     rp_pinState_t old_gain;
     float ch_thr, ch_hyst;
-    old_gain = *gain;
+    ECHECK(acq_GetGain(channel, &old_gain));
     ECHECK(acq_GetChannelThreshold(channel, &ch_thr));
     ECHECK(acq_GetChannelThresholdHyst(channel, &ch_hyst));
 
     // Now update the gain
-    *gain = state;
+    acqWriteBegin()->gain[idx] = state;
+    acqWriteEnd();
 
     // And recalculate new values...
     int status = acq_SetChannelThreshold(channel, ch_thr);
@@ -200,14 +331,15 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state)
 
     // In case of an error, put old values back and report the error
     if (status != RP_OK) {
-        *gain = old_gain;
+        acqWriteBegin()->gain[idx] = old_gain;
+        acqWriteEnd();
         acq_SetChannelThreshold(channel, ch_thr);
         acq_SetChannelThresholdHyst(channel, ch_hyst);
     }
     // At the end if everything is ok, update also equalization filters based on the new gain.
     // Updating eq filters should never fail...
     else {
-        status = setEqFilters(channel);
+        status = setEqFilters(channel, state);
     }
 
     return status;
@@ -215,12 +347,9 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state)
 
 int acq_GetGain(rp_channel_t channel, rp_pinState_t* state)
 {
-    if (channel == RP_CH_1) {
-        *state = gain_ch_a;
-    }
-    else {
-        *state = gain_ch_b;
-    }
+    acq_state_t snapshot;
+    acqGetState(&snapshot);
+    *state = snapshot.gain[channel == RP_CH_1 ? 0 : 1];
     return RP_OK;
 }
 
@@ -231,16 +360,10 @@ int acq_GetGain(rp_channel_t channel, rp_pinState_t* state)
  */
 int acq_GetGainV(rp_channel_t channel, float* voltage)
 {
-    rp_pinState_t *gain = NULL;
-
-    if (channel == RP_CH_1) {
-        gain = &gain_ch_a;
-    }
-    else {
-        gain = &gain_ch_b;
-    }
+    rp_pinState_t gain;
+    ECHECK(acq_GetGain(channel, &gain));
 
-    if (*gain == RP_LOW) {
+    if (gain == RP_LOW) {
         *voltage = 1.0;
     }
     else {
@@ -252,8 +375,10 @@ int acq_GetGainV(rp_channel_t channel, float* voltage)
 int acq_SetDecimation(rp_acq_decimation_t decimation)
 {
     int64_t time_ns = 0;
+    acq_state_t state;
+    acqGetState(&state);
 
-    if (triggerDelayInNs) {
+    if (state.trig_delay_in_ns) {
         ECHECK(acq_GetTriggerDelayNs(&time_ns));
     }
 
@@ -281,7 +406,7 @@ int acq_SetDecimation(rp_acq_decimation_t decimation)
     }
 
     // Now update trigger delay based on new decimation
-    if (triggerDelayInNs) {
+    if (state.trig_delay_in_ns) {
         ECHECK(acq_SetTriggerDelayNs(time_ns, true));
     }
 
@@ -322,11 +447,8 @@ int acq_GetDecimation(rp_acq_decimation_t* decimation)
     }
 }
 
-int acq_GetDecimationFactor(uint32_t* decimation)
+static int getDecimationFactor(rp_acq_decimation_t decimationVal, uint32_t* decimation)
 {
-    rp_acq_decimation_t decimationVal;
-    ECHECK(acq_GetDecimation(&decimationVal));
-
     switch (decimationVal) {
     case RP_DEC_1:
         *decimation = DEC_1;
@@ -351,6 +473,13 @@ int acq_GetDecimationFactor(uint32_t* decimation)
     }
 }
 
+int acq_GetDecimationFactor(uint32_t* decimation)
+{
+    rp_acq_decimation_t decimationVal;
+    ECHECK(acq_GetDecimation(&decimationVal));
+    return getDecimationFactor(decimationVal, decimation);
+}
+
 
 int acq_SetSamplingRate(rp_acq_sampling_rate_t sampling_rate)
 {
@@ -444,7 +573,8 @@ int acq_GetAveraging(bool* enable)
 
 int acq_SetTriggerSrc(rp_acq_trig_src_t source)
 {
-    last_trig_src = source;
+    acqWriteBegin()->trig_src = source;
+    acqWriteEnd();
     return osc_SetTriggerSource(source);
 }
 
@@ -468,6 +598,108 @@ int acq_GetTriggerState(rp_acq_trig_state_t* state)
     return RP_OK;
 }
 
+/**
+ * The trigger has arrived once the post trigger delay is counting, or when the
+ * FPGA has already cleared the trigger source after the delay expired.
+ */
+static int acqTriggerArrived(bool* arrived)
+{
+    bool delay_counting;
+    uint32_t source;
+    ECHECK(osc_GetTriggerState(&delay_counting));
+    ECHECK(osc_GetTriggerSource(&source));
+    *arrived = delay_counting || source == RP_TRIG_SRC_DISABLED;
+    return RP_OK;
+}
+
+/**
+ * Time since the trigger, derived from the samples written after it. Once the
+ * post trigger delay expired the writing stops, so the value is a lower bound.
+ */
+static int acqTriggerAge(uint64_t* age_ns)
+{
+    uint32_t wp, wp_trig, decimation;
+    ECHECK(osc_GetWritePointer(&wp));
+    ECHECK(osc_GetWritePointerAtTrig(&wp_trig));
+    ECHECK(acq_GetDecimationFactor(&decimation));
+    uint32_t samples = (wp + ADC_BUFFER_SIZE - wp_trig) % ADC_BUFFER_SIZE;
+    *age_ns = (uint64_t) samples * decimation * ADC_SAMPLE_PERIOD;
+    return RP_OK;
+}
+
+int acq_WaitTrigger(uint64_t timeout_ns, uint64_t* latency_ns)
+{
+    uint64_t start = cmn_NowNs();
+    bool irq = osc_HasTriggerIrq();
+    bool arrived;
+
+    // Interrupt is enabled before the first check, so a trigger in between is not lost
+    if (irq) {
+        ECHECK(osc_EnableTriggerIrq());
+    }
+    ECHECK(acqTriggerArrived(&arrived));
+
+    while (!arrived) {
+        uint64_t elapsed = cmn_NowNs() - start;
+        if (elapsed >= timeout_ns) {
+            return RP_ETIM;
+        }
+
+        if (irq) {
+            int ret = osc_WaitTriggerIrq(timeout_ns - elapsed);
+            if (ret != RP_OK && ret != RP_ETIM) {
+                return ret;
+            }
+            ECHECK(osc_EnableTriggerIrq());
+        }
+        else if (elapsed < TRIG_WAIT_SPIN_NS) {
+            CPU_RELAX();
+        }
+        else {
+            // Sleeping for a fraction of the time waited so far bounds the relative overshoot
+            uint64_t sleep_ns = MAX(MIN(elapsed / TRIG_WAIT_SLEEP_FRACTION, TRIG_WAIT_SLEEP_MAX_NS), TRIG_WAIT_SLEEP_MIN_NS);
+            cmn_SleepNs(MIN(sleep_ns, timeout_ns - elapsed));
+        }
+        ECHECK(acqTriggerArrived(&arrived));
+    }
+
+    if (latency_ns) {
+        ECHECK(acqTriggerAge(latency_ns));
+    }
+    return RP_OK;
+}
+
+/**
+ * Waits for the trigger and then for the post trigger delay to expire, so the
+ * whole capture is in the buffer. The delay is slept through in one go.
+ */
+int acq_WaitCaptured(uint64_t timeout_ns)
+{
+    uint64_t start = cmn_NowNs();
+    ECHECK(acq_WaitTrigger(timeout_ns, NULL));
+
+    uint32_t delay, decimation;
+    ECHECK(osc_GetTriggerDelay(&delay));
+    ECHECK(acq_GetDecimationFactor(&decimation));
+    uint64_t capture_ns = (uint64_t) delay * decimation * ADC_SAMPLE_PERIOD;
+
+    bool delay_counting;
+    ECHECK(osc_GetTriggerState(&delay_counting));
+    while (delay_counting) {
+        uint64_t elapsed = cmn_NowNs() - start;
+        if (elapsed >= timeout_ns) {
+            return RP_ETIM;
+        }
+
+        uint64_t age_ns;
+        ECHECK(acqTriggerAge(&age_ns));
+        uint64_t left_ns = capture_ns > age_ns ? capture_ns - age_ns : 0;
+        cmn_SleepNs(MIN(MAX(left_ns, TRIG_WAIT_SLEEP_MIN_NS), timeout_ns - elapsed));
+        ECHECK(osc_GetTriggerState(&delay_counting));
+    }
+    return RP_OK;
+}
+
 int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue)
 {
     int32_t trig_dly;
@@ -479,7 +711,8 @@ int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue)
     }
 
     ECHECK(osc_SetTriggerDelay(trig_dly));
-    triggerDelayInNs = false;
+    acqWriteBegin()->trig_delay_in_ns = false;
+    acqWriteEnd();
     return RP_OK;
 }
 
@@ -487,7 +720,8 @@ int acq_SetTriggerDelayNs(int64_t time_ns, bool updateMaxValue)
 {
     int32_t samples = cnvTimeToSmpls(time_ns);
     ECHECK(acq_SetTriggerDelay(samples, updateMaxValue));
-    triggerDelayInNs = true;
+    acqWriteBegin()->trig_delay_in_ns = true;
+    acqWriteEnd();
     return RP_OK;
 }
 
@@ -534,23 +768,30 @@ int acq_GetTriggerLevel(float *voltage)
     return RP_OK;
 }
 
-int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
+/**
+ * Converts a threshold or hysteresis voltage to ADC counts for the given gain
+ * @return RP_EOOR when the voltage is out of the input range of the gain
+ */
+static int cnvThresholdToCnts(rp_channel_t channel, rp_pinState_t gain, float voltage, uint32_t* cnt)
 {
-    float gainV;
-    rp_pinState_t gain;
-
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));;
+    acq_scale_t scale;
+    getScaleForGain(channel, gain, &scale);
 
-    if (fabs(voltage) - fabs(gainV) > FLOAT_EPS) {
+    if (fabs(voltage) - fabs(scale.gainV) > FLOAT_EPS) {
         return RP_EOOR;
     }
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    *cnt = cmn_CnvVToCnt(ADC_BITS, voltage, scale.gainV, gain == RP_HIGH ? false : true, scale.calibScale, scale.dc_offs, 0.0);
+    return RP_OK;
+}
 
-    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, gainV, gain == RP_HIGH ? false : true, calibScale, dc_offs, 0.0);
+int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
+{
+    rp_pinState_t gain;
+    uint32_t cnt;
+
+    ECHECK(acq_GetGain(channel, &gain));
+    ECHECK(cnvThresholdToCnts(channel, gain, voltage, &cnt));
 
     // We cut high bits of negative numbers
     cnt = cnt & ((1 << ADC_BITS) - 1);
@@ -565,8 +806,6 @@ int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -576,14 +815,10 @@ int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetThresholdChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    acq_scale_t scale;
+    getScale(channel, &scale);
 
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, scale.gainV, scale.calibScale, scale.dc_offs, 0.0);
 
     return RP_OK;
 }
@@ -604,21 +839,12 @@ int acq_GetTriggerHyst(float *voltage)
 
 int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
 {
-    float gainV;
     rp_pinState_t gain;
+    uint32_t cnt;
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));;
-
-    if (fabs(voltage) - fabs(gainV) > FLOAT_EPS) {
-        return RP_EOOR;
-    }
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    ECHECK(acq_GetGain(channel, &gain));
+    ECHECK(cnvThresholdToCnts(channel, gain, voltage, &cnt));
 
-    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, gainV, gain == RP_HIGH ? false : true, calibScale, dc_offs, 0.0);
     if (channel == RP_CH_1) {
         return osc_SetHysteresisChA(cnt);
     }
@@ -629,8 +855,6 @@ int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -640,20 +864,17 @@ int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetHysteresisChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    acq_scale_t scale;
+    getScale(channel, &scale);
 
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, scale.gainV, scale.calibScale, scale.dc_offs, 0.0);
 
     return RP_OK;
 }
 
 int acq_Start()
 {
+    __atomic_add_fetch(&acq_generation, 1, __ATOMIC_RELEASE);
     ECHECK(osc_WriteDataIntoMemory(true));
     return RP_OK;
 }
@@ -665,6 +886,7 @@ int acq_Stop()
 
 int acq_Reset()
 {
+    __atomic_add_fetch(&acq_generation, 1, __ATOMIC_RELEASE);
     ECHECK(acq_SetDefault());
     return osc_ResetWriteStateMachine();
 }
@@ -697,25 +919,46 @@ uint32_t acq_GetNormalizedDataPos(uint32_t pos)
     return (pos % ADC_BUFFER_SIZE);
 }
 
+/**
+ * Copies the next burst of raw words starting at *pos into cacheable memory.
+ * A burst never crosses the buffer wrap, so a read is at most two contiguous
+ * spans of the ring, each split into bursts of ACQ_BURST_SIZE samples.
+ */
+static uint32_t readRawBurst(const volatile uint32_t* raw_buffer, uint32_t* pos, uint32_t remaining, uint32_t* burst)
+{
+    uint32_t len = MIN(MIN(remaining, ADC_BUFFER_SIZE - *pos), ACQ_BURST_SIZE);
+
+    cmn_CopyFromDevice(burst, raw_buffer + *pos, len);
+    *pos = (*pos + len) % ADC_BUFFER_SIZE;
+
+    return len;
+}
+
+int acq_GetDcOffset(rp_channel_t channel, int32_t* dc_offs)
+{
+    acq_scale_t scale;
+    getScale(channel, &scale);
+    *dc_offs = scale.dc_offs;
+    return RP_OK;
+}
+
 int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
 {
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    uint32_t cnts;
+    uint32_t burst[ACQ_BURST_SIZE];
 
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
 
-    rp_pinState_t gain;
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
+    acq_scale_t scale;
+    getScale(channel, &scale);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
-
-        buffer[i] = cmn_CalibCnts(ADC_BITS, cnts, dc_offs);
+    pos = acq_GetNormalizedDataPos(pos);
+    for (uint32_t i = 0; i < (*size); ) {
+        uint32_t len = readRawBurst(raw_buffer, &pos, (*size) - i, burst);
+        cmn_CalibCntsBlock(ADC_BITS, burst, &buffer[i], len, scale.dc_offs);
+        i += len;
     }
 
     return RP_OK;
@@ -726,17 +969,63 @@ int acq_GetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* b
 {
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
+
+    uint32_t burst[ACQ_BURST_SIZE];
     const volatile uint32_t* raw_buffer = getRawBuffer(RP_CH_1);
     const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        buffer[i] = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
-        buffer2[i] = (raw_buffer2[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
+    pos = acq_GetNormalizedDataPos(pos);
+    for (uint32_t i = 0; i < (*size); ) {
+        uint32_t pos2 = pos;
+        uint32_t len = readRawBurst(raw_buffer, &pos, (*size) - i, burst);
+        for (uint32_t j = 0; j < len; ++j) {
+            buffer[i + j] = burst[j] & ADC_BITS_MAK;
+        }
+        readRawBurst(raw_buffer2, &pos2, len, burst);
+        for (uint32_t j = 0; j < len; ++j) {
+            buffer2[i + j] = burst[j] & ADC_BITS_MAK;
+        }
+        i += len;
     }
 
     return RP_OK;
 }
 
+int acq_GetRawView(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_view_t* view)
+{
+    if (size > ADC_BUFFER_SIZE) {
+        return RP_BTS;
+    }
+
+    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+
+    view->generation = __atomic_load_n(&acq_generation, __ATOMIC_ACQUIRE);
+    ECHECK(acq_GetWritePointerAtTrig(&view->trig_pos));
+
+    pos = acq_GetNormalizedDataPos(pos);
+    view->span[0] = &raw_buffer[pos];
+    view->span_size[0] = MIN(size, ADC_BUFFER_SIZE - pos);
+    view->span_size[1] = size - view->span_size[0];
+    view->span[1] = view->span_size[1] ? raw_buffer : NULL;
+
+    return RP_OK;
+}
+
+int acq_IsRawViewValid(const rp_acq_view_t* view, bool* valid)
+{
+    bool writing;
+    uint32_t trig_pos;
+
+    ECHECK(osc_IsWritingDataIntoMemory(&writing));
+    ECHECK(acq_GetWritePointerAtTrig(&trig_pos));
+
+    *valid = !writing
+          && trig_pos == view->trig_pos
+          && __atomic_load_n(&acq_generation, __ATOMIC_ACQUIRE) == view->generation;
+
+    return RP_OK;
+}
+
 int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t *buffer_size)
 {
     uint32_t size = getSizeFromStartEndPos(start_pos, end_pos);
@@ -779,71 +1068,154 @@ int acq_GetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
     return acq_GetDataRaw(channel, pos, size, buffer);
 }
 
+/**
+ * Returns the count to voltage table for the current gain of a channel.
+ * A new table is built when the gain voltage, the calibrated full scale or the
+ * calibrated DC offset differ from the ones the published table was built with,
+ * which covers gain changes as well as writing or recalibrating the front end
+ * parameters. The table stays unchanged until putVoltLut(), so a conversion
+ * uses one scaling for all of its samples. The new table is built in the
+ * slot's spare outside the lock; if a conversion still holds the spare, the
+ * call waits for it to finish.
+ */
+static volt_lut_t* getVoltLut(rp_channel_t channel)
+{
+    acq_scale_t scale;
+    getScale(channel, &scale);
+
+    volt_lut_slot_t* slot = &volt_lut[channel == RP_CH_1 ? 0 : 1][scale.gain == RP_HIGH ? 1 : 0];
+
+    pthread_mutex_lock(&volt_lut_mutex);
+    volt_lut_t* table;
+    for (;;) {
+        table = slot->current;
+        if (table && table->gainV == scale.gainV && table->calibScale == scale.calibScale && table->dc_offs == scale.dc_offs) {
+            table->refs++;
+            pthread_mutex_unlock(&volt_lut_mutex);
+            return table;
+        }
+        table = slot->current == &slot->tables[0] ? &slot->tables[1] : &slot->tables[0];
+        if (table->refs == 0) {
+            break;
+        }
+        pthread_cond_wait(&volt_lut_free, &volt_lut_mutex);
+    }
+    // The reference keeps other callers out of the spare while it is built
+    table->refs = 1;
+    pthread_mutex_unlock(&volt_lut_mutex);
+
+    for (uint32_t cnts = 0; cnts < VOLT_LUT_SIZE; ++cnts) {
+        table->volts[cnts] = cmn_CnvCntToV(ADC_BITS, cnts, scale.gainV, scale.calibScale, scale.dc_offs, 0.0);
+    }
+    table->gainV = scale.gainV;
+    table->calibScale = scale.calibScale;
+    table->dc_offs = scale.dc_offs;
+
+    pthread_mutex_lock(&volt_lut_mutex);
+    if (slot->current && --slot->current->refs == 0) {
+        pthread_cond_broadcast(&volt_lut_free);
+    }
+    table->refs++;
+    slot->current = table;
+    pthread_mutex_unlock(&volt_lut_mutex);
+
+    return table;
+}
+
+/* Releases a table returned by getVoltLut() */
+static void putVoltLut(volt_lut_t* lut)
+{
+    pthread_mutex_lock(&volt_lut_mutex);
+    if (--lut->refs == 0) {
+        pthread_cond_broadcast(&volt_lut_free);
+    }
+    pthread_mutex_unlock(&volt_lut_mutex);
+}
+
 int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buffer)
 {
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    float gainV;
-    rp_pinState_t gain;
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    volt_lut_t* table = getVoltLut(channel);
+    const float* lut = table->volts;
 
+    uint32_t burst[ACQ_BURST_SIZE];
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
 
-    uint32_t cnts;
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = raw_buffer[(pos + i) % ADC_BUFFER_SIZE];
-        buffer[i] = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    pos = acq_GetNormalizedDataPos(pos);
+    for (uint32_t i = 0; i < (*size); ) {
+        uint32_t len = readRawBurst(raw_buffer, &pos, (*size) - i, burst);
+        for (uint32_t j = 0; j < len; ++j) {
+            buffer[i + j] = lut[burst[j] & ADC_BITS_MAK];
+        }
+        i += len;
     }
 
+    putVoltLut(table);
     return RP_OK;
 }
 
 int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
 {
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+    uint32_t scratch[RP_ACQ_SCRATCH_SIZE / sizeof(uint32_t)];
+    return acq_GetDataV2Scratch(pos, size, buffer1, buffer2, scratch, sizeof(scratch));
+}
 
-    float gainV1, gainV2;
-    rp_pinState_t gain1, gain2;
-    ECHECK(acq_GetGainV(RP_CH_1, &gainV1));
-    ECHECK(acq_GetGain(RP_CH_1, &gain1));
-    ECHECK(acq_GetGainV(RP_CH_2, &gainV2));
-    ECHECK(acq_GetGain(RP_CH_2, &gain2));
+/* Reads both channels in volts, adding them to the buffers instead of storing when 'add' is set */
+static int getDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2, void* scratch, uint32_t scratch_size, bool add)
+{
+    // Scratch holds one burst of each channel
+    uint32_t burst_size = MIN(scratch_size / (2 * sizeof(uint32_t)), ADC_BUFFER_SIZE);
+    if (burst_size == 0) {
+        return RP_EOOR;
+    }
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs1 = gain1 == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
-    uint32_t calibScale1 = calib_GetFrontEndScale(RP_CH_1, gain1);
+    *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    int32_t dc_offs2 = gain2 == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs;
-    uint32_t calibScale2 = calib_GetFrontEndScale(RP_CH_2, gain2);
+    volt_lut_t* table1 = getVoltLut(RP_CH_1);
+    volt_lut_t* table2 = getVoltLut(RP_CH_2);
+    const float* lut1 = table1->volts;
+    const float* lut2 = table2->volts;
 
+    uint32_t* burst1 = (uint32_t*) scratch;
+    uint32_t* burst2 = burst1 + burst_size;
     const volatile uint32_t* raw_buffer1 = getRawBuffer(RP_CH_1);
     const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
 
-    uint32_t cnts1[*size];
-    uint32_t cnts2[*size];
-    uint32_t* ptr1 = cnts1;
-    uint32_t* ptr2 = cnts2;
-
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *ptr1++ = raw_buffer1[pos];
-        *ptr2++ = raw_buffer2[pos];
-        pos = (pos + 1) % ADC_BUFFER_SIZE;
+    pos = acq_GetNormalizedDataPos(pos);
+    for (uint32_t i = 0; i < (*size); ) {
+        uint32_t pos2 = pos;
+        uint32_t len = readRawBurst(raw_buffer1, &pos, MIN((*size) - i, burst_size), burst1);
+        readRawBurst(raw_buffer2, &pos2, len, burst2);
+        if (add) {
+            for (uint32_t j = 0; j < len; ++j) {
+                buffer1[i + j] += lut1[burst1[j] & ADC_BITS_MAK];
+                buffer2[i + j] += lut2[burst2[j] & ADC_BITS_MAK];
+            }
+        }
+        else {
+            for (uint32_t j = 0; j < len; ++j) {
+                buffer1[i + j] = lut1[burst1[j] & ADC_BITS_MAK];
+                buffer2[i + j] = lut2[burst2[j] & ADC_BITS_MAK];
+            }
+        }
+        i += len;
     }
 
-    ptr1 = cnts1;
-    ptr2 = cnts2;
+    putVoltLut(table1);
+    putVoltLut(table2);
+    return RP_OK;
+}
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *buffer1++ = cmn_CnvCntToV(ADC_BITS, *ptr1++, gainV1, calibScale1, dc_offs1, 0.0);
-        *buffer2++ = cmn_CnvCntToV(ADC_BITS, *ptr2++, gainV2, calibScale2, dc_offs2, 0.0);
-    }
+int acq_GetDataV2Scratch(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2, void* scratch, uint32_t scratch_size)
+{
+    return getDataV2(pos, size, buffer1, buffer2, scratch, scratch_size, false);
+}
 
-    return RP_OK;
+int acq_AddDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
+{
+    uint32_t scratch[RP_ACQ_SCRATCH_SIZE / sizeof(uint32_t)];
+    return getDataV2(pos, size, buffer1, buffer2, scratch, sizeof(scratch), true);
 }
 
 int acq_GetDataPosV(rp_channel_t channel,  uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t *buffer_size)
@@ -887,6 +1259,75 @@ int acq_GetBufferSize(uint32_t *size) {
     return RP_OK;
 }
 
+/**
+ * Reads the acquisition settings from the configuration register copy, without bus reads
+ */
+int acq_GetConfig(rp_acq_config_t* config)
+{
+    ECHECK(acq_GetDecimation(&config->decimation));
+    ECHECK(acq_GetAveraging(&config->averaging));
+    ECHECK(acq_GetTriggerDelay(&config->trigger_delay));
+    for (int ch = 0; ch < 2; ++ch) {
+        ECHECK(acq_GetGain(ch, &config->gain[ch]));
+        ECHECK(acq_GetChannelThreshold(ch, &config->threshold[ch]));
+        ECHECK(acq_GetChannelThresholdHyst(ch, &config->hysteresis[ch]));
+    }
+    return RP_OK;
+}
+
+/**
+ * Applies all acquisition settings, validating them before any register is written.
+ * The register copy is reloaded first, so registers another process changed are rewritten.
+ */
+int acq_Configure(const rp_acq_config_t* config)
+{
+    uint32_t decimation, thr[2], hyst[2];
+
+    // Validate and convert everything first, so a bad parameter leaves the FPGA untouched
+    ECHECK(getDecimationFactor(config->decimation, &decimation));
+    for (int ch = 0; ch < 2; ++ch) {
+        if (config->gain[ch] != RP_LOW && config->gain[ch] != RP_HIGH) {
+            return RP_EOOR;
+        }
+        ECHECK(cnvThresholdToCnts(ch, config->gain[ch], config->threshold[ch], &thr[ch]));
+        ECHECK(cnvThresholdToCnts(ch, config->gain[ch], config->hysteresis[ch], &hyst[ch]));
+        thr[ch] &= (1 << ADC_BITS) - 1;
+        if (hyst[ch] & ~((1 << ADC_BITS) - 1)) {
+            return RP_EOOR;
+        }
+    }
+
+    int32_t trig_dly = MAX(config->trigger_delay, -TRIG_DELAY_ZERO_OFFSET) + TRIG_DELAY_ZERO_OFFSET;
+
+    // The shadowed setters only write registers whose value changes
+    ECHECK(osc_LoadShadow());
+    ECHECK(osc_SetDecimation(decimation));
+    ECHECK(osc_SetAveraging(config->averaging));
+    ECHECK(osc_SetTriggerDelay(trig_dly));
+    ECHECK(osc_SetThresholdChA(thr[RP_CH_1]));
+    ECHECK(osc_SetThresholdChB(thr[RP_CH_2]));
+    ECHECK(osc_SetHysteresisChA(hyst[RP_CH_1]));
+    ECHECK(osc_SetHysteresisChB(hyst[RP_CH_2]));
+    ECHECK(setEqFilters(RP_CH_1, config->gain[RP_CH_1]));
+    ECHECK(setEqFilters(RP_CH_2, config->gain[RP_CH_2]));
+
+    acq_state_t* state = acqWriteBegin();
+    state->gain[0] = config->gain[RP_CH_1];
+    state->gain[1] = config->gain[RP_CH_2];
+    state->trig_delay_in_ns = false;
+    acqWriteEnd();
+
+    return RP_OK;
+}
+
+/**
+ * Reloads the configuration register copy from the FPGA
+ */
+int acq_SyncShadow()
+{
+    return osc_LoadShadow();
+}
+
 /**
  * Sets default configuration
  * @return
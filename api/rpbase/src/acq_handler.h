@@ -34,6 +34,8 @@ int acq_GetAveraging(bool* enable);
 int acq_SetTriggerSrc(rp_acq_trig_src_t source);
 int acq_GetTriggerSrc(rp_acq_trig_src_t* source);
 int acq_GetTriggerState(rp_acq_trig_state_t* state);
+int acq_WaitTrigger(uint64_t timeout_ns, uint64_t* latency_ns);
+int acq_WaitCaptured(uint64_t timeout_ns);
 int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue);
 int acq_GetTriggerDelay(int32_t* decimated_data_num);
 int acq_SetTriggerDelayNs(int64_t time_ns, bool updateMaxValue);
@@ -56,17 +58,26 @@ int acq_Reset();
 uint32_t acq_GetNormalizedDataPos(uint32_t pos);
 int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t *buffer_size);
 int acq_GetDataPosV(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t *buffer_size);
+int acq_GetDcOffset(rp_channel_t channel, int32_t* dc_offs);
 int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
 int acq_GetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* buffer2);
+int acq_GetRawView(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_view_t* view);
+int acq_IsRawViewValid(const rp_acq_view_t* view, bool* valid);
 int acq_GetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer);
 int acq_GetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer);
 int acq_GetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
 int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2);
+int acq_GetDataV2Scratch(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2, void* scratch, uint32_t scratch_size);
+int acq_AddDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2);
 int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
 
+int acq_GetConfig(rp_acq_config_t* config);
+int acq_Configure(const rp_acq_config_t* config);
+int acq_SyncShadow();
+
 int acq_SetDefault();
 
 
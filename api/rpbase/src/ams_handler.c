@@ -0,0 +1,333 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library analog mixed signals sampler implementation
+ *
+ * The slow analog inputs, the die temperature and the FPGA supplies are
+ * read through the XADC driver. The sampler opens the system file of every
+ * channel once and rereads it from the start on every sweep, instead of
+ * opening it for each value. A thread sweeps all channels once per period
+ * and publishes the values, moving averages and extremes in a snapshot
+ * guarded by a sequence counter: readers copy it without taking a lock and
+ * retry when a sweep was published meanwhile.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "analog_mixed_signals.h"
+#include "simulator.h"
+#include "ams_handler.h"
+
+/* @brief Directory of the XADC driver attributes. */
+#define AMS_XADC_PATH       "/sys/devices/soc0/amba_pl/83c00000.xadc_wiz/iio:device1/"
+
+/* @brief Volts per count of the analog inputs, as rp_AIpinGetValue() converts them. */
+#define AMS_AIN_SCALE       ((ANALOG_IN_MAX_VAL - ANALOG_IN_MIN_VAL) / ANALOG_IN_MAX_VAL_INTEGER)
+
+/* @brief Counts added to an analog input reading so that zero counts read as ANALOG_IN_MIN_VAL. */
+#define AMS_AIN_OFFSET      (ANALOG_IN_MIN_VAL / AMS_AIN_SCALE)
+
+/* @brief Largest number of sweeps averaged. */
+#define AMS_WINDOW_MAX      4096
+
+/* Driver attributes of a channel */
+typedef struct {
+    const char* raw;        // reading in counts
+    const char* scale;      // milli units per count, NULL for the analog inputs
+    const char* offset;     // counts added before scaling, or NULL
+} ams_source_t;
+
+static const ams_source_t ams_sources[RP_AMS_CHANNELS] = {
+    [RP_AMS_AIN0]    = { "in_voltage11_raw" },
+    [RP_AMS_AIN1]    = { "in_voltage9_raw" },
+    [RP_AMS_AIN2]    = { "in_voltage10_raw" },
+    [RP_AMS_AIN3]    = { "in_voltage12_raw" },
+    [RP_AMS_TEMP]    = { "in_temp0_raw", "in_temp0_scale", "in_temp0_offset" },
+    [RP_AMS_VCCINT]  = { "in_voltage0_vccint_raw", "in_voltage0_vccint_scale" },
+    [RP_AMS_VCCAUX]  = { "in_voltage1_vccaux_raw", "in_voltage1_vccaux_scale" },
+    [RP_AMS_VCCBRAM] = { "in_voltage2_vccbram_raw", "in_voltage2_vccbram_scale" }
+};
+
+/* Open channel: value = (counts + offset) * scale */
+typedef struct {
+    bool available;
+    int fd;
+    double scale;
+    double offset;
+} ams_input_t;
+
+static struct {
+    bool started;
+    uint64_t period_ns;
+    uint32_t window;
+    ams_input_t inputs[RP_AMS_CHANNELS];
+    float* history;             // values of the last 'window' sweeps
+    uint32_t head;              // slot of the next sweep in 'history'
+    double sum[RP_AMS_CHANNELS];
+    uint32_t reset;             // incremented by ams_ResetMinMax()
+    uint32_t reset_seen;
+    uint32_t seq;               // guards 'snapshot'
+    rp_ams_snapshot_t snapshot;
+    cmn_worker_t worker;        // stopped by ams_SamplerStop()
+} sampler;
+
+
+/* Reads the number in a driver attribute from its start */
+static bool ams_ReadNumber(int fd, double* value)
+{
+    char buf[32];
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    char* end;
+    *value = strtod(buf, &end);
+    return end != buf;
+}
+
+static int ams_OpenAttribute(const char* name)
+{
+    char path[128];
+    snprintf(path, sizeof(path), AMS_XADC_PATH "%s", name);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+/* Reads a driver attribute that does not change, such as a scale */
+static bool ams_ReadConstant(const char* name, double* value)
+{
+    int fd = ams_OpenAttribute(name);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = ams_ReadNumber(fd, value);
+    close(fd);
+    return ok;
+}
+
+static void ams_Open(rp_ams_channel_t channel, ams_input_t* input)
+{
+    const ams_source_t* source = &ams_sources[channel];
+    *input = (ams_input_t) { .fd = -1, .scale = AMS_AIN_SCALE, .offset = AMS_AIN_OFFSET };
+
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        input->available = true;
+        return;
+    }
+    if (source->scale != NULL) {
+        if (!ams_ReadConstant(source->scale, &input->scale)) {
+            return;
+        }
+        input->scale /= 1000;
+        input->offset = 0;
+    }
+    if (source->offset != NULL && !ams_ReadConstant(source->offset, &input->offset)) {
+        return;
+    }
+    input->fd = ams_OpenAttribute(source->raw);
+    input->available = input->fd != -1;
+}
+
+static void ams_Close(ams_input_t* input)
+{
+    if (input->fd != -1) {
+        close(input->fd);
+    }
+    *input = (ams_input_t) { .fd = -1 };
+}
+
+static bool ams_Read(rp_ams_channel_t channel, const ams_input_t* input, float* value)
+{
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        return sim_AmsRead(channel, value) == RP_OK;
+    }
+    double counts;
+    if (!ams_ReadNumber(input->fd, &counts)) {
+        return false;
+    }
+    *value = (counts + input->offset) * input->scale;
+    return true;
+}
+
+/**
+ * Reads all channels and publishes them. A channel that fails to read
+ * repeats its previous value; the first sweep decides which channels are
+ * available.
+ */
+static void ams_Sweep()
+{
+    float values[RP_AMS_CHANNELS];
+    bool first = sampler.snapshot.sweeps == 0;
+
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        ams_input_t* input = &sampler.inputs[c];
+        if (!input->available) {
+            continue;
+        }
+        if (!ams_Read(c, input, &values[c])) {
+            if (first) {
+                ams_Close(input);
+                continue;
+            }
+            values[c] = sampler.snapshot.channel[c].value;
+        }
+    }
+
+    uint32_t reset = __atomic_load_n(&sampler.reset, __ATOMIC_RELAXED);
+    bool restart = first || reset != sampler.reset_seen;
+    sampler.reset_seen = reset;
+    uint64_t sweeps = sampler.snapshot.sweeps + 1;
+    uint32_t count = sweeps < sampler.window ? sweeps : sampler.window;
+    float* slot = &sampler.history[sampler.head * RP_AMS_CHANNELS];
+
+    cmn_SeqWriteBegin(&sampler.seq);
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        if (!sampler.inputs[c].available) {
+            continue;
+        }
+        float value = values[c];
+        rp_ams_stat_t* stat = &sampler.snapshot.channel[c];
+        // The slot holds the value of 'window' sweeps ago once the history is full
+        if (sweeps > sampler.window) {
+            sampler.sum[c] -= slot[c];
+        }
+        slot[c] = value;
+        sampler.sum[c] += value;
+
+        stat->value = value;
+        stat->average = sampler.sum[c] / count;
+        stat->min = restart ? value : fminf(stat->min, value);
+        stat->max = restart ? value : fmaxf(stat->max, value);
+    }
+    sampler.snapshot.sweeps = sweeps;
+    sampler.snapshot.timestamp_ns = cmn_NowNs();
+    cmn_SeqWriteEnd(&sampler.seq);
+
+    sampler.head = (sampler.head + 1) % sampler.window;
+}
+
+static void* ams_Worker(void* arg)
+{
+    uint64_t next = cmn_NowNs() + sampler.period_ns;
+
+    while (cmn_WorkerIsRunning(&sampler.worker)) {
+        cmn_WorkerWaitUntil(&sampler.worker, next, 0);
+        if (!cmn_WorkerIsRunning(&sampler.worker)) {
+            break;
+        }
+        ams_Sweep();
+
+        // Sweeps that were missed are skipped, the schedule keeps its phase
+        uint64_t now = cmn_NowNs();
+        next += sampler.period_ns;
+        if (next <= now) {
+            next += ((now - next) / sampler.period_ns + 1) * sampler.period_ns;
+        }
+    }
+    return NULL;
+}
+
+static void ams_Cleanup()
+{
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        ams_Close(&sampler.inputs[c]);
+    }
+    free(sampler.history);
+    sampler.history = NULL;
+}
+
+int ams_SamplerStart(uint32_t period_us, uint32_t window)
+{
+    if (sampler.started) {
+        return RP_EUF;
+    }
+    if (period_us == 0 || window == 0 || window > AMS_WINDOW_MAX) {
+        return RP_EOOR;
+    }
+
+    sampler.history = malloc((size_t) window * RP_AMS_CHANNELS * sizeof(float));
+    if (sampler.history == NULL) {
+        return RP_EOOR;
+    }
+    sampler.period_ns = (uint64_t) period_us * 1000;
+    sampler.window = window;
+    sampler.head = 0;
+    sampler.reset_seen = __atomic_load_n(&sampler.reset, __ATOMIC_RELAXED);
+
+    cmn_SeqWriteBegin(&sampler.seq);
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        sampler.sum[c] = 0;
+        sampler.snapshot.channel[c] = (rp_ams_stat_t) { NAN, NAN, NAN, NAN };
+    }
+    sampler.snapshot.sweeps = 0;
+    sampler.snapshot.timestamp_ns = 0;
+    cmn_SeqWriteEnd(&sampler.seq);
+
+    bool any = false;
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        ams_Open(c, &sampler.inputs[c]);
+    }
+    ams_Sweep();
+    for (int c = 0; c < RP_AMS_CHANNELS; ++c) {
+        any |= sampler.inputs[c].available;
+    }
+    if (!any) {
+        ams_Cleanup();
+        return RP_EOMD;
+    }
+
+    if (cmn_WorkerStart(&sampler.worker, 0, ams_Worker) != RP_OK) {
+        ams_Cleanup();
+        return RP_EOOR;
+    }
+
+    sampler.started = true;
+    return RP_OK;
+}
+
+int ams_SamplerStop()
+{
+    if (!sampler.started) {
+        return RP_OK;
+    }
+
+    cmn_WorkerStop(&sampler.worker);
+
+    ams_Cleanup();
+    sampler.started = false;
+    return RP_OK;
+}
+
+int ams_ResetMinMax()
+{
+    if (!sampler.started) {
+        return RP_EUF;
+    }
+    __atomic_fetch_add(&sampler.reset, 1, __ATOMIC_RELAXED);
+    return RP_OK;
+}
+
+int ams_GetAll(rp_ams_snapshot_t* snapshot)
+{
+    if (!sampler.started) {
+        return RP_EUF;
+    }
+    uint32_t seq;
+    do {
+        seq = cmn_SeqReadBegin(&sampler.seq);
+        *snapshot = sampler.snapshot;
+    } while (cmn_SeqReadRetry(&sampler.seq, seq));
+    return RP_OK;
+}
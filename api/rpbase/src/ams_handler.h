@@ -0,0 +1,27 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library analog mixed signals sampler interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_AMS_HANDLER_H_
+#define SRC_AMS_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+int ams_SamplerStart(uint32_t period_us, uint32_t window);
+int ams_SamplerStop();
+int ams_ResetMinMax();
+int ams_GetAll(rp_ams_snapshot_t* snapshot);
+
+#endif /* SRC_AMS_HANDLER_H_ */
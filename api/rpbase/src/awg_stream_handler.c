@@ -0,0 +1,314 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming generator playback implementation
+ *
+ * The AWG buffer of the channel is played as a ring of two halves. Samples
+ * written by the user go through a single producer, single consumer queue
+ * without locks. A refill thread follows the read pointer of the generator
+ * and, once the pointer has left a half, writes the next half of the stream
+ * into it. A refill that finds too few samples queued pads with 0 V and is
+ * counted as an underrun, one that comes after the pointer has entered the
+ * half counts as late, as old samples were played again.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "generate.h"
+#include "gen_handler.h"
+#include "simulator.h"
+#include "awg_stream_handler.h"
+
+/* @brief Samples in one half of the AWG buffer, the unit of refills. */
+#define AWG_HALF            (BUFFER_LENGTH / 2)
+
+/* @brief Limits of the refill polling period, in [ns]. */
+#define AWG_POLL_MIN_NS     20000
+#define AWG_POLL_MAX_NS     1000000
+
+static struct {
+    bool running;
+    bool playing;           // set once the writer has loaded the first buffer
+    rp_gen_stream_config_t config;
+    uint64_t poll_ns;
+    float* queue;
+    uint64_t write_idx;     // samples queued by the writer
+    uint64_t read_idx;      // samples taken from the queue
+    pthread_t thread;
+    uint64_t played;
+    uint64_t underruns;
+    uint64_t missing;
+    uint64_t late_refills;
+    uint64_t worst_refill_ns;
+} awg;
+
+
+static uint64_t awg_Queued()
+{
+    return __atomic_load_n(&awg.write_idx, __ATOMIC_ACQUIRE) - __atomic_load_n(&awg.read_idx, __ATOMIC_ACQUIRE);
+}
+
+/* Takes up to 'size' samples from the queue, called by its current consumer only */
+static uint32_t awg_Pop(float* dst, uint32_t size)
+{
+    const uint32_t queue_size = awg.config.queue_size;
+    uint64_t r = awg.read_idx;
+    uint64_t w = __atomic_load_n(&awg.write_idx, __ATOMIC_ACQUIRE);
+    uint32_t n = MIN(size, w - r);
+    uint32_t pos = r & (queue_size - 1);
+    uint32_t first = MIN(n, queue_size - pos);
+
+    memcpy(dst, awg.queue + pos, first * sizeof(float));
+    memcpy(dst + first, awg.queue, (n - first) * sizeof(float));
+    __atomic_store_n(&awg.read_idx, r + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+/**
+ * Loads the first buffer and lets the pointer go. Called by the writer, which
+ * is the only consumer of the queue until the refill thread takes over, so
+ * playback begins within the write that completes the first buffer.
+ */
+static void awg_Play()
+{
+    const rp_channel_t channel = awg.config.channel;
+    float data[BUFFER_LENGTH];
+
+    awg_Pop(data, BUFFER_LENGTH);
+    generate_writeBlock(channel, data, 0, BUFFER_LENGTH);
+    generate_setReset(channel, false);
+    triggerIfInternal(channel);
+    __atomic_store_n(&awg.playing, true, __ATOMIC_RELEASE);
+}
+
+static void* awg_Worker(void* arg)
+{
+    const rp_channel_t channel = awg.config.channel;
+    const double rate = awg.config.sample_rate;
+    float data[AWG_HALF];
+
+    // Until playback begins the writer is the consumer of the queue
+    while (awg_StreamIsRunning() && !__atomic_load_n(&awg.playing, __ATOMIC_ACQUIRE)) {
+        cmn_SleepNs(awg.poll_ns);
+    }
+
+    uint64_t filled = BUFFER_LENGTH;    // stream samples written into the buffer
+    uint64_t pos = 0;                   // stream samples the pointer has passed
+    uint32_t last = 0;
+    uint64_t prev = cmn_NowNs();
+
+    while (awg_StreamIsRunning()) {
+        uint32_t cur;
+        generate_getReadPointer(channel, &cur);
+        uint64_t now = cmn_NowNs();
+        uint64_t delta = (cur + BUFFER_LENGTH - last) % BUFFER_LENGTH;
+        last = cur;
+
+        /* The pointer alone cannot tell a full lap of the buffer, so on the
+         * board the time since the last poll is checked as well. The simulated
+         * pointer only moves on rp_SimStep(). */
+        if (cmn_GetBackend() == RP_BACKEND_DEVMEM) {
+            uint64_t elapsed = (uint64_t) ((now - prev) * rate / 1e9);
+            if (elapsed >= delta + BUFFER_LENGTH / 2) {
+                delta += (elapsed - delta + BUFFER_LENGTH / 2) / BUFFER_LENGTH * BUFFER_LENGTH;
+            }
+        }
+        pos += delta;
+
+        if (pos >= filled) {
+            // Old samples were played again; refill the half after the one playing now
+            __atomic_add_fetch(&awg.late_refills, (pos - filled) / AWG_HALF + 1, __ATOMIC_RELAXED);
+            filled = (pos / AWG_HALF + 1) * AWG_HALF;
+        }
+
+        // The oldest half of the buffer has been played
+        while (pos + BUFFER_LENGTH >= filled + AWG_HALF) {
+            uint64_t queued = awg_Queued();
+            if (queued < AWG_HALF && filled - pos > AWG_HALF / 2) {
+                // The writer may still catch up before the pointer gets there
+                break;
+            }
+
+            uint32_t n = awg_Pop(data, AWG_HALF);
+            if (n < AWG_HALF) {
+                memset(data + n, 0, (AWG_HALF - n) * sizeof(float));
+                __atomic_add_fetch(&awg.underruns, 1, __ATOMIC_RELAXED);
+                __atomic_add_fetch(&awg.missing, AWG_HALF - n, __ATOMIC_RELAXED);
+            }
+            generate_writeBlock(channel, data, filled % BUFFER_LENGTH, AWG_HALF);
+            filled += AWG_HALF;
+
+            // The half may have been freed right after the previous poll
+            uint64_t latency = cmn_NowNs() - prev;
+            if (latency > awg.worst_refill_ns) {
+                __atomic_store_n(&awg.worst_refill_ns, latency, __ATOMIC_RELAXED);
+            }
+        }
+
+        __atomic_store_n(&awg.played, pos, __ATOMIC_RELAXED);
+        prev = now;
+        cmn_SleepNs(awg.poll_ns);
+    }
+
+    return NULL;
+}
+
+/* Holds the channel in reset and prepares it to play the ring buffer at the stream rate */
+static int awg_SetupChannel(rp_channel_t channel, float sample_rate)
+{
+    static const float silence[BUFFER_LENGTH];
+    ECHECK(generate_setReset(channel, true));
+    ECHECK(gen_setGenMode(channel, RP_GEN_MODE_CONTINUOUS));
+    ECHECK(generate_setPhase(channel, 0, BUFFER_LENGTH));
+    ECHECK(generate_setWrapCounter(channel, BUFFER_LENGTH));
+    // One period of the whole buffer at sample_rate / BUFFER_LENGTH plays a sample every 1 / sample_rate
+    ECHECK(generate_setCounterStep(channel, generate_cnvFrequency(sample_rate / BUFFER_LENGTH)));
+    ECHECK(generate_writeBlock(channel, silence, 0, BUFFER_LENGTH));
+    return RP_OK;
+}
+
+/**
+ * Frees the queue, releases the reset and brings back the signal configured on
+ * the channel, whatever part of awg_StreamStart() succeeded.
+ */
+static int awg_Teardown()
+{
+    free(awg.queue);
+    awg.queue = NULL;
+
+    int ret = generate_setReset(awg.config.channel, false);
+    int ret_reload = gen_Reload(awg.config.channel);
+    return ret != RP_OK ? ret : ret_reload;
+}
+
+int awg_StreamStart(const rp_gen_stream_config_t* config)
+{
+    if (awg.running) {
+        return RP_EUF;
+    }
+    if (config->channel != RP_CH_1 && config->channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (!(config->sample_rate > 0) || config->sample_rate > DAC_FREQUENCY) {
+        return RP_EOOR;
+    }
+    if (config->queue_size < BUFFER_LENGTH || (config->queue_size & (config->queue_size - 1)) != 0) {
+        return RP_EIPV;
+    }
+
+    awg.queue = malloc((size_t) config->queue_size * sizeof(float));
+    if (awg.queue == NULL) {
+        return RP_EOOR;
+    }
+
+    awg.config = *config;
+    awg.playing = false;
+    awg.write_idx = 0;
+    awg.read_idx = 0;
+    awg.played = 0;
+    awg.underruns = 0;
+    awg.missing = 0;
+    awg.late_refills = 0;
+    awg.worst_refill_ns = 0;
+
+    // Poll about four times per half buffer
+    awg.poll_ns = (uint64_t) (AWG_HALF * 1e9 / config->sample_rate / 4);
+    awg.poll_ns = MAX(MIN(awg.poll_ns, AWG_POLL_MAX_NS), AWG_POLL_MIN_NS);
+
+    int ret = awg_SetupChannel(config->channel, config->sample_rate);
+    if (ret == RP_OK) {
+        // The simulated generator only sees the reset level when it is stepped
+        if (cmn_GetBackend() == RP_BACKEND_SIM) {
+            sim_Step(0);
+        }
+
+        awg.running = true;
+        if (pthread_create(&awg.thread, NULL, awg_Worker, NULL) != 0) {
+            awg.running = false;
+            ret = RP_EOOR;
+        }
+    }
+    if (ret != RP_OK) {
+        awg_Teardown();
+        return ret;
+    }
+
+    return RP_OK;
+}
+
+int awg_StreamWrite(const float* data, uint32_t* size, uint32_t timeout_us)
+{
+    if (!awg_StreamIsRunning()) {
+        return RP_EUF;
+    }
+
+    const uint32_t queue_size = awg.config.queue_size;
+    uint64_t deadline = cmn_NowNs() + (uint64_t) timeout_us * 1000;
+    uint32_t done = 0;
+
+    for (;;) {
+        uint64_t w = awg.write_idx;
+        uint64_t r = __atomic_load_n(&awg.read_idx, __ATOMIC_ACQUIRE);
+        uint32_t n = MIN(*size - done, queue_size - (w - r));
+        uint32_t pos = w & (queue_size - 1);
+        uint32_t first = MIN(n, queue_size - pos);
+
+        memcpy(awg.queue + pos, data + done, first * sizeof(float));
+        memcpy(awg.queue, data + done + first, (n - first) * sizeof(float));
+        __atomic_store_n(&awg.write_idx, w + n, __ATOMIC_RELEASE);
+        done += n;
+
+        if (!awg.playing && w + n >= BUFFER_LENGTH) {
+            awg_Play();
+        }
+        if (done == *size) {
+            return RP_OK;
+        }
+
+        uint64_t now = cmn_NowNs();
+        if (now >= deadline) {
+            *size = done;
+            return RP_ETIM;
+        }
+        cmn_SleepNs(MIN(awg.poll_ns, deadline - now));
+    }
+}
+
+int awg_StreamGetStats(rp_gen_stream_stats_t* stats)
+{
+    uint64_t worst = __atomic_load_n(&awg.worst_refill_ns, __ATOMIC_RELAXED);
+    stats->played = __atomic_load_n(&awg.played, __ATOMIC_RELAXED);
+    stats->queued = awg_Queued();
+    stats->underruns = __atomic_load_n(&awg.underruns, __ATOMIC_RELAXED);
+    stats->missing = __atomic_load_n(&awg.missing, __ATOMIC_RELAXED);
+    stats->late_refills = __atomic_load_n(&awg.late_refills, __ATOMIC_RELAXED);
+    // A refill must be done before the pointer has played the other half
+    stats->sustainable_rate = worst ? AWG_HALF * 1e9 / worst : DAC_FREQUENCY;
+    return RP_OK;
+}
+
+int awg_StreamStop()
+{
+    if (!__atomic_exchange_n(&awg.running, false, __ATOMIC_ACQ_REL)) {
+        return RP_OK;
+    }
+    pthread_join(awg.thread, NULL);
+
+    return awg_Teardown();
+}
+
+bool awg_StreamIsRunning()
+{
+    return __atomic_load_n(&awg.running, __ATOMIC_ACQUIRE);
+}
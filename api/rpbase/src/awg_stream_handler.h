@@ -0,0 +1,28 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming generator playback interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_AWG_STREAM_HANDLER_H_
+#define SRC_AWG_STREAM_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+int awg_StreamStart(const rp_gen_stream_config_t* config);
+int awg_StreamWrite(const float* data, uint32_t* size, uint32_t timeout_us);
+int awg_StreamGetStats(rp_gen_stream_stats_t* stats);
+int awg_StreamStop();
+bool awg_StreamIsRunning();
+
+#endif /* SRC_AWG_STREAM_HANDLER_H_ */
@@ -14,6 +14,7 @@
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
 #include "redpitaya/rp.h"
 #include "common.h"
 #include "generate.h"
@@ -26,12 +27,35 @@ int calib_ReadParams(rp_calib_params_t *calib_params);
 static const char eeprom_device[]="/sys/bus/i2c/devices/0-0050/eeprom";
 static const int  eeprom_calib_off=0x0008;
 
-// Cached parameter values.
+// Cached parameter values, published to readers through a seqlock.
 static rp_calib_params_t calib, failsafa_params;
+static uint32_t calib_seq = 0;
+static pthread_mutex_t calib_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// EEPROM contents used with the simulated backend
+static rp_calib_params_t sim_eeprom;
+static bool sim_eeprom_valid = false;
+
+static void calib_GetDefaultParams(rp_calib_params_t *calib_params);
+
+/**
+ * Replaces the cached parameters. Readers converting data never wait for it,
+ * they retry their copy when it overlapped with the update.
+ */
+static void calib_Publish(const rp_calib_params_t* params)
+{
+    pthread_mutex_lock(&calib_mutex);
+    cmn_SeqWriteBegin(&calib_seq);
+    calib = *params;
+    cmn_SeqWriteEnd(&calib_seq);
+    pthread_mutex_unlock(&calib_mutex);
+}
 
 int calib_Init()
 {
-    ECHECK(calib_ReadParams(&calib));
+    rp_calib_params_t params;
+    ECHECK(calib_ReadParams(&params));
+    calib_Publish(&params);
     return RP_OK;
 }
 
@@ -46,7 +70,13 @@ int calib_Release()
  */
 rp_calib_params_t calib_GetParams()
 {
-    return calib;
+    rp_calib_params_t params;
+    uint32_t seq;
+    do {
+        seq = cmn_SeqReadBegin(&calib_seq);
+        params = calib;
+    } while (cmn_SeqReadRetry(&calib_seq, seq));
+    return params;
 }
 
 /**
@@ -72,6 +102,17 @@ int calib_ReadParams(rp_calib_params_t *calib_params)
         return RP_UIA;
     }
 
+    /* simulated backend has no EEPROM, defaults are used until written */
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        if (!sim_eeprom_valid) {
+            calib_GetDefaultParams(&sim_eeprom);
+            sim_eeprom.magic = CALIB_MAGIC;
+            sim_eeprom_valid = true;
+        }
+        *calib_params = sim_eeprom;
+        return 0;
+    }
+
     /* open EEPROM device */
     fp = fopen(eeprom_device, "r");
     if(fp == NULL) {
@@ -127,6 +168,13 @@ int calib_WriteParams(rp_calib_params_t calib_params) {
     FILE   *fp;
     size_t  size;
 
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        sim_eeprom = calib_params;
+        sim_eeprom.magic = CALIB_MAGIC;
+        sim_eeprom_valid = true;
+        return RP_OK;
+    }
+
     /* open EEPROM device */
     fp = fopen(eeprom_device, "w+");
     if(fp == NULL) {
@@ -151,28 +199,38 @@ int calib_WriteParams(rp_calib_params_t calib_params) {
     return RP_OK;
 }
 
+/**
+ * Neutral calibration parameters - no offsets and nominal full scales.
+ */
+static void calib_GetDefaultParams(rp_calib_params_t *calib_params) {
+    calib_params->be_ch1_dc_offs = 0;
+    calib_params->be_ch2_dc_offs = 0;
+    calib_params->fe_ch1_lo_offs = 0;
+    calib_params->fe_ch2_lo_offs = 0;
+    calib_params->fe_ch1_hi_offs = 0;
+    calib_params->fe_ch2_hi_offs = 0;
+
+    calib_params->be_ch1_fs      = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->be_ch2_fs      = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
+    calib_params->fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    calib_params->fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
+    calib_params->fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+}
+
 void calib_SetToZero() {
-    calib.be_ch1_dc_offs = 0;
-    calib.be_ch2_dc_offs = 0;
-    calib.fe_ch1_lo_offs = 0;
-    calib.fe_ch2_lo_offs = 0;
-    calib.fe_ch1_hi_offs = 0;
-    calib.fe_ch2_hi_offs = 0;
-
-    calib.be_ch1_fs      = cmn_CalibFullScaleFromVoltage(1);
-    calib.be_ch2_fs      = cmn_CalibFullScaleFromVoltage(1);
-    calib.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
-    calib.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
-    calib.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
-    calib.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    rp_calib_params_t params;
+    calib_GetDefaultParams(&params);
+    calib_Publish(&params);
 }
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain) {
+    rp_calib_params_t params = calib_GetParams();
     if (gain == RP_HIGH) {
-        return (channel == RP_CH_1 ? calib.fe_ch1_fs_g_hi : calib.fe_ch2_fs_g_hi);
+        return (channel == RP_CH_1 ? params.fe_ch1_fs_g_hi : params.fe_ch2_fs_g_hi);
     }
     else {
-        return (channel == RP_CH_1 ? calib.fe_ch1_fs_g_lo : calib.fe_ch2_fs_g_lo);
+        return (channel == RP_CH_1 ? params.fe_ch1_fs_g_lo : params.fe_ch2_fs_g_lo);
     }
 }
 
@@ -192,7 +250,7 @@ int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_p
             params.fe_ch2_hi_offs = 0)
 	}
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
 	if (gain == RP_LOW) {
 		CHANNEL_ACTION(channel,
@@ -232,7 +290,7 @@ int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20),
             params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_LOW);
@@ -264,7 +322,7 @@ int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1),
             params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_HIGH);
@@ -296,7 +354,7 @@ int calib_SetBackEndOffset(rp_channel_t channel) {
             params.be_ch1_dc_offs = 0,
             params.be_ch2_dc_offs = 0)
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
     /* Generate zero signal */
     ECHECK(rp_GenReset());
@@ -324,7 +382,7 @@ int calib_SetBackEndScale(rp_channel_t channel) {
             params.be_ch1_fs = cmn_CalibFullScaleFromVoltage(1),
             params.be_ch2_fs = cmn_CalibFullScaleFromVoltage(1))
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
     /* Generate constant signal signal */
     ECHECK(rp_GenReset());
@@ -381,7 +439,7 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
             params.be_ch2_dc_offs = 0)
 
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_Publish(&params);
 
     float value1, value2;
     getGenAmp(channel, CONSTANT_SIGNAL_AMPLITUDE, &value1, &value2);
@@ -422,7 +480,7 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
 
 int calib_Reset() {
     calib_SetToZero();
-    ECHECK(calib_WriteParams(calib));
+    ECHECK(calib_WriteParams(calib_GetParams()));
     return calib_Init();
 }
 
@@ -504,7 +562,7 @@ int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* mi
 int calib_setCachedParams() {
 	fprintf(stderr, "write FAILSAFE PARAMS\n");
     ECHECK(calib_WriteParams(failsafa_params));
-    calib = failsafa_params;
+    calib_Publish(&failsafa_params);
 
     return 0;
 }
@@ -12,19 +12,62 @@
  * for more details on the language used herein.
  */
 
+#define _GNU_SOURCE
 #include <fcntl.h>
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
 #include <sys/mman.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
+#include <sched.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "common.h"
+#include "simulator.h"
+
+static int fd = -1;
+
+/* Backend used for register access, selected at initialization */
+static rp_backend_t backend = RP_BACKEND_DEVMEM;
+static bool backend_selected = false;
 
-static int fd = NULL;
+int cmn_SetBackend(rp_backend_t value)
+{
+    if (value != RP_BACKEND_DEVMEM && value != RP_BACKEND_SIM) {
+        return RP_EIPV;
+    }
+    backend = value;
+    backend_selected = true;
+    return RP_OK;
+}
+
+rp_backend_t cmn_GetBackend()
+{
+    return backend;
+}
 
 int cmn_Init()
 {
-    if (!fd) {
+    /* Unless selected explicitly, backend can be chosen with RP_BACKEND=sim */
+    if (!backend_selected) {
+        const char *env = getenv("RP_BACKEND");
+        backend = (env && strcmp(env, "sim") == 0) ? RP_BACKEND_SIM : RP_BACKEND_DEVMEM;
+    }
+
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Init();
+    }
+
+    if (fd == -1) {
         if((fd = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
         }
@@ -34,10 +77,15 @@ int cmn_Init()
 
 int cmn_Release()
 {
-    if (fd) {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Release();
+    }
+
+    if (fd != -1) {
         if(close(fd) < 0) {
             return RP_ECMD;
         }
+        fd = -1;
     }
 
     return RP_OK;
@@ -45,13 +93,18 @@ int cmn_Release()
 
 int cmn_Map(size_t size, size_t offset, void** mapped)
 {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Map(size, offset, mapped);
+    }
+
     if(fd == -1) {
         return RP_EMMD;
     }
 
     *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
 
-    if(mapped == (void *) -1) {
+    if(*mapped == MAP_FAILED) {
+        *mapped = NULL;
         return RP_EMMD;
     }
 
@@ -60,6 +113,13 @@ int cmn_Map(size_t size, size_t offset, void** mapped)
 
 int cmn_Unmap(size_t size, void** mapped)
 {
+    if (backend == RP_BACKEND_SIM) {
+        if((mapped == NULL) || (*mapped == NULL)) {
+            return RP_EUMD;
+        }
+        return sim_Unmap(size, mapped);
+    }
+
     if(fd == -1) {
         return RP_EUMD;
     }
@@ -79,6 +139,222 @@ int cmn_Unmap(size_t size, void** mapped)
     return RP_OK;
 }
 
+uint64_t cmn_NowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void cmn_SleepNs(uint64_t ns)
+{
+    struct timespec ts = { .tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * Opens the interrupt line with the given name. On the board interrupts are
+ * exported by the UIO driver, which lists the name of every device in sysfs.
+ */
+int cmn_IrqOpen(const char* name, int* irq_fd)
+{
+    if (backend == RP_BACKEND_SIM) {
+        return sim_IrqOpen(name, irq_fd);
+    }
+
+    for (int i = 0; i < CMN_UIO_MAX_DEVICES; ++i) {
+        char path[64];
+        char dev_name[64] = { 0 };
+
+        snprintf(path, sizeof(path), "/sys/class/uio/uio%d/name", i);
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        bool found = fgets(dev_name, sizeof(dev_name), f) != NULL
+                  && strncmp(dev_name, name, strlen(name)) == 0
+                  && (dev_name[strlen(name)] == '\n' || dev_name[strlen(name)] == '\0');
+        fclose(f);
+
+        if (found) {
+            snprintf(path, sizeof(path), "/dev/uio%d", i);
+            if ((*irq_fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC)) == -1) {
+                return RP_EOMD;
+            }
+            return RP_OK;
+        }
+    }
+    return RP_EOMD;
+}
+
+int cmn_IrqClose(int* irq_fd)
+{
+    if (*irq_fd == -1) {
+        return RP_OK;
+    }
+    if (backend == RP_BACKEND_SIM) {
+        return sim_IrqClose(irq_fd);
+    }
+    if (close(*irq_fd) < 0) {
+        return RP_ECMD;
+    }
+    *irq_fd = -1;
+    return RP_OK;
+}
+
+/**
+ * Discards interrupts that arrived so far and unmasks the line, so the next
+ * cmn_IrqWait() only returns for a new interrupt.
+ */
+int cmn_IrqEnable(int irq_fd)
+{
+    if (backend == RP_BACKEND_SIM) {
+        uint64_t count;
+        while (read(irq_fd, &count, sizeof(count)) == sizeof(count));
+        return RP_OK;
+    }
+
+    uint32_t count = 1;
+    while (read(irq_fd, &count, sizeof(count)) == sizeof(count));
+    count = 1;
+    if (write(irq_fd, &count, sizeof(count)) != sizeof(count)) {
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+/**
+ * Blocks until an interrupt arrives or the timeout expires. Returns RP_ETIM
+ * on timeout.
+ */
+int cmn_IrqWait(int irq_fd, uint64_t timeout_ns)
+{
+    struct pollfd pfd = { .fd = irq_fd, .events = POLLIN };
+    struct timespec timeout = { timeout_ns / 1000000000ULL, timeout_ns % 1000000000ULL };
+
+    int ret;
+    do {
+        ret = ppoll(&pfd, 1, &timeout, NULL);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        return RP_EOOR;
+    }
+    return ret == 0 ? RP_ETIM : RP_OK;
+}
+
+/**
+ * Starts the worker thread. With a real-time priority the thread is scheduled
+ * SCHED_FIFO, which keeps its timing when the system is loaded; where that is
+ * not permitted it runs with normal scheduling instead.
+ */
+int cmn_WorkerStart(cmn_worker_t* worker, int rt_priority, void* (*routine)(void*))
+{
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&worker->wake, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_mutex_init(&worker->mutex, NULL);
+
+    worker->running = true;
+    int ret = -1;
+    if (rt_priority > 0) {
+        pthread_attr_t attr;
+        struct sched_param param = { .sched_priority = rt_priority };
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+        ret = pthread_create(&worker->thread, &attr, routine, NULL);
+        pthread_attr_destroy(&attr);
+    }
+    if (ret != 0) {
+        ret = pthread_create(&worker->thread, NULL, routine, NULL);
+    }
+    if (ret != 0) {
+        worker->running = false;
+        pthread_cond_destroy(&worker->wake);
+        pthread_mutex_destroy(&worker->mutex);
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+bool cmn_WorkerIsRunning(cmn_worker_t* worker)
+{
+    return __atomic_load_n(&worker->running, __ATOMIC_ACQUIRE);
+}
+
+void cmn_WorkerDone(cmn_worker_t* worker)
+{
+    __atomic_store_n(&worker->running, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * Sleeps until 'spin_ns' before 'deadline', then spins until it has passed.
+ * Returns early when the worker is stopped.
+ */
+void cmn_WorkerWaitUntil(cmn_worker_t* worker, uint64_t deadline, uint64_t spin_ns)
+{
+    if (deadline > cmn_NowNs() + spin_ns) {
+        uint64_t wake = deadline - spin_ns;
+        struct timespec ts = { .tv_sec = wake / 1000000000ULL, .tv_nsec = wake % 1000000000ULL };
+        pthread_mutex_lock(&worker->mutex);
+        while (cmn_WorkerIsRunning(worker) && cmn_NowNs() < wake) {
+            pthread_cond_timedwait(&worker->wake, &worker->mutex, &ts);
+        }
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    while (cmn_NowNs() < deadline && cmn_WorkerIsRunning(worker)) {
+        CPU_RELAX();
+    }
+}
+
+/* Stops the worker, interrupting a wait, and joins the thread */
+void cmn_WorkerStop(cmn_worker_t* worker)
+{
+    pthread_mutex_lock(&worker->mutex);
+    __atomic_store_n(&worker->running, false, __ATOMIC_RELEASE);
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->mutex);
+    pthread_join(worker->thread, NULL);
+    pthread_cond_destroy(&worker->wake);
+    pthread_mutex_destroy(&worker->mutex);
+}
+
+/**
+ * Sequence counter of a seqlock: odd while the protected data is written.
+ * Writers must be serialized by the caller, readers copy the data between
+ * cmn_SeqReadBegin() and cmn_SeqReadRetry() and start over on a retry, so
+ * they never block a writer.
+ */
+void cmn_SeqWriteBegin(uint32_t* seq)
+{
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void cmn_SeqWriteEnd(uint32_t* seq)
+{
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t cmn_SeqReadBegin(const uint32_t* seq)
+{
+    uint32_t start;
+    while ((start = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1) {
+        CPU_RELAX();
+    }
+    return start;
+}
+
+bool cmn_SeqReadRetry(const uint32_t* seq, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(seq, __ATOMIC_RELAXED) != start;
+}
+
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSetShift)
 {
     VALIDATE_BITS(value, mask);
@@ -218,6 +494,98 @@ int32_t cmn_CalibCnts(uint32_t field_len, uint32_t cnts, int calib_dc_off)
     return m;
 }
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Copies 32-bit words out of device memory
+ *
+ * Device memory (FPGA buffers, the uncached DDR mapping) is read one aligned
+ * 32-bit word at a time, four per loop pass, rather than with memcpy, which may
+ * use wider or unaligned accesses.
+ *
+ * @param[out] dst Destination in cacheable memory
+ * @param[in] src Device memory, 4 byte aligned
+ * @param[in] words Number of words
+ */
+
+void cmn_CopyFromDevice(uint32_t *dst, const volatile uint32_t *src, uint32_t words)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        dst[i]     = ioread32(&src[i]);
+        dst[i + 1] = ioread32(&src[i + 1]);
+        dst[i + 2] = ioread32(&src[i + 2]);
+        dst[i + 3] = ioread32(&src[i + 3]);
+    }
+    for (; i < words; ++i) {
+        dst[i] = ioread32(&src[i]);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Converts a block of ADC/DAC/Buffer counts to calibrated counts
+ *
+ * Block version of cmn_CalibCnts(): masks the raw words to field_len bits,
+ * sign-extends them, subtracts the calibrated DC offset and clamps the result
+ * to the same limits. The input is expected in cacheable memory; a NEON or SSE2
+ * kernel is used when the compiler targets one, with a scalar tail.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits, at most 15
+ * @param[in] cnts Raw captured words
+ * @param[out] calib Calibrated counts
+ * @param[in] size Number of samples
+ * @param[in] calib_dc_off Calibrated DC offset, specified in ADC/DAC counts
+ */
+
+void cmn_CalibCntsBlock(uint32_t field_len, const uint32_t *cnts, int16_t *calib, uint32_t size, int calib_dc_off)
+{
+    const uint32_t mask = (1 << field_len) - 1;
+    const int32_t lim = 1 << (field_len - 1);
+    uint32_t i = 0;
+
+    /* beyond +-2^field_len every result saturates, so the offset fits 16 bits */
+    int16_t dc = (int16_t) MAX(MIN(calib_dc_off, 1 << field_len), -(1 << field_len));
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint32x4_t vmask = vdupq_n_u32(mask);
+    const int16x8_t vshift = vdupq_n_s16(16 - field_len);
+    const int16x8_t vnshift = vdupq_n_s16(-(int16_t)(16 - field_len));
+    const int16x8_t vdc = vdupq_n_s16(dc);
+    const int16x8_t vmin = vdupq_n_s16(-lim);
+    const int16x8_t vmax = vdupq_n_s16(lim);
+
+    for (; i + 8 <= size; i += 8) {
+        uint16x4_t lo = vmovn_u32(vandq_u32(vld1q_u32(cnts + i), vmask));
+        uint16x4_t hi = vmovn_u32(vandq_u32(vld1q_u32(cnts + i + 4), vmask));
+        int16x8_t m = vreinterpretq_s16_u16(vcombine_u16(lo, hi));
+        m = vshlq_s16(vshlq_s16(m, vshift), vnshift);
+        m = vqsubq_s16(m, vdc);
+        m = vminq_s16(vmaxq_s16(m, vmin), vmax);
+        vst1q_s16(calib + i, m);
+    }
+#elif defined(__SSE2__)
+    const __m128i vmask = _mm_set1_epi32(mask);
+    const __m128i vshift = _mm_cvtsi32_si128(16 - field_len);
+    const __m128i vdc = _mm_set1_epi16(dc);
+    const __m128i vmin = _mm_set1_epi16(-lim);
+    const __m128i vmax = _mm_set1_epi16(lim);
+
+    for (; i + 8 <= size; i += 8) {
+        __m128i lo = _mm_and_si128(_mm_loadu_si128((const __m128i*)(cnts + i)), vmask);
+        __m128i hi = _mm_and_si128(_mm_loadu_si128((const __m128i*)(cnts + i + 4)), vmask);
+        __m128i m = _mm_packs_epi32(lo, hi);
+        m = _mm_sra_epi16(_mm_sll_epi16(m, vshift), vshift);
+        m = _mm_subs_epi16(m, vdc);
+        m = _mm_min_epi16(_mm_max_epi16(m, vmin), vmax);
+        _mm_storeu_si128((__m128i*)(calib + i), m);
+    }
+#endif
+
+    for (; i < size; ++i) {
+        calib[i] = cmn_CalibCnts(field_len, cnts[i] & mask, calib_dc_off);
+    }
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Converts ADC/DAC/Buffer counts to voltage [V]
@@ -331,6 +699,110 @@ uint32_t cmn_CnvVToCnt(uint32_t field_len, float voltage, float adc_max_v, bool
     return (uint32_t)adc_cnts;
 }
 
+/**
+ * @brief Converts a block of voltages in [V] to DAC/Buffer counts
+ *
+ * Same as cmn_CnvVToCnt() without calibration scaling and user offset, for
+ * uploading whole waveforms: several samples are converted per instruction
+ * where NEON or SSE2 is available. Rounding is half away from zero, like
+ * round() in the scalar conversion, so both give identical counts. The range
+ * of the voltages is checked in the same pass, so user waveforms need not be
+ * scanned before they are converted.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits
+ * @param[in] voltage Voltages, specified in [V]
+ * @param[out] cnts Counts, negative values without the higher bits
+ * @param[in] size Number of samples
+ * @param[in] adc_max_v Maximal ADC/DAC voltage, specified in [V]
+ * @param[in] calib_dc_off Calibrated DC offset, specified in ADC/DAC counts
+ * @retval true All voltages are within +/- adc_max_v
+ * @retval false Some voltages were clipped, or are not numbers
+ */
+bool cmn_CnvVToCntBlock(uint32_t field_len, const float *voltage, uint32_t *cnts, uint32_t size, float adc_max_v, int calib_dc_off)
+{
+    uint32_t i = 0;
+    bool in_range = true;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__SSE2__)
+    const int32_t mask = (1 << field_len) - 1;
+    const int32_t lim = 1 << (field_len - 1);
+    const float scale = (float) (1 << field_len);
+    const float div = 2 * adc_max_v;
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t vmaxv = vdupq_n_f32(adc_max_v);
+    const float32x4_t vminv = vdupq_n_f32(-adc_max_v);
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vinv = vdupq_n_f32(1.0f / div);
+    const float32x4_t vhalf = vdupq_n_f32(0.5f);
+    const float32x4_t vnhalf = vdupq_n_f32(-0.5f);
+    const int32x4_t vdc = vdupq_n_s32(calib_dc_off);
+    const int32x4_t vmin = vdupq_n_s32(-lim);
+    const int32x4_t vmax = vdupq_n_s32(lim - 1);
+    const int32x4_t vmask = vdupq_n_s32(mask);
+    uint32x4_t vin = vdupq_n_u32(0xFFFFFFFF);
+
+    /* without a division instruction the quotient is only exact for powers of two */
+    int exp;
+    if (frexpf(div, &exp) == 0.5f) {
+        for (; i + 4 <= size; i += 4) {
+            float32x4_t v = vld1q_f32(voltage + i);
+            vin = vandq_u32(vin, vandq_u32(vcgeq_f32(v, vminv), vcleq_f32(v, vmaxv)));
+            v = vminq_f32(vmaxq_f32(v, vminv), vmaxv);
+            v = vmulq_f32(vmulq_f32(v, vscale), vinv);
+            int32x4_t t = vcvtq_s32_f32(v);
+            float32x4_t d = vsubq_f32(v, vcvtq_f32_s32(t));
+            t = vsubq_s32(t, vreinterpretq_s32_u32(vcgeq_f32(d, vhalf)));
+            t = vaddq_s32(t, vreinterpretq_s32_u32(vcleq_f32(d, vnhalf)));
+            t = vminq_s32(vmaxq_s32(vaddq_s32(t, vdc), vmin), vmax);
+            vst1q_u32(cnts + i, vreinterpretq_u32_s32(vandq_s32(t, vmask)));
+        }
+    }
+    uint32x2_t vin2 = vand_u32(vget_low_u32(vin), vget_high_u32(vin));
+    in_range = (vget_lane_u32(vin2, 0) & vget_lane_u32(vin2, 1)) != 0;
+#elif defined(__SSE2__)
+    const __m128 vmaxv = _mm_set1_ps(adc_max_v);
+    const __m128 vminv = _mm_set1_ps(-adc_max_v);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vdiv = _mm_set1_ps(div);
+    const __m128 vhalf = _mm_set1_ps(0.5f);
+    const __m128 vnhalf = _mm_set1_ps(-0.5f);
+    const __m128i vdc = _mm_set1_epi16((int16_t) MAX(MIN(calib_dc_off, 1 << field_len), -(1 << field_len)));
+    const __m128i vmin = _mm_set1_epi16(-lim);
+    const __m128i vmax = _mm_set1_epi16(lim - 1);
+    const __m128i vmask = _mm_set1_epi16(mask);
+    const __m128i zero = _mm_setzero_si128();
+    __m128 vin = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (; i + 8 <= size; i += 8) {
+        __m128i t[2];
+        for (int h = 0; h < 2; ++h) {
+            __m128 v = _mm_loadu_ps(voltage + i + 4 * h);
+            vin = _mm_and_ps(vin, _mm_and_ps(_mm_cmpge_ps(v, vminv), _mm_cmple_ps(v, vmaxv)));
+            v = _mm_min_ps(_mm_max_ps(v, vminv), vmaxv);
+            v = _mm_div_ps(_mm_mul_ps(v, vscale), vdiv);
+            t[h] = _mm_cvttps_epi32(v);
+            __m128 d = _mm_sub_ps(v, _mm_cvtepi32_ps(t[h]));
+            t[h] = _mm_sub_epi32(t[h], _mm_castps_si128(_mm_cmpge_ps(d, vhalf)));
+            t[h] = _mm_add_epi32(t[h], _mm_castps_si128(_mm_cmple_ps(d, vnhalf)));
+        }
+        /* the counts fit 16 bits, so the offset and the limits are applied on 8 lanes */
+        __m128i m = _mm_adds_epi16(_mm_packs_epi32(t[0], t[1]), vdc);
+        m = _mm_and_si128(_mm_min_epi16(_mm_max_epi16(m, vmin), vmax), vmask);
+        _mm_storeu_si128((__m128i*)(cnts + i), _mm_unpacklo_epi16(m, zero));
+        _mm_storeu_si128((__m128i*)(cnts + i + 4), _mm_unpackhi_epi16(m, zero));
+    }
+    in_range = _mm_movemask_ps(vin) == 0xF;
+#endif
+
+    for (; i < size; ++i) {
+        in_range &= voltage[i] >= -adc_max_v && voltage[i] <= adc_max_v;
+        cnts[i] = cmn_CnvVToCnt(field_len, voltage[i], adc_max_v, false, 0, calib_dc_off, 0.0);
+    }
+    return in_range;
+}
+
 uint32_t rp_cmn_CnvVToCnt(uint32_t field_len, float voltage, float adc_max_v, bool calibFS_LO, uint32_t calib_scale, int calib_dc_off, float user_dc_off) {
 	return cmn_CnvVToCnt(field_len, voltage, adc_max_v, calibFS_LO, calib_scale, calib_dc_off, user_dc_off);
 }
@@ -15,6 +15,7 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -60,12 +61,58 @@ else { \
 
 #define FULL_SCALE_NORM     20.0    // V
 
+// Hints the CPU that the caller is busy waiting
+#if defined(__arm__) || defined(__aarch64__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#elif defined(__i386__) || defined(__x86_64__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#else
+#define CPU_RELAX() __asm__ volatile("" ::: "memory")
+#endif
+
+// Number of UIO devices searched for a named interrupt line
+#define CMN_UIO_MAX_DEVICES 16
+
+/**
+ * Background thread of a handler. cmn_WorkerStop() clears 'running' and wakes
+ * the thread from cmn_WorkerWaitUntil(), the thread may also clear it itself
+ * with cmn_WorkerDone() when it has finished its work.
+ */
+typedef struct {
+    bool running;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+} cmn_worker_t;
+
+int cmn_SetBackend(rp_backend_t value);
+rp_backend_t cmn_GetBackend();
+
 int cmn_Init();
 int cmn_Release();
 
 int cmn_Map(size_t size, size_t offset, void** mapped);
 int cmn_Unmap(size_t size, void** mapped);
 
+uint64_t cmn_NowNs();
+void cmn_SleepNs(uint64_t ns);
+
+int cmn_IrqOpen(const char* name, int* irq_fd);
+int cmn_IrqClose(int* irq_fd);
+int cmn_IrqEnable(int irq_fd);
+int cmn_IrqWait(int irq_fd, uint64_t timeout_ns);
+
+int cmn_WorkerStart(cmn_worker_t* worker, int rt_priority, void* (*routine)(void*));
+bool cmn_WorkerIsRunning(cmn_worker_t* worker);
+void cmn_WorkerDone(cmn_worker_t* worker);
+void cmn_WorkerWaitUntil(cmn_worker_t* worker, uint64_t deadline, uint64_t spin_ns);
+void cmn_WorkerStop(cmn_worker_t* worker);
+
+void cmn_SeqWriteBegin(uint32_t* seq);
+void cmn_SeqWriteEnd(uint32_t* seq);
+uint32_t cmn_SeqReadBegin(const uint32_t* seq);
+bool cmn_SeqReadRetry(const uint32_t* seq, uint32_t start);
+
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask);
@@ -81,10 +128,13 @@ int floatCmp(const void *a, const void *b);
 float cmn_CalibFullScaleToVoltage(uint32_t fullScaleGain);
 uint32_t cmn_CalibFullScaleFromVoltage(float voltageScale);
 
+void cmn_CopyFromDevice(uint32_t *dst, const volatile uint32_t *src, uint32_t words);
 int32_t cmn_CalibCnts(uint32_t field_len, uint32_t cnts, int calib_dc_off);
+void cmn_CalibCntsBlock(uint32_t field_len, const uint32_t *cnts, int16_t *calib, uint32_t size, int calib_dc_off);
 float cmn_CnvCalibCntToV(uint32_t field_len, int32_t calib_cnts, float adc_max_v, float calibScale, float user_dc_off);
 float cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
 uint32_t cmn_CnvVToCnt(uint32_t field_len, float voltage, float adc_max_v, bool calibFS_LO, uint32_t calib_scale, int calib_dc_off, float user_dc_off);
+bool cmn_CnvVToCntBlock(uint32_t field_len, const float *voltage, uint32_t *cnts, uint32_t size, float adc_max_v, int calib_dc_off);
 
 float rp_cmn_CalibFullScaleToVoltage(uint32_t fullScaleGain);
 uint32_t rp_cmn_CalibFullScaleFromVoltage(float voltageScale);
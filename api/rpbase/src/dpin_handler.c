@@ -0,0 +1,242 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library digital pin handler implementation
+ *
+ * Pins are addressed by masks in which bit n stands for pin n of rp_dpin_t:
+ * bits 0-7 are the LEDs, 8-15 DIO_P and 16-23 DIO_N, so each byte of a mask
+ * belongs to one housekeeping register. Only the registers of the pins in a
+ * mask are accessed, each once, and a register is written without reading
+ * it first when all of its pins change.
+ *
+ * The sequence player converts its transitions to register masks when it
+ * starts and writes them from a dedicated thread on an absolute schedule,
+ * the same way as the generator sweep: it sleeps until shortly before a
+ * transition is due and spins for the rest.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "housekeeping.h"
+#include "dpin_handler.h"
+
+/* @brief Pins of one register. */
+#define DPIN_REG_MASK       0xFF
+
+/* @brief All pins of rp_dpin_t. */
+#define DPIN_MASK_ALL       0xFFFFFF
+
+/* @brief Time before a transition is due from which the thread spins instead of sleeping, in [ns]. */
+#define DPIN_SPIN_NS        50000
+
+/* @brief Priority of the sequence thread when real-time scheduling is permitted. */
+#define DPIN_RT_PRIORITY    50
+
+/* Pins and levels of one transition */
+typedef struct {
+    uint64_t time_ns;
+    uint32_t mask;
+    uint32_t state;
+} dpin_write_t;
+
+static struct {
+    bool started;
+    dpin_write_t* writes;
+    uint32_t count;
+    uint64_t max_late_ns;
+    cmn_worker_t worker;    // stopped by the thread when done, or by dpin_SequenceStop()
+} seq;
+
+
+int dpin_Init()
+{
+    ECHECK(hk_Init());
+    return RP_OK;
+}
+
+int dpin_Release()
+{
+    ECHECK(hk_Release());
+    return RP_OK;
+}
+
+/* Sets the pins of a register selected by the byte of 'mask' at 'shift', without reading it when all change */
+static inline void dpin_Write(volatile uint32_t* reg, uint32_t mask, uint32_t bits, int shift)
+{
+    mask = (mask >> shift) & DPIN_REG_MASK;
+    bits = (bits >> shift) & mask;
+    if (mask == DPIN_REG_MASK) {
+        iowrite32(bits, reg);
+    }
+    else if (mask != 0) {
+        iowrite32((ioread32(reg) & ~mask) | bits, reg);
+    }
+}
+
+static inline void dpin_WriteStates(uint32_t mask, uint32_t state)
+{
+    dpin_Write(&hk->led_control, mask, state, 0);
+    dpin_Write(&hk->ex_co_p, mask, state, 8);
+    dpin_Write(&hk->ex_co_n, mask, state, 16);
+}
+
+/* Checks that the pins in 'mask' exist and may be written; LEDs are always outputs */
+static int dpin_CheckOutputs(uint32_t mask)
+{
+    if (mask & ~DPIN_MASK_ALL) {
+        return RP_EPN;
+    }
+    uint32_t inputs = 0;
+    if (mask & (DPIN_REG_MASK << 8)) {
+        inputs |= (~ioread32(&hk->ex_cd_p) & DPIN_REG_MASK) << 8;
+    }
+    if (mask & (DPIN_REG_MASK << 16)) {
+        inputs |= (~ioread32(&hk->ex_cd_n) & DPIN_REG_MASK) << 16;
+    }
+    return mask & inputs ? RP_EWIP : RP_OK;
+}
+
+int dpin_SetStateMask(uint32_t mask, uint32_t state)
+{
+    int ret = dpin_CheckOutputs(mask);
+    if (ret == RP_OK) {
+        dpin_WriteStates(mask, state);
+    }
+    return ret;
+}
+
+int dpin_GetStateAll(uint32_t* state)
+{
+    *state = (ioread32(&hk->led_control) & DPIN_REG_MASK)
+           | (ioread32(&hk->ex_ci_p) & DPIN_REG_MASK) << 8
+           | (ioread32(&hk->ex_ci_n) & DPIN_REG_MASK) << 16;
+    return RP_OK;
+}
+
+int dpin_SetDirectionMask(uint32_t mask, uint32_t direction)
+{
+    if (mask & ~DPIN_MASK_ALL) {
+        return RP_EPN;
+    }
+    if (mask & ~direction & DPIN_REG_MASK) {
+        return RP_ELID;
+    }
+    dpin_Write(&hk->ex_cd_p, mask, direction, 8);
+    dpin_Write(&hk->ex_cd_n, mask, direction, 16);
+    return RP_OK;
+}
+
+int dpin_GetDirectionAll(uint32_t* direction)
+{
+    *direction = DPIN_REG_MASK
+               | (ioread32(&hk->ex_cd_p) & DPIN_REG_MASK) << 8
+               | (ioread32(&hk->ex_cd_n) & DPIN_REG_MASK) << 16;
+    return RP_OK;
+}
+
+static void* dpin_SequenceWorker(void* arg)
+{
+    uint64_t start = cmn_NowNs();
+
+    for (uint32_t i = 0; i < seq.count && dpin_SequenceIsRunning(); ++i) {
+        const dpin_write_t* write = &seq.writes[i];
+        uint64_t due = start + write->time_ns;
+        cmn_WorkerWaitUntil(&seq.worker, due, DPIN_SPIN_NS);
+        if (!dpin_SequenceIsRunning()) {
+            break;
+        }
+
+        uint64_t late = cmn_NowNs() - due;
+        dpin_WriteStates(write->mask, write->state);
+        if (late > seq.max_late_ns) {
+            __atomic_store_n(&seq.max_late_ns, late, __ATOMIC_RELAXED);
+        }
+    }
+
+    cmn_WorkerDone(&seq.worker);
+    return NULL;
+}
+
+int dpin_SequenceStart(const rp_dpin_transition_t* transitions, uint32_t count)
+{
+    if (seq.started) {
+        return RP_EUF;
+    }
+    if (transitions == NULL || count == 0) {
+        return RP_EIPV;
+    }
+
+    uint32_t pins = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (i > 0 && transitions[i].time_ns < transitions[i - 1].time_ns) {
+            return RP_EIPV;
+        }
+        pins |= transitions[i].mask;
+    }
+    ECHECK(dpin_CheckOutputs(pins));
+
+    dpin_write_t* writes = malloc((size_t) count * sizeof(dpin_write_t));
+    if (writes == NULL) {
+        return RP_EOOR;
+    }
+
+    // Transitions at the same time are merged, so their pins change together
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const rp_dpin_transition_t* t = &transitions[i];
+        if (n == 0 || writes[n - 1].time_ns != t->time_ns) {
+            writes[n++] = (dpin_write_t) { .time_ns = t->time_ns };
+        }
+        dpin_write_t* write = &writes[n - 1];
+        write->mask |= t->mask;
+        write->state = (write->state & ~t->mask) | (t->state & t->mask);
+    }
+
+    seq.writes = writes;
+    seq.count = n;
+    seq.max_late_ns = 0;
+
+    // Real-time priority keeps the timing when the system is loaded, without it the sequence still plays
+    if (cmn_WorkerStart(&seq.worker, DPIN_RT_PRIORITY, dpin_SequenceWorker) != RP_OK) {
+        free(seq.writes);
+        seq.writes = NULL;
+        return RP_EOOR;
+    }
+
+    seq.started = true;
+    return RP_OK;
+}
+
+bool dpin_SequenceIsRunning()
+{
+    return cmn_WorkerIsRunning(&seq.worker);
+}
+
+int dpin_SequenceGetLateness(uint64_t* max_late_ns)
+{
+    *max_late_ns = __atomic_load_n(&seq.max_late_ns, __ATOMIC_RELAXED);
+    return RP_OK;
+}
+
+int dpin_SequenceStop()
+{
+    if (!seq.started) {
+        return RP_OK;
+    }
+
+    cmn_WorkerStop(&seq.worker);
+
+    free(seq.writes);
+    seq.writes = NULL;
+    seq.started = false;
+    return RP_OK;
+}
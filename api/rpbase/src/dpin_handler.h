@@ -0,0 +1,35 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library digital pin handler interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_DPIN_HANDLER_H_
+#define SRC_DPIN_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+int dpin_Init();
+int dpin_Release();
+
+int dpin_SetStateMask(uint32_t mask, uint32_t state);
+int dpin_GetStateAll(uint32_t* state);
+int dpin_SetDirectionMask(uint32_t mask, uint32_t direction);
+int dpin_GetDirectionAll(uint32_t* direction);
+
+int dpin_SequenceStart(const rp_dpin_transition_t* transitions, uint32_t count);
+bool dpin_SequenceIsRunning();
+int dpin_SequenceGetLateness(uint64_t* max_late_ns);
+int dpin_SequenceStop();
+
+#endif /* SRC_DPIN_HANDLER_H_ */
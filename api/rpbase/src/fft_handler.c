@@ -0,0 +1,456 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library FFT planner implementation
+ *
+ * Plans are built by one of the complex FFT implementations (kiss_fft or the
+ * radix-4 transform) and kept in a list keyed by size, type and
+ * implementation until fft_Cleanup(). A real transform of size samples is
+ * computed as a complex transform of size/2 samples, the even samples as the
+ * real and the odd samples as the imaginary part, and then separated in
+ * place into the size/2+1 bins of the real input.
+ *
+ * Averages are kept in accumulators owned by the caller and updated in
+ * place. The linear mean uses the running form acc += (x - acc) / n, so it
+ * needs no separate sum and every mode costs one operation per bin.
+ *
+ * The zoom filter chains of fft_zoom.c are cached like the plans, keyed by
+ * decimation and size; the oscillator frequency is given with every call.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "kiss_fftf.h"
+#include "fft_radix4.h"
+#include "fft_zoom.h"
+#include "fft_handler.h"
+
+/* Complex forward transform of one implementation */
+typedef struct {
+    void* (*create)(uint32_t size);
+    void (*execute)(const void* state, const rp_fft_cpx_t* in, rp_fft_cpx_t* out);
+    void (*destroy)(void* state);
+} fft_impl_t;
+
+struct rp_fft_plan {
+    uint32_t size;
+    rp_fft_type_t type;
+    rp_fft_backend_t backend;   // RP_FFT_KISS or RP_FFT_RADIX4
+    const fft_impl_t* impl;
+    void* state;                // complex transform of size, or of size/2 for real input
+    rp_fft_cpx_t* split;        // real input: exp(-2 pi i k / size) for k = 0 .. size/4
+    struct rp_fft_plan* next;
+};
+
+static void* fft_KissCreate(uint32_t size)
+{
+    return kiss_fftf_alloc(size, 0, NULL, NULL);
+}
+
+static void fft_KissExecute(const void* state, const rp_fft_cpx_t* in, rp_fft_cpx_t* out)
+{
+    kiss_fftf((kiss_fftf_cfg) state, (const kiss_fftf_cpx*) in, (kiss_fftf_cpx*) out);
+}
+
+static void* fft_Radix4New(uint32_t size)
+{
+    return fft_Radix4Create(size);
+}
+
+static void fft_Radix4Run(const void* state, const rp_fft_cpx_t* in, rp_fft_cpx_t* out)
+{
+    fft_Radix4Execute((const fft_radix4_t*) state, in, out);
+}
+
+static void fft_Radix4Free(void* state)
+{
+    fft_Radix4Destroy((fft_radix4_t*) state);
+}
+
+static const fft_impl_t fft_kiss = { fft_KissCreate, fft_KissExecute, free };
+static const fft_impl_t fft_radix4 = { fft_Radix4New, fft_Radix4Run, fft_Radix4Free };
+
+/* Hann window of the Welch segments */
+typedef struct fft_window {
+    uint32_t size;
+    float* w;
+    struct fft_window* next;
+} fft_window_t;
+
+/* Filter chain of a zoom */
+typedef struct fft_zoom_entry {
+    uint32_t decimation;
+    uint32_t size;
+    fft_zoom_t* zoom;
+    struct fft_zoom_entry* next;
+} fft_zoom_entry_t;
+
+static rp_fft_backend_t fft_backend = RP_FFT_AUTO;
+static rp_fft_plan_t* fft_plans = NULL;
+static fft_window_t* fft_windows = NULL;
+static fft_zoom_entry_t* fft_zooms = NULL;
+static pthread_mutex_t fft_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void fft_PlanFree(rp_fft_plan_t* plan)
+{
+    if (plan->state) {
+        plan->impl->destroy(plan->state);
+    }
+    free(plan->split);
+    free(plan);
+}
+
+int fft_SetBackend(rp_fft_backend_t backend)
+{
+    if (backend != RP_FFT_AUTO && backend != RP_FFT_KISS && backend != RP_FFT_RADIX4) {
+        return RP_EIPV;
+    }
+    pthread_mutex_lock(&fft_mutex);
+    fft_backend = backend;
+    pthread_mutex_unlock(&fft_mutex);
+    return RP_OK;
+}
+
+int fft_GetBackend(rp_fft_backend_t* backend)
+{
+    pthread_mutex_lock(&fft_mutex);
+    *backend = fft_backend;
+    pthread_mutex_unlock(&fft_mutex);
+    return RP_OK;
+}
+
+int fft_PlanGet(uint32_t size, rp_fft_type_t type, rp_fft_plan_t** plan)
+{
+    if (size == 0 || (type != RP_FFT_COMPLEX && type != RP_FFT_REAL) || (type == RP_FFT_REAL && (size & 1))) {
+        return RP_EIPV;
+    }
+    const uint32_t n = type == RP_FFT_REAL ? size / 2 : size;
+    const bool pow2 = (n & (n - 1)) == 0;
+
+    pthread_mutex_lock(&fft_mutex);
+    rp_fft_backend_t backend = fft_backend;
+    if (backend == RP_FFT_AUTO) {
+        backend = pow2 ? RP_FFT_RADIX4 : RP_FFT_KISS;
+    }
+    if (backend == RP_FFT_RADIX4 && !pow2) {
+        pthread_mutex_unlock(&fft_mutex);
+        return RP_EIPV;
+    }
+
+    rp_fft_plan_t* p;
+    for (p = fft_plans; p; p = p->next) {
+        if (p->size == size && p->type == type && p->backend == backend) {
+            *plan = p;
+            pthread_mutex_unlock(&fft_mutex);
+            return RP_OK;
+        }
+    }
+
+    p = calloc(1, sizeof(rp_fft_plan_t));
+    if (p == NULL) {
+        pthread_mutex_unlock(&fft_mutex);
+        return RP_EOOR;
+    }
+    p->size = size;
+    p->type = type;
+    p->backend = backend;
+    p->impl = backend == RP_FFT_RADIX4 ? &fft_radix4 : &fft_kiss;
+    p->state = p->impl->create(n);
+    if (type == RP_FFT_REAL) {
+        p->split = malloc((n / 2 + 1) * sizeof(rp_fft_cpx_t));
+        if (p->split) {
+            for (uint32_t k = 0; k <= n / 2; ++k) {
+                double phase = -2 * M_PI * k / size;
+                p->split[k].r = cos(phase);
+                p->split[k].i = sin(phase);
+            }
+        }
+    }
+    if (p->state == NULL || (type == RP_FFT_REAL && p->split == NULL)) {
+        fft_PlanFree(p);
+        pthread_mutex_unlock(&fft_mutex);
+        return RP_EOOR;
+    }
+
+    p->next = fft_plans;
+    fft_plans = p;
+    *plan = p;
+    pthread_mutex_unlock(&fft_mutex);
+    return RP_OK;
+}
+
+/* Bins of the real input from the complex transform Z of its m = size/2 sample pairs:
+ * X[k] = (Z[k] + conj(Z[m-k]))/2 - i W^k (Z[k] - conj(Z[m-k]))/2, W = exp(-2 pi i / size),
+ * computed in place for k and m-k together. */
+static void fft_RealSplit(const rp_fft_plan_t* plan, rp_fft_cpx_t* x)
+{
+    const uint32_t m = plan->size / 2;
+    const rp_fft_cpx_t* w = plan->split;
+    rp_fft_cpx_t z0 = x[0];
+
+    x[0].r = z0.r + z0.i;
+    x[0].i = 0;
+    x[m].r = z0.r - z0.i;
+    x[m].i = 0;
+    for (uint32_t k = 1; k <= m / 2; ++k) {
+        rp_fft_cpx_t a = x[k], b = x[m - k];
+        float er = 0.5f * (a.r + b.r), ei = 0.5f * (a.i - b.i);
+        float odr = 0.5f * (a.r - b.r), odi = 0.5f * (a.i + b.i);
+        float tr = w[k].r * odr - w[k].i * odi, ti = w[k].r * odi + w[k].i * odr;
+        x[k].r = er + ti;
+        x[k].i = ei - tr;
+        x[m - k].r = er - ti;
+        x[m - k].i = -(ei + tr);
+    }
+}
+
+int fft_Execute(const rp_fft_plan_t* plan, const void* in, rp_fft_cpx_t* out)
+{
+    if (plan == NULL || in == NULL || out == NULL) {
+        return RP_EIPV;
+    }
+    plan->impl->execute(plan->state, (const rp_fft_cpx_t*) in, out);
+    if (plan->type == RP_FFT_REAL) {
+        fft_RealSplit(plan, out);
+    }
+    return RP_OK;
+}
+
+int fft_AvgAdd(rp_fft_avg_t* avg, float* acc, const float* frame, uint32_t bins)
+{
+    if (avg->count == 0 || avg->mode > RP_FFT_AVG_MIN) {
+        return RP_EIPV;
+    }
+
+    if (avg->frames == 0) {
+        memcpy(acc, frame, bins * sizeof(float));
+        avg->frames = 1;
+        return RP_OK;
+    }
+
+    uint32_t i;
+    switch (avg->mode) {
+        case RP_FFT_AVG_LINEAR:
+        case RP_FFT_AVG_EXP: {
+            // a linear average is complete after count frames
+            if (avg->mode == RP_FFT_AVG_LINEAR && avg->frames >= avg->count) {
+                return RP_OK;
+            }
+            uint32_t n = avg->frames < avg->count ? avg->frames + 1 : avg->count;
+            const float weight = 1.0f / n;
+            for (i = 0; i < bins; ++i) {
+                acc[i] += weight * (frame[i] - acc[i]);
+            }
+            break;
+        }
+        case RP_FFT_AVG_PEAK:
+            for (i = 0; i < bins; ++i) {
+                acc[i] = frame[i] > acc[i] ? frame[i] : acc[i];
+            }
+            break;
+        case RP_FFT_AVG_MIN:
+            for (i = 0; i < bins; ++i) {
+                acc[i] = frame[i] < acc[i] ? frame[i] : acc[i];
+            }
+            break;
+    }
+    if (avg->frames < UINT32_MAX) {
+        avg->frames++;
+    }
+    return RP_OK;
+}
+
+/* Returns the cached Hann window of size samples */
+static const float* fft_WindowGet(uint32_t size)
+{
+    fft_window_t* win;
+
+    pthread_mutex_lock(&fft_mutex);
+    for (win = fft_windows; win; win = win->next) {
+        if (win->size == size) {
+            pthread_mutex_unlock(&fft_mutex);
+            return win->w;
+        }
+    }
+
+    win = malloc(sizeof(fft_window_t));
+    float* w = malloc(size * sizeof(float));
+    if (win == NULL || w == NULL) {
+        free(win);
+        free(w);
+        pthread_mutex_unlock(&fft_mutex);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+        w[i] = 0.5 * (1 - cos(2 * M_PI * i / (double)(size - 1)));
+    }
+    win->size = size;
+    win->w = w;
+    win->next = fft_windows;
+    fft_windows = win;
+    pthread_mutex_unlock(&fft_mutex);
+    return w;
+}
+
+int fft_Welch(const float* in, uint32_t in_len, uint32_t seg_len, uint32_t overlap, float* power)
+{
+    rp_fft_plan_t* plan;
+
+    if (in == NULL || power == NULL || seg_len < 2 || overlap >= seg_len || in_len < seg_len) {
+        return RP_EIPV;
+    }
+    ECHECK(fft_PlanGet(seg_len, RP_FFT_REAL, &plan));
+    const float* window = fft_WindowGet(seg_len);
+
+    const uint32_t bins = seg_len / 2 + 1, step = seg_len - overlap;
+    const uint32_t segments = (in_len - seg_len) / step + 1;
+    float* seg = malloc(seg_len * sizeof(float));
+    rp_fft_cpx_t* spec = malloc(bins * sizeof(rp_fft_cpx_t));
+    if (window == NULL || seg == NULL || spec == NULL) {
+        free(seg);
+        free(spec);
+        return RP_EOOR;
+    }
+
+    // Sum of the periodograms in place, scaled to the mean at the end
+    for (uint32_t s = 0; s < segments; ++s) {
+        const float* x = in + s * step;
+        uint32_t i;
+        for (i = 0; i < seg_len; ++i) {
+            seg[i] = x[i] * window[i];
+        }
+        fft_Execute(plan, seg, spec);
+        if (s == 0) {
+            for (i = 0; i < bins; ++i) {
+                power[i] = spec[i].r * spec[i].r + spec[i].i * spec[i].i;
+            }
+        } else {
+            for (i = 0; i < bins; ++i) {
+                power[i] += spec[i].r * spec[i].r + spec[i].i * spec[i].i;
+            }
+        }
+    }
+    const float scale = 1.0f / segments;
+    for (uint32_t i = 0; i < bins; ++i) {
+        power[i] *= scale;
+    }
+
+    free(seg);
+    free(spec);
+    return RP_OK;
+}
+
+/* Returns the cached filter chain of a zoom */
+static const fft_zoom_t* fft_ZoomGet(uint32_t decimation, uint32_t size)
+{
+    fft_zoom_entry_t* entry;
+
+    pthread_mutex_lock(&fft_mutex);
+    for (entry = fft_zooms; entry; entry = entry->next) {
+        if (entry->decimation == decimation && entry->size == size) {
+            pthread_mutex_unlock(&fft_mutex);
+            return entry->zoom;
+        }
+    }
+
+    entry = malloc(sizeof(fft_zoom_entry_t));
+    fft_zoom_t* zoom = fft_ZoomCreate(decimation, size);
+    if (entry == NULL || zoom == NULL) {
+        free(entry);
+        fft_ZoomDestroy(zoom);
+        pthread_mutex_unlock(&fft_mutex);
+        return NULL;
+    }
+    entry->decimation = decimation;
+    entry->size = size;
+    entry->zoom = zoom;
+    entry->next = fft_zooms;
+    fft_zooms = entry;
+    pthread_mutex_unlock(&fft_mutex);
+    return zoom;
+}
+
+int fft_Zoom(const float* in, uint32_t in_len, float center, uint32_t decimation, uint32_t fft_len, float* power)
+{
+    rp_fft_plan_t* plan;
+
+    if (in == NULL || power == NULL || !(center >= -0.5f && center <= 0.5f) ||
+        decimation < FFT_ZOOM_MIN_DECIMATION || decimation > FFT_ZOOM_MAX_DECIMATION ||
+        (decimation & (decimation - 1))) {
+        return RP_EIPV;
+    }
+    ECHECK(fft_PlanGet(fft_len, RP_FFT_COMPLEX, &plan));
+    const fft_zoom_t* zoom = fft_ZoomGet(decimation, fft_len);
+    const float* window = fft_WindowGet(fft_len);
+    if (zoom == NULL || window == NULL) {
+        return RP_EOOR;
+    }
+    if (in_len < fft_ZoomInputLength(zoom)) {
+        return RP_EIPV;
+    }
+
+    rp_fft_cpx_t* x = malloc(2 * fft_len * sizeof(rp_fft_cpx_t));
+    if (x == NULL) {
+        return RP_EOOR;
+    }
+    rp_fft_cpx_t* spec = x + fft_len;
+    int ret = fft_ZoomDecimate(zoom, in, center, x);
+    if (ret != RP_OK) {
+        free(x);
+        return ret;
+    }
+
+    uint32_t i;
+    for (i = 0; i < fft_len; ++i) {
+        x[i].r *= window[i];
+        x[i].i *= window[i];
+    }
+    fft_Execute(plan, x, spec);
+
+    // Negative frequencies first, the center at fft_len/2
+    const float* gain = fft_ZoomGain(zoom);
+    const uint32_t half = fft_len / 2;
+    for (i = 0; i < fft_len; ++i) {
+        const rp_fft_cpx_t* b = &spec[i < half ? i + fft_len - half : i - half];
+        power[i] = (b->r * b->r + b->i * b->i) * gain[i];
+    }
+
+    free(x);
+    return RP_OK;
+}
+
+int fft_Cleanup()
+{
+    pthread_mutex_lock(&fft_mutex);
+    while (fft_plans) {
+        rp_fft_plan_t* next = fft_plans->next;
+        fft_PlanFree(fft_plans);
+        fft_plans = next;
+    }
+    while (fft_windows) {
+        fft_window_t* next = fft_windows->next;
+        free(fft_windows->w);
+        free(fft_windows);
+        fft_windows = next;
+    }
+    while (fft_zooms) {
+        fft_zoom_entry_t* next = fft_zooms->next;
+        fft_ZoomDestroy(fft_zooms->zoom);
+        free(fft_zooms);
+        fft_zooms = next;
+    }
+    pthread_mutex_unlock(&fft_mutex);
+    return RP_OK;
+}
@@ -0,0 +1,30 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library FFT planner interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_FFT_HANDLER_H_
+#define SRC_FFT_HANDLER_H_
+
+#include <stdint.h>
+#include "redpitaya/rp.h"
+
+int fft_SetBackend(rp_fft_backend_t backend);
+int fft_GetBackend(rp_fft_backend_t* backend);
+int fft_PlanGet(uint32_t size, rp_fft_type_t type, rp_fft_plan_t** plan);
+int fft_Execute(const rp_fft_plan_t* plan, const void* in, rp_fft_cpx_t* out);
+int fft_AvgAdd(rp_fft_avg_t* avg, float* acc, const float* frame, uint32_t bins);
+int fft_Welch(const float* in, uint32_t in_len, uint32_t seg_len, uint32_t overlap, float* power);
+int fft_Zoom(const float* in, uint32_t in_len, float center, uint32_t decimation, uint32_t fft_len, float* power);
+int fft_Cleanup();
+
+#endif /* SRC_FFT_HANDLER_H_ */
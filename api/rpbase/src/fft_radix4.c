@@ -0,0 +1,267 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library radix-4 FFT implementation
+ *
+ * Forward complex FFT of power of two sizes, decimated in time. The input is
+ * copied to the output in bit reversed order and transformed there in place,
+ * so no scratch memory is needed and a plan can be executed from several
+ * threads at once. Every radix-4 pass does the work of two radix-2 passes
+ * with three complex multiplications per butterfly; an odd number of radix-2
+ * passes starts with one radix-2 pass. The first pass has no twiddle factors
+ * and is done while the input is copied. Four butterflies are computed per
+ * instruction where NEON or SSE2 is available.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fft_radix4.h"
+
+struct fft_radix4 {
+    uint32_t size;
+    uint32_t log2n;
+    uint32_t* rev;      // bit reversed index of the first sample of every first pass butterfly
+    float* twiddles;    // per radix-4 pass with distance h: W^j, W^2j, W^3j as re[h], im[h] each
+};
+
+/* Butterfly of the samples j, j+h, j+2h and j+3h of a radix-4 pass, W = exp(-2 pi i / 4h):
+ * B = W^2j x[j+h], C = W^j x[j+2h], D = W^3j x[j+3h]
+ * x[j] = a+B + C+D, x[j+h] = a-B - i(C-D), x[j+2h] = a+B - (C+D), x[j+3h] = a-B + i(C-D) */
+static inline void fft_Butterfly(rp_fft_cpx_t* x, uint32_t h, uint32_t j, const float* tw)
+{
+    rp_fft_cpx_t a = x[j], b = x[j + h], c = x[j + 2 * h], d = x[j + 3 * h];
+    float w1r = tw[j], w1i = tw[h + j];
+    float w2r = tw[2 * h + j], w2i = tw[3 * h + j];
+    float w3r = tw[4 * h + j], w3i = tw[5 * h + j];
+
+    float br = b.r * w2r - b.i * w2i, bi = b.r * w2i + b.i * w2r;
+    float cr = c.r * w1r - c.i * w1i, ci = c.r * w1i + c.i * w1r;
+    float dr = d.r * w3r - d.i * w3i, di = d.r * w3i + d.i * w3r;
+
+    float s0r = a.r + br, s0i = a.i + bi, s1r = a.r - br, s1i = a.i - bi;
+    float s2r = cr + dr, s2i = ci + di, s3r = cr - dr, s3i = ci - di;
+
+    x[j].r         = s0r + s2r;  x[j].i         = s0i + s2i;
+    x[j + 2 * h].r = s0r - s2r;  x[j + 2 * h].i = s0i - s2i;
+    x[j + h].r     = s1r + s3i;  x[j + h].i     = s1i - s3r;
+    x[j + 3 * h].r = s1r - s3i;  x[j + 3 * h].i = s1i + s3r;
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static inline void fft_Butterfly4(rp_fft_cpx_t* x, uint32_t h, uint32_t j, const float* tw)
+{
+    float32x4x2_t a = vld2q_f32(&x[j].r), b = vld2q_f32(&x[j + h].r);
+    float32x4x2_t c = vld2q_f32(&x[j + 2 * h].r), d = vld2q_f32(&x[j + 3 * h].r);
+    float32x4_t w1r = vld1q_f32(tw + j), w1i = vld1q_f32(tw + h + j);
+    float32x4_t w2r = vld1q_f32(tw + 2 * h + j), w2i = vld1q_f32(tw + 3 * h + j);
+    float32x4_t w3r = vld1q_f32(tw + 4 * h + j), w3i = vld1q_f32(tw + 5 * h + j);
+
+    float32x4_t br = vmlsq_f32(vmulq_f32(b.val[0], w2r), b.val[1], w2i);
+    float32x4_t bi = vmlaq_f32(vmulq_f32(b.val[0], w2i), b.val[1], w2r);
+    float32x4_t cr = vmlsq_f32(vmulq_f32(c.val[0], w1r), c.val[1], w1i);
+    float32x4_t ci = vmlaq_f32(vmulq_f32(c.val[0], w1i), c.val[1], w1r);
+    float32x4_t dr = vmlsq_f32(vmulq_f32(d.val[0], w3r), d.val[1], w3i);
+    float32x4_t di = vmlaq_f32(vmulq_f32(d.val[0], w3i), d.val[1], w3r);
+
+    float32x4_t s0r = vaddq_f32(a.val[0], br), s0i = vaddq_f32(a.val[1], bi);
+    float32x4_t s1r = vsubq_f32(a.val[0], br), s1i = vsubq_f32(a.val[1], bi);
+    float32x4_t s2r = vaddq_f32(cr, dr), s2i = vaddq_f32(ci, di);
+    float32x4_t s3r = vsubq_f32(cr, dr), s3i = vsubq_f32(ci, di);
+
+    float32x4x2_t y;
+    y.val[0] = vaddq_f32(s0r, s2r); y.val[1] = vaddq_f32(s0i, s2i);
+    vst2q_f32(&x[j].r, y);
+    y.val[0] = vsubq_f32(s0r, s2r); y.val[1] = vsubq_f32(s0i, s2i);
+    vst2q_f32(&x[j + 2 * h].r, y);
+    y.val[0] = vaddq_f32(s1r, s3i); y.val[1] = vsubq_f32(s1i, s3r);
+    vst2q_f32(&x[j + h].r, y);
+    y.val[0] = vsubq_f32(s1r, s3i); y.val[1] = vaddq_f32(s1i, s3r);
+    vst2q_f32(&x[j + 3 * h].r, y);
+}
+#elif defined(__SSE2__)
+/* Four interleaved complex samples to real and imaginary parts */
+static inline void fft_Load4(const rp_fft_cpx_t* p, __m128* re, __m128* im)
+{
+    __m128 lo = _mm_loadu_ps(&p[0].r), hi = _mm_loadu_ps(&p[2].r);
+    *re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static inline void fft_Store4(rp_fft_cpx_t* p, __m128 re, __m128 im)
+{
+    _mm_storeu_ps(&p[0].r, _mm_unpacklo_ps(re, im));
+    _mm_storeu_ps(&p[2].r, _mm_unpackhi_ps(re, im));
+}
+
+static inline void fft_Butterfly4(rp_fft_cpx_t* x, uint32_t h, uint32_t j, const float* tw)
+{
+    __m128 ar, ai, br, bi, cr, ci, dr, di;
+    fft_Load4(x + j, &ar, &ai);
+    fft_Load4(x + j + h, &br, &bi);
+    fft_Load4(x + j + 2 * h, &cr, &ci);
+    fft_Load4(x + j + 3 * h, &dr, &di);
+    __m128 w1r = _mm_loadu_ps(tw + j), w1i = _mm_loadu_ps(tw + h + j);
+    __m128 w2r = _mm_loadu_ps(tw + 2 * h + j), w2i = _mm_loadu_ps(tw + 3 * h + j);
+    __m128 w3r = _mm_loadu_ps(tw + 4 * h + j), w3i = _mm_loadu_ps(tw + 5 * h + j);
+
+    __m128 tr, ti;
+    tr = _mm_sub_ps(_mm_mul_ps(br, w2r), _mm_mul_ps(bi, w2i));
+    ti = _mm_add_ps(_mm_mul_ps(br, w2i), _mm_mul_ps(bi, w2r));
+    br = tr; bi = ti;
+    tr = _mm_sub_ps(_mm_mul_ps(cr, w1r), _mm_mul_ps(ci, w1i));
+    ti = _mm_add_ps(_mm_mul_ps(cr, w1i), _mm_mul_ps(ci, w1r));
+    cr = tr; ci = ti;
+    tr = _mm_sub_ps(_mm_mul_ps(dr, w3r), _mm_mul_ps(di, w3i));
+    ti = _mm_add_ps(_mm_mul_ps(dr, w3i), _mm_mul_ps(di, w3r));
+    dr = tr; di = ti;
+
+    __m128 s0r = _mm_add_ps(ar, br), s0i = _mm_add_ps(ai, bi);
+    __m128 s1r = _mm_sub_ps(ar, br), s1i = _mm_sub_ps(ai, bi);
+    __m128 s2r = _mm_add_ps(cr, dr), s2i = _mm_add_ps(ci, di);
+    __m128 s3r = _mm_sub_ps(cr, dr), s3i = _mm_sub_ps(ci, di);
+
+    fft_Store4(x + j, _mm_add_ps(s0r, s2r), _mm_add_ps(s0i, s2i));
+    fft_Store4(x + j + 2 * h, _mm_sub_ps(s0r, s2r), _mm_sub_ps(s0i, s2i));
+    fft_Store4(x + j + h, _mm_add_ps(s1r, s3i), _mm_sub_ps(s1i, s3r));
+    fft_Store4(x + j + 3 * h, _mm_sub_ps(s1r, s3i), _mm_add_ps(s1i, s3r));
+}
+#endif
+
+static uint32_t fft_BitReverse(uint32_t i, uint32_t bits)
+{
+    uint32_t r = 0;
+    for (uint32_t b = 0; b < bits; ++b) {
+        r = (r << 1) | ((i >> b) & 1);
+    }
+    return r;
+}
+
+fft_radix4_t* fft_Radix4Create(uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return NULL;
+    }
+
+    fft_radix4_t* plan = calloc(1, sizeof(fft_radix4_t));
+    if (plan == NULL) {
+        return NULL;
+    }
+    plan->size = size;
+    while ((1u << plan->log2n) < size) {
+        plan->log2n++;
+    }
+
+    // First pass: radix-2 on pairs for an odd number of radix-2 passes, radix-4 on quadruples otherwise
+    uint32_t first = (plan->log2n & 1) ? 2 : 4;
+    uint32_t groups = size >= first ? size / first : 1;
+    uint32_t coeffs = 0;
+    for (uint32_t h = first; h < size; h *= 4) {
+        coeffs += 6 * h;
+    }
+
+    plan->rev = malloc(groups * sizeof(uint32_t));
+    plan->twiddles = malloc((coeffs ? coeffs : 1) * sizeof(float));
+    if (plan->rev == NULL || plan->twiddles == NULL) {
+        fft_Radix4Destroy(plan);
+        return NULL;
+    }
+
+    for (uint32_t g = 0; g < groups; ++g) {
+        plan->rev[g] = fft_BitReverse(g * first, plan->log2n);
+    }
+
+    float* tw = plan->twiddles;
+    for (uint32_t h = first; h < size; h *= 4) {
+        for (uint32_t j = 0; j < h; ++j) {
+            for (uint32_t m = 1; m <= 3; ++m) {
+                double phase = -2 * M_PI * m * j / (4.0 * h);
+                tw[2 * (m - 1) * h + j] = cos(phase);
+                tw[(2 * m - 1) * h + j] = sin(phase);
+            }
+        }
+        tw += 6 * h;
+    }
+    return plan;
+}
+
+void fft_Radix4Execute(const fft_radix4_t* plan, const rp_fft_cpx_t* in, rp_fft_cpx_t* out)
+{
+    const uint32_t n = plan->size;
+    const float* tw = plan->twiddles;
+    uint32_t h;
+
+    if (n < 4) {
+        if (n == 1) {
+            out[0] = in[0];
+        } else {
+            out[0].r = in[0].r + in[1].r; out[0].i = in[0].i + in[1].i;
+            out[1].r = in[0].r - in[1].r; out[1].i = in[0].i - in[1].i;
+        }
+        return;
+    }
+
+    // Bit reversed copy with the first pass, whose twiddle factors are all 1
+    if (plan->log2n & 1) {
+        for (uint32_t g = 0; g < n / 2; ++g) {
+            rp_fft_cpx_t a = in[plan->rev[g]], b = in[plan->rev[g] + n / 2];
+            out[2 * g].r = a.r + b.r;     out[2 * g].i = a.i + b.i;
+            out[2 * g + 1].r = a.r - b.r; out[2 * g + 1].i = a.i - b.i;
+        }
+        h = 2;
+    } else {
+        const uint32_t q = n / 4;
+        for (uint32_t g = 0; g < q; ++g) {
+            const rp_fft_cpx_t* p = in + plan->rev[g];
+            rp_fft_cpx_t a = p[0], b = p[2 * q], c = p[q], d = p[3 * q];
+            float s0r = a.r + b.r, s0i = a.i + b.i, s1r = a.r - b.r, s1i = a.i - b.i;
+            float s2r = c.r + d.r, s2i = c.i + d.i, s3r = c.r - d.r, s3i = c.i - d.i;
+            rp_fft_cpx_t* x = out + 4 * g;
+            x[0].r = s0r + s2r; x[0].i = s0i + s2i;
+            x[2].r = s0r - s2r; x[2].i = s0i - s2i;
+            x[1].r = s1r + s3i; x[1].i = s1i - s3r;
+            x[3].r = s1r - s3i; x[3].i = s1i + s3r;
+        }
+        h = 4;
+    }
+
+    for (; h < n; h *= 4) {
+        for (uint32_t block = 0; block < n; block += 4 * h) {
+            rp_fft_cpx_t* x = out + block;
+            uint32_t j = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__SSE2__)
+            for (; j + 4 <= h; j += 4) {
+                fft_Butterfly4(x, h, j, tw);
+            }
+#endif
+            for (; j < h; ++j) {
+                fft_Butterfly(x, h, j, tw);
+            }
+        }
+        tw += 6 * h;
+    }
+}
+
+void fft_Radix4Destroy(fft_radix4_t* plan)
+{
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->rev);
+    free(plan->twiddles);
+    free(plan);
+}
@@ -0,0 +1,27 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library radix-4 FFT interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_FFT_RADIX4_H_
+#define SRC_FFT_RADIX4_H_
+
+#include <stdint.h>
+#include "redpitaya/rp_fft.h"
+
+typedef struct fft_radix4 fft_radix4_t;
+
+fft_radix4_t* fft_Radix4Create(uint32_t size);
+void fft_Radix4Execute(const fft_radix4_t* plan, const rp_fft_cpx_t* in, rp_fft_cpx_t* out);
+void fft_Radix4Destroy(fft_radix4_t* plan);
+
+#endif /* SRC_FFT_RADIX4_H_ */
@@ -0,0 +1,357 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library zoom FFT down conversion
+ *
+ * Moves the band around a center frequency of a real capture to DC and
+ * decimates it, so that a short FFT of the result resolves the band as finely
+ * as a long FFT of the whole capture. The capture is mixed with a numerically
+ * controlled oscillator, whose phase is advanced in double precision every
+ * ZOOM_NCO_BLOCK samples and rotated in single precision in between.
+ *
+ * The decimation is a CIC style chain of halving stages with binomial
+ * (1 + z^-1)^R filters, followed by a windowed sinc FIR decimating by
+ * ZOOM_FIR_DEC. The order R of every stage is the lowest that keeps the
+ * aliases of the passband below ZOOM_REJECTION dB, so the early stages, which
+ * see the most samples, are the cheapest. Only the passband droop of the
+ * chain remains; its exact response is computed once per configuration and
+ * divided out of the power spectrum. The oscillator, the stages and the FIR
+ * filter compute four samples per instruction where NEON or SSE2 is available.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "redpitaya/rp.h"
+#include "fft_zoom.h"
+
+/* @brief Decimation of the final FIR filter. */
+#define ZOOM_FIR_DEC        4
+/* @brief Taps of the final FIR filter. */
+#define ZOOM_FIR_TAPS       128
+/* @brief Passband of the decimated signal, relative to its sample rate. */
+#define ZOOM_PASSBAND       0.4
+/* @brief Attenuation of the aliases of the passband in the halving stages [dB]. */
+#define ZOOM_REJECTION      80
+/* @brief Highest binomial order of a halving stage. */
+#define ZOOM_MAX_ORDER      6
+/* @brief Halving stages of the largest decimation. */
+#define ZOOM_MAX_STAGES     14
+/* @brief Input samples decimated at once. */
+#define ZOOM_CHUNK          4096
+/* @brief Samples between two exact oscillator phases, multiple of 4. */
+#define ZOOM_NCO_BLOCK      256
+
+struct fft_zoom {
+    uint32_t decimation;
+    uint32_t size;
+    uint32_t stages;                                    // decimation = ZOOM_FIR_DEC << stages
+    uint32_t order[ZOOM_MAX_STAGES];
+    float coef[ZOOM_MAX_STAGES][ZOOM_MAX_ORDER + 1];    // binomial coefficients of every stage
+    float fir[ZOOM_FIR_TAPS];                           // normalized to a unity gain of the chain
+    uint32_t skip;                                      // outputs before the filters are filled
+    uint32_t in_len;                                    // input samples of size outputs
+    uint32_t chunk;                                     // input samples per pass, multiple of decimation
+    float* gain;                                        // decimation^2 / |H|^2 of every bin, from -size/2
+};
+
+fft_zoom_t* fft_ZoomCreate(uint32_t decimation, uint32_t size)
+{
+    if (decimation < FFT_ZOOM_MIN_DECIMATION || decimation > FFT_ZOOM_MAX_DECIMATION ||
+        (decimation & (decimation - 1)) || size < 2) {
+        return NULL;
+    }
+
+    fft_zoom_t* zoom = calloc(1, sizeof(fft_zoom_t));
+    float* gain = malloc(size * sizeof(float));
+    if (zoom == NULL || gain == NULL) {
+        free(zoom);
+        free(gain);
+        return NULL;
+    }
+    zoom->decimation = decimation;
+    zoom->size = size;
+    zoom->gain = gain;
+
+    // Halving stages; span is the length of the impulse response in input samples
+    uint32_t span = 0, growth = 0, s, k;
+    for (s = 0; (ZOOM_FIR_DEC << s) < decimation; ++s) {
+        double alias = sin(M_PI * ZOOM_PASSBAND * (1u << s) / decimation);
+        uint32_t order = (uint32_t)ceil(ZOOM_REJECTION / (-20 * log10(alias)));
+        order = order < 1 ? 1 : order > ZOOM_MAX_ORDER ? ZOOM_MAX_ORDER : order;
+
+        float* c = zoom->coef[s];
+        c[0] = 1;
+        for (uint32_t r = 1; r <= order; ++r) {
+            for (k = r; k > 0; --k) {
+                c[k] += c[k - 1];
+            }
+        }
+        zoom->order[s] = order;
+        span += order << s;
+        growth += order;
+    }
+    zoom->stages = s;
+
+    // Blackman windowed sinc, cut off at the Nyquist frequency of the output
+    const double fc = 0.5 / ZOOM_FIR_DEC, mid = (ZOOM_FIR_TAPS - 1) / 2.0;
+    double sum = 0;
+    for (k = 0; k < ZOOM_FIR_TAPS; ++k) {
+        double t = k - mid;
+        double w = 0.42 - 0.5 * cos(2 * M_PI * k / (ZOOM_FIR_TAPS - 1)) + 0.08 * cos(4 * M_PI * k / (ZOOM_FIR_TAPS - 1));
+        double h = sin(2 * M_PI * fc * t) / (M_PI * t) * w;
+        zoom->fir[k] = h;
+        sum += h;
+    }
+    // The binomial stages have a gain of 2^order each
+    const float norm = ldexp(1 / sum, -(int)growth);
+    for (k = 0; k < ZOOM_FIR_TAPS; ++k) {
+        zoom->fir[k] *= norm;
+    }
+    span += (ZOOM_FIR_TAPS - 1) << zoom->stages;
+
+    zoom->skip = (span + decimation - 1) / decimation;
+    zoom->in_len = decimation * (zoom->skip + size - 1) + 1;
+    zoom->chunk = decimation < ZOOM_CHUNK ? ZOOM_CHUNK : decimation;
+
+    // Power response of the chain at every bin, relative to the input sample rate
+    for (uint32_t j = 0; j < size; ++j) {
+        double f = ((double)j - size / 2) / ((double)decimation * size);
+        double resp = 1;
+        for (s = 0; s < zoom->stages; ++s) {
+            resp *= pow(cos(M_PI * f * (1u << s)), 2 * zoom->order[s]);
+        }
+        double fr = 0, fi = 0, ff = f * (1u << zoom->stages);
+        for (k = 0; k < ZOOM_FIR_TAPS; ++k) {
+            fr += zoom->fir[k] * cos(2 * M_PI * ff * k);
+            fi += zoom->fir[k] * sin(2 * M_PI * ff * k);
+        }
+        resp *= ldexp(fr * fr + fi * fi, 2 * growth);
+        gain[j] = (double)decimation * decimation / resp;
+    }
+    return zoom;
+}
+
+uint32_t fft_ZoomInputLength(const fft_zoom_t* zoom)
+{
+    return zoom->in_len;
+}
+
+const float* fft_ZoomGain(const fft_zoom_t* zoom)
+{
+    return zoom->gain;
+}
+
+/* Mixes n samples starting at sample pos of the capture down by center */
+static void fft_ZoomMix(const float* x, uint32_t n, double center, uint32_t pos, float* re, float* im)
+{
+    // Phase of the first sample and steps of one, four and ZOOM_NCO_BLOCK samples
+    double phase = center * (double)pos - floor(center * (double)pos);
+    double br = cos(2 * M_PI * phase), bi = -sin(2 * M_PI * phase);
+    const double sr = cos(2 * M_PI * center * ZOOM_NCO_BLOCK), si = -sin(2 * M_PI * center * ZOOM_NCO_BLOCK);
+    const float wr = cos(2 * M_PI * center * 4), wi = -sin(2 * M_PI * center * 4);
+    float lr[4], li[4];
+    uint32_t i, k, l;
+
+    for (l = 0; l < 4; ++l) {
+        lr[l] = cos(2 * M_PI * center * l);
+        li[l] = -sin(2 * M_PI * center * l);
+    }
+
+    for (i = 0; i + 4 <= n; i += ZOOM_NCO_BLOCK) {
+        const uint32_t block = (n - i < ZOOM_NCO_BLOCK ? n - i : ZOOM_NCO_BLOCK) & ~3u;
+        float pr[4], pi[4];
+        for (l = 0; l < 4; ++l) {
+            pr[l] = br * lr[l] - bi * li[l];
+            pi[l] = br * li[l] + bi * lr[l];
+        }
+        // The block phase is rotated in double precision, so it does not drift
+        double t = br * sr - bi * si;
+        bi = br * si + bi * sr;
+        br = t;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        float32x4_t vr = vld1q_f32(pr), vi = vld1q_f32(pi);
+        for (k = 0; k < block; k += 4) {
+            float32x4_t v = vld1q_f32(x + i + k);
+            vst1q_f32(re + i + k, vmulq_f32(v, vr));
+            vst1q_f32(im + i + k, vmulq_f32(v, vi));
+            float32x4_t t = vsubq_f32(vmulq_n_f32(vr, wr), vmulq_n_f32(vi, wi));
+            vi = vaddq_f32(vmulq_n_f32(vr, wi), vmulq_n_f32(vi, wr));
+            vr = t;
+        }
+#elif defined(__SSE2__)
+        __m128 vr = _mm_loadu_ps(pr), vi = _mm_loadu_ps(pi);
+        const __m128 vwr = _mm_set1_ps(wr), vwi = _mm_set1_ps(wi);
+        for (k = 0; k < block; k += 4) {
+            __m128 v = _mm_loadu_ps(x + i + k);
+            _mm_storeu_ps(re + i + k, _mm_mul_ps(v, vr));
+            _mm_storeu_ps(im + i + k, _mm_mul_ps(v, vi));
+            __m128 t = _mm_sub_ps(_mm_mul_ps(vr, vwr), _mm_mul_ps(vi, vwi));
+            vi = _mm_add_ps(_mm_mul_ps(vr, vwi), _mm_mul_ps(vi, vwr));
+            vr = t;
+        }
+#else
+        for (k = 0; k < block; k += 4) {
+            for (l = 0; l < 4; ++l) {
+                re[i + k + l] = x[i + k + l] * pr[l];
+                im[i + k + l] = x[i + k + l] * pi[l];
+                float t = pr[l] * wr - pi[l] * wi;
+                pi[l] = pr[l] * wi + pi[l] * wr;
+                pr[l] = t;
+            }
+        }
+#endif
+    }
+
+    // Last samples of a capture that is not a multiple of 4
+    for (i = n & ~3u; i < n; ++i) {
+        phase = center * (double)(pos + i);
+        phase -= floor(phase);
+        re[i] = x[i] * cos(2 * M_PI * phase);
+        im[i] = -x[i] * sin(2 * M_PI * phase);
+    }
+}
+
+/* Binomial filter of n samples decimating by 2; x holds order samples of history first */
+static void fft_ZoomHalve(const float* x, uint32_t n, uint32_t order, const float* c, float* y)
+{
+    uint32_t j = 0, k;
+
+    // Four outputs at once from the even samples of x + k
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; j + 4 <= n / 2; j += 4) {
+        float32x4_t acc = vdupq_n_f32(0);
+        for (k = 0; k <= order; ++k) {
+            acc = vmlaq_n_f32(acc, vld2q_f32(x + 2 * j + k).val[0], c[k]);
+        }
+        vst1q_f32(y + j, acc);
+    }
+#elif defined(__SSE2__)
+    for (; j + 4 <= n / 2; j += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (k = 0; k <= order; ++k) {
+            __m128 a = _mm_loadu_ps(x + 2 * j + k), b = _mm_loadu_ps(x + 2 * j + k + 4);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_set1_ps(c[k])));
+        }
+        _mm_storeu_ps(y + j, acc);
+    }
+#endif
+    for (; j < n / 2; ++j) {
+        const float* s = x + 2 * j;
+        float acc = 0;
+        for (k = 0; k <= order; ++k) {
+            acc += c[k] * s[k];
+        }
+        y[j] = acc;
+    }
+}
+
+/* Output of the final FIR filter at x */
+static float fft_ZoomFir(const float* h, const float* x)
+{
+    uint32_t k;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc = vdupq_n_f32(0);
+    for (k = 0; k < ZOOM_FIR_TAPS; k += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(h + k), vld1q_f32(x + k));
+    }
+    float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#elif defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for (k = 0; k < ZOOM_FIR_TAPS; k += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(h + k), _mm_loadu_ps(x + k)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+#else
+    float acc = 0;
+    for (k = 0; k < ZOOM_FIR_TAPS; ++k) {
+        acc += h[k] * x[k];
+    }
+    return acc;
+#endif
+}
+
+int fft_ZoomDecimate(const fft_zoom_t* zoom, const float* in, float center, rp_fft_cpx_t* out)
+{
+    float* bi[ZOOM_MAX_STAGES + 1];
+    float* bq[ZOOM_MAX_STAGES + 1];
+    uint32_t hist[ZOOM_MAX_STAGES + 1];
+    const uint32_t stages = zoom->stages, chunk = zoom->chunk;
+    uint32_t len = 0, s, j;
+
+    // Every stage keeps the last samples of the previous chunk in front of the new ones
+    for (s = 0; s <= stages; ++s) {
+        hist[s] = s < stages ? zoom->order[s] : ZOOM_FIR_TAPS - 1;
+        len += 2 * (hist[s] + (chunk >> s));
+    }
+    float* work = calloc(len, sizeof(float));
+    if (work == NULL) {
+        return RP_EOOR;
+    }
+    float* p = work;
+    for (s = 0; s <= stages; ++s) {
+        bi[s] = p;
+        bq[s] = p + hist[s] + (chunk >> s);
+        p += 2 * (hist[s] + (chunk >> s));
+    }
+
+    const uint32_t outputs = zoom->skip + zoom->size;
+    const uint32_t fir_len = chunk >> stages;
+    uint32_t done = 0;
+    for (uint32_t pos = 0; done < outputs; pos += chunk) {
+        uint32_t n = zoom->in_len - pos < chunk ? zoom->in_len - pos : chunk;
+        fft_ZoomMix(in + pos, n, center, pos, bi[0] + hist[0], bq[0] + hist[0]);
+        if (n < chunk) {
+            memset(bi[0] + hist[0] + n, 0, (chunk - n) * sizeof(float));
+            memset(bq[0] + hist[0] + n, 0, (chunk - n) * sizeof(float));
+        }
+
+        for (s = 0; s < stages; ++s) {
+            const uint32_t m = chunk >> s;
+            fft_ZoomHalve(bi[s], m, zoom->order[s], zoom->coef[s], bi[s + 1] + hist[s + 1]);
+            fft_ZoomHalve(bq[s], m, zoom->order[s], zoom->coef[s], bq[s + 1] + hist[s + 1]);
+            memmove(bi[s], bi[s] + m, hist[s] * sizeof(float));
+            memmove(bq[s], bq[s] + m, hist[s] * sizeof(float));
+        }
+
+        for (j = 0; j < fir_len / ZOOM_FIR_DEC; ++j, ++done) {
+            if (done < zoom->skip || done >= outputs) {
+                continue;
+            }
+            out[done - zoom->skip].r = fft_ZoomFir(zoom->fir, bi[stages] + j * ZOOM_FIR_DEC);
+            out[done - zoom->skip].i = fft_ZoomFir(zoom->fir, bq[stages] + j * ZOOM_FIR_DEC);
+        }
+        memmove(bi[stages], bi[stages] + fir_len, hist[stages] * sizeof(float));
+        memmove(bq[stages], bq[stages] + fir_len, hist[stages] * sizeof(float));
+    }
+
+    free(work);
+    return RP_OK;
+}
+
+void fft_ZoomDestroy(fft_zoom_t* zoom)
+{
+    if (zoom) {
+        free(zoom->gain);
+        free(zoom);
+    }
+}
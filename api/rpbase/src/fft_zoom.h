@@ -0,0 +1,33 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library zoom FFT down conversion interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_FFT_ZOOM_H_
+#define SRC_FFT_ZOOM_H_
+
+#include <stdint.h>
+#include "redpitaya/rp_fft.h"
+
+/* @brief Decimations of the zoom, powers of two. */
+#define FFT_ZOOM_MIN_DECIMATION     4
+#define FFT_ZOOM_MAX_DECIMATION     65536
+
+typedef struct fft_zoom fft_zoom_t;
+
+fft_zoom_t* fft_ZoomCreate(uint32_t decimation, uint32_t size);
+uint32_t fft_ZoomInputLength(const fft_zoom_t* zoom);
+const float* fft_ZoomGain(const fft_zoom_t* zoom);
+int fft_ZoomDecimate(const fft_zoom_t* zoom, const float* in, float center, rp_fft_cpx_t* out);
+void fft_ZoomDestroy(fft_zoom_t* zoom);
+
+#endif /* SRC_FFT_ZOOM_H_ */
@@ -12,7 +12,8 @@
 * for more details on the language used herein.
 */
 
-#include <float.h>
+#include <stdlib.h>
+#include <string.h>
 #include "math.h"
 #include "common.h"
 #include "generate.h"
@@ -35,7 +36,62 @@ uint32_t      chA_arb_size = BUFFER_LENGTH, chB_arb_size = BUFFER_LENGTH;
 float chA_arbitraryData[BUFFER_LENGTH];
 float chB_arbitraryData[BUFFER_LENGTH];
 
+/* @brief User waveform of a channel and its DAC counts, converted when it was set. */
+typedef struct {
+    float *data;            // chX_arbitraryData, or a buffer handed over with gen_moveArbWaveform()
+    bool owned;             // 'data' was handed over and is freed when replaced
+    bool cnts_valid;
+    uint32_t cnts[BUFFER_LENGTH];
+} arb_wave_t;
+
+static arb_wave_t arb_wave[2] = { { .data = chA_arbitraryData }, { .data = chB_arbitraryData } };
+
+/* @brief Number of cached waveform base tables. */
+#define WAVE_CACHE_SIZE 8
+
+/* @brief Normalized base table of a waveform, keyed by the waveform and its shape parameter. */
+typedef struct {
+    bool valid;
+    rp_waveform_t waveform;
+    int param;              // square: transition length, PWM: high samples, otherwise 0
+    uint64_t used;          // cache clock of the last use, the oldest entry is replaced
+    float data[BUFFER_LENGTH];
+} wave_table_t;
+
+/* @brief Key and size of the samples last written to a channel buffer. */
+typedef struct {
+    bool valid;
+    rp_waveform_t waveform;
+    int param;
+    uint32_t size;
+} wave_loaded_t;
+
+/* @brief Shortest table played in DDS mode; half the buffer keeps the waveform resolution. */
+#define DDS_SIZE_MIN    (BUFFER_LENGTH / 2)
+
+/* @brief Software DDS state of a channel: one period of the waveform resampled to 'size' samples. */
+typedef struct {
+    uint32_t size;          // 0 when the whole buffer holds one period
+    uint32_t step;          // pointer step of the frequency set last
+} dds_state_t;
+
+static dds_state_t dds[2];
+static wave_table_t wave_cache[WAVE_CACHE_SIZE];
+static uint64_t wave_cache_clock = 0;
+static wave_loaded_t wave_loaded[2];
+
+static uint32_t getTableSize(rp_channel_t channel);
+static int pwmHighSamples(float ratio);
+static void pwmTable(int h, float *data_out);
+static int squareTransition(float frequency);
+static void squareTable(int trans, float *data_out);
+static void resampleTable(const float *table, uint32_t size, float *data_out);
+
 int gen_SetDefaultValues() {
+    // Reinitialization may have changed the buffers behind our back
+    wave_loaded[0].valid = false;
+    wave_loaded[1].valid = false;
+    dds[0].size = dds[1].size = 0;
     ECHECK(gen_Disable(RP_CH_1));
     ECHECK(gen_Disable(RP_CH_2));
     ECHECK(gen_setFrequency(RP_CH_1, 1000));
@@ -135,12 +191,153 @@ int gen_setFrequency(rp_channel_t channel, float frequency) {
         return RP_EPN;
     }
 
+    // Leaves DDS mode, the whole buffer holds one period again
+    dds[channel == RP_CH_1 ? 0 : 1].size = 0;
     ECHECK(generate_setFrequency(channel, frequency));
     ECHECK(synthesize_signal(channel));
     return gen_Synchronise();
 }
 
+/**
+ * Finds the DDS table length, from BUFFER_LENGTH down to DDS_SIZE_MIN, for
+ * which the pointer steps come closest to all the frequencies given. The
+ * search stops at the longest table within 'accuracy' of every frequency.
+ */
+int gen_planDds(const double *frequencies, uint32_t count, double accuracy, uint32_t *size, double *error) {
+    if (count == 0 || !(accuracy >= 0)) {
+        return RP_EOOR;
+    }
+
+    double best = INFINITY;
+    for (uint32_t n = BUFFER_LENGTH; n >= DDS_SIZE_MIN && best > accuracy; --n) {
+        const double resolution = DAC_FREQUENCY / (65536.0 * n);
+        double worst = 0;
+        for (uint32_t i = 0; i < count && worst < best; ++i) {
+            double err = fabs(round(frequencies[i] / resolution) * resolution - frequencies[i]);
+            worst = MAX(worst, err);
+        }
+        if (worst < best) {
+            best = worst;
+            *size = n;
+        }
+    }
+    *error = best;
+    return RP_OK;
+}
+
+/**
+ * Switches a channel to a DDS table of 'size' samples. The buffer is only
+ * rewritten when the table length changes; the pointer step is left alone.
+ */
+int gen_setDdsSize(rp_channel_t channel, uint32_t size) {
+    rp_waveform_t waveform;
+    CHANNEL_ACTION(channel,
+            waveform = chA_waveform,
+            waveform = chB_waveform)
+    if (waveform == RP_WAVEFORM_ARBITRARY) {
+        return RP_EIPV;
+    }
+    if (size < DDS_SIZE_MIN || size > BUFFER_LENGTH) {
+        return RP_EOOR;
+    }
+    dds[channel == RP_CH_1 ? 0 : 1].size = size;
+    return synthesize_signal(channel);
+}
+
+int gen_setDdsFrequency(rp_channel_t channel, double frequency, double accuracy, double *actual) {
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (frequency < FREQUENCY_MIN || frequency > FREQUENCY_MAX) {
+        return RP_EOOR;
+    }
+
+    // Keep the table the channel plays if it is accurate enough, saving a buffer rewrite
+    dds_state_t *state = &dds[channel == RP_CH_1 ? 0 : 1];
+    uint32_t size = state->size;
+    double error = INFINITY;
+    if (size) {
+        const double resolution = DAC_FREQUENCY / (65536.0 * size);
+        error = fabs(round(frequency / resolution) * resolution - frequency);
+    }
+    if (!(error <= accuracy)) {
+        ECHECK(gen_planDds(&frequency, 1, accuracy, &size, &error));
+        ECHECK(gen_setDdsSize(channel, size));
+    }
+
+    state->step = generate_cnvFrequencySize(frequency, size);
+    *actual = state->step * DAC_FREQUENCY / (65536.0 * size);
+
+    if (channel == RP_CH_1) {
+        chA_frequency = *actual;
+        gen_setBurstPeriod(channel, chA_burstPeriod);
+    }
+    else {
+        chB_frequency = *actual;
+        gen_setBurstPeriod(channel, chB_burstPeriod);
+    }
+    ECHECK(generate_setStep(channel, state->step));
+    return gen_Synchronise();
+}
+
+/* Pointer step of a frequency for the table the channel plays, as sweeps program it */
+uint32_t gen_cnvFrequency(rp_channel_t channel, double frequency) {
+    const dds_state_t *state = &dds[channel == RP_CH_1 ? 0 : 1];
+    return state->size ? generate_cnvFrequencySize(frequency, state->size) : generate_cnvFrequency(frequency);
+}
+
+/**
+ * Checks a point of a sweep against the limits of gen_setFrequency() and
+ * gen_setAmplitude() with the current offset.
+ */
+int gen_checkSweepPoint(rp_channel_t channel, double frequency, float amplitude) {
+    if (frequency < FREQUENCY_MIN || frequency > FREQUENCY_MAX) {
+        return RP_EOOR;
+    }
+    float offset;
+    CHANNEL_ACTION(channel,
+            offset = chA_offset,
+            offset = chB_offset)
+    return gen_checkAmplitudeAndOffset(amplitude, offset);
+}
+
+/**
+ * Records the frequency and amplitude a sweep left in the registers, so that
+ * later changes are checked and synthesized against them.
+ */
+int gen_setSweepPoint(rp_channel_t channel, double frequency, float amplitude) {
+    CHANNEL_ACTION(channel,
+            chA_frequency = frequency,
+            chB_frequency = frequency)
+    dds[channel == RP_CH_1 ? 0 : 1].step = gen_cnvFrequency(channel, frequency);
+    CHANNEL_ACTION(channel,
+            chA_amplitude = amplitude,
+            chB_amplitude = amplitude)
+    return RP_OK;
+}
+
+/**
+ * Restores the configured signal of a channel after its buffer and pointer
+ * registers were used for something else, like streaming playback.
+ */
+int gen_Reload(rp_channel_t channel) {
+    float frequency;
+    CHANNEL_ACTION(channel,
+            frequency = chA_frequency,
+            frequency = chB_frequency)
+    const dds_state_t *state = &dds[channel == RP_CH_1 ? 0 : 1];
+    wave_loaded[channel == RP_CH_1 ? 0 : 1].valid = false;
+    ECHECK(state->size ? generate_setStep(channel, state->step) : generate_setFrequency(channel, frequency));
+    ECHECK(synthesize_signal(channel));
+    return triggerIfInternal(channel);
+}
+
 int gen_getFrequency(rp_channel_t channel, float *frequency) {
+    const dds_state_t *state = &dds[channel == RP_CH_1 ? 0 : 1];
+    if (state->size) {
+        *frequency = state->step * DAC_FREQUENCY / (65536.0 * state->size);
+        return RP_OK;
+    }
     return generate_getFrequency(channel, frequency);
 }
 
@@ -155,7 +352,8 @@ int gen_setPhase(rp_channel_t channel, float phase) {
             chA_phase = phase,
             chB_phase = phase)
 
-    ECHECK(synthesize_signal(channel));
+    // Only the start offset moves, the buffer is not rewritten
+    ECHECK(generate_setPhase(channel, phase, getTableSize(channel)));
     return gen_Synchronise();
 }
 
@@ -174,6 +372,11 @@ int gen_setWaveform(rp_channel_t channel, rp_waveform_t type) {
         CHANNEL_ACTION(channel,
                 chA_size = chA_arb_size,
                 chB_size = chB_arb_size)
+        // User data sets its own period, there is no table to resample
+        if (dds[channel == RP_CH_1 ? 0 : 1].size) {
+            dds[channel == RP_CH_1 ? 0 : 1].size = 0;
+            ECHECK(generate_setFrequency(channel, channel == RP_CH_1 ? chA_frequency : chB_frequency));
+        }
     }
     else{
         CHANNEL_ACTION(channel,
@@ -190,68 +393,94 @@ int gen_getWaveform(rp_channel_t channel, rp_waveform_t *type) {
     return RP_OK;
 }
 
-int gen_setArbWaveform(rp_channel_t channel, float *data, uint32_t length) {
-    // Check if data is normalized
-    float min = FLT_MAX, max = -FLT_MAX; // initial values
-    int i;
-    for(i = 0; i < length; i++) {
-        if (data[i] < min)
-            min = data[i];
-        if (data[i] > max)
-            max = data[i];
-    }
-    if (min < ARBITRARY_MIN || max > ARBITRARY_MAX) {
+/**
+ * Range checks the user data and converts it to DAC counts in a single pass.
+ * The counts are only kept if the data is accepted.
+ */
+static int arbConvert(rp_channel_t channel, const float *data, uint32_t length) {
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (length == 0 || length > BUFFER_LENGTH) {
+        return RP_EOOR;
+    }
+
+    arb_wave_t *arb = &arb_wave[channel == RP_CH_1 ? 0 : 1];
+    arb->cnts_valid = false;
+    if (!cmn_CnvVToCntBlock(DATA_BIT_LENGTH, data, arb->cnts, length, AMPLITUDE_MAX, 0)) {
         return RP_ENN;
     }
+    memset(arb->cnts + length, 0, (BUFFER_LENGTH - length) * sizeof(uint32_t));
+    arb->cnts_valid = true;
+    return RP_OK;
+}
+
+/**
+ * Takes 'data' as the user waveform of the channel, freeing a buffer handed over before.
+ * A handed over buffer is only kept once the generator was updated from it. If that
+ * fails, the waveform is kept in the channel's own storage and the buffer stays
+ * with the caller.
+ */
+static int arbStore(rp_channel_t channel, float *data, bool owned, uint32_t length) {
+    arb_wave_t *arb = &arb_wave[channel == RP_CH_1 ? 0 : 1];
+    float *storage = channel == RP_CH_1 ? chA_arbitraryData : chB_arbitraryData;
+    if (arb->owned && arb->data != data) {
+        free(arb->data);
+    }
+    arb->data = data;
+    arb->owned = false;
 
-    // Save data
-    float *pointer;
     CHANNEL_ACTION(channel,
-            pointer = chA_arbitraryData,
-            pointer = chB_arbitraryData)
-    for(i = 0; i < length; i++) {
-        pointer[i] = data[i];
-    }
-    for(i = length; i < BUFFER_LENGTH; i++) { // clear the rest of the buffer
-        pointer[i] = 0;
+            chA_arb_size = length,
+            chB_arb_size = length)
+    int ret = RP_OK;
+    if ((channel == RP_CH_1 ? chA_waveform : chB_waveform) == RP_WAVEFORM_ARBITRARY) {
+        // The period played follows the new length
+        CHANNEL_ACTION(channel,
+                chA_size = length,
+                chB_size = length)
+        ret = synthesize_signal(channel);
     }
 
-    if (channel == RP_CH_1) {
-        chA_arb_size = length;
-        if(chA_waveform==RP_WAVEFORM_ARBITRARY){
-        	return synthesize_signal(channel);
-        }
-    }
-    else if (channel == RP_CH_2) {
-    	chA_arb_size = length;
-        if(chB_waveform==RP_WAVEFORM_ARBITRARY){
-        	return synthesize_signal(channel);
-        }
+    if (ret == RP_OK) {
+        arb->owned = owned;
     }
-    else {
-        return RP_EPN;
+    else if (data != storage) {
+        memcpy(storage, data, length * sizeof(float));
+        arb->data = storage;
     }
+    return ret;
+}
 
-    return RP_OK;
+int gen_setArbWaveform(rp_channel_t channel, float *data, uint32_t length) {
+    ECHECK(arbConvert(channel, data, length));
+    float *storage = channel == RP_CH_1 ? chA_arbitraryData : chB_arbitraryData;
+    memcpy(storage, data, length * sizeof(float));
+    return arbStore(channel, storage, false, length);
+}
+
+int gen_moveArbWaveform(rp_channel_t channel, float *data, uint32_t length) {
+    ECHECK(arbConvert(channel, data, length));
+    return arbStore(channel, data, true, length);
 }
 
 int gen_getArbWaveform(rp_channel_t channel, float *data, uint32_t *length) {
     // If this data was not set, then this method will return incorrect data
-    float *pointer;
-    if (channel == RP_CH_1) {
-        *length = chA_arb_size;
-        pointer = chA_arbitraryData;
-    }
-    else if (channel == RP_CH_2) {
-        *length = chB_arb_size;
-        pointer = chB_arbitraryData;
-    }
-    else {
-        return RP_EPN;
-    }
-    for (int i = 0; i < *length; ++i) {
-        data[i] = pointer[i];
+    CHANNEL_ACTION(channel,
+            *length = chA_arb_size,
+            *length = chB_arb_size)
+    memcpy(data, arb_wave[channel == RP_CH_1 ? 0 : 1].data, *length * sizeof(float));
+    return RP_OK;
+}
+
+int gen_Release() {
+    for (int i = 0; i < 2; ++i) {
+        if (arb_wave[i].owned) {
+            free(arb_wave[i].data);
+        }
     }
+    arb_wave[0] = (arb_wave_t) { .data = chA_arbitraryData };
+    arb_wave[1] = (arb_wave_t) { .data = chB_arbitraryData };
     return RP_OK;
 }
 
@@ -342,6 +571,60 @@ int gen_setBurstRepetitions(rp_channel_t channel, int repetitions) {
     return triggerIfInternal(channel);
 }
 
+int gen_setBursts(int num) {
+    if (num < 1 || num > BURST_COUNT_MAX) {
+        return RP_EOOR;
+    }
+    // Both channels wait for the trigger, which is not given here
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        ECHECK(generate_setGatedBurst(channel, 0));
+        ECHECK(generate_setTriggerSource(channel, 0));
+    }
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        ECHECK(gen_setBurstCount(channel, num));
+        ECHECK(gen_setBurstRepetitions(channel, 1));
+        ECHECK(gen_setBurstPeriod(channel, BURST_PERIOD_MIN));
+    }
+    return RP_OK;
+}
+
+int gen_getBurstState(gen_burst_state_t *state) {
+    state->burstCount[0] = chA_burstCount;
+    state->burstCount[1] = chB_burstCount;
+    state->burstRepetition[0] = chA_burstRepetition;
+    state->burstRepetition[1] = chB_burstRepetition;
+    state->burstPeriod[0] = chA_burstPeriod;
+    state->burstPeriod[1] = chB_burstPeriod;
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        ECHECK(generate_getBurstCount(channel, &state->cycles[channel]));
+        ECHECK(generate_getBurstRepetitions(channel, &state->repetitions[channel]));
+        ECHECK(generate_getBurstDelay(channel, &state->delay[channel]));
+        ECHECK(generate_getGatedBurst(channel, &state->gated[channel]));
+        ECHECK(generate_getTriggerSource(channel, &state->trigSelector[channel]));
+    }
+    return RP_OK;
+}
+
+/* Brings back the settings of gen_getBurstState(); the trigger source is set last, as it may start the channel */
+int gen_setBurstState(const gen_burst_state_t *state) {
+    chA_burstCount = state->burstCount[0];
+    chB_burstCount = state->burstCount[1];
+    chA_burstRepetition = state->burstRepetition[0];
+    chB_burstRepetition = state->burstRepetition[1];
+    chA_burstPeriod = state->burstPeriod[0];
+    chB_burstPeriod = state->burstPeriod[1];
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        ECHECK(generate_setBurstCount(channel, state->cycles[channel]));
+        ECHECK(generate_setBurstRepetitions(channel, state->repetitions[channel]));
+        ECHECK(generate_setBurstDelay(channel, state->delay[channel]));
+        ECHECK(generate_setGatedBurst(channel, state->gated[channel]));
+    }
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        ECHECK(generate_setTriggerSource(channel, state->trigSelector[channel]));
+    }
+    return RP_OK;
+}
+
 int gen_getBurstRepetitions(rp_channel_t channel, int *repetitions) {
     uint32_t tmp;
     ECHECK(generate_getBurstRepetitions(channel, &tmp));
@@ -446,69 +729,174 @@ int gen_Synchronise() {
     return generate_Synchronise();
 }
 
+/* Number of samples played per period: the user data length or the whole buffer */
+static uint32_t getTableSize(rp_channel_t channel) {
+    if (channel == RP_CH_1) {
+        return chA_waveform == RP_WAVEFORM_ARBITRARY ? chA_arb_size : (dds[0].size ? dds[0].size : BUFFER_LENGTH);
+    }
+    return chB_waveform == RP_WAVEFORM_ARBITRARY ? chB_arb_size : (dds[1].size ? dds[1].size : BUFFER_LENGTH);
+}
+
+/**
+ * Returns the base table of a waveform from the cache, synthesizing it on a
+ * miss into the least recently used entry. Tables are normalized to [-1, 1]
+ * and only depend on the waveform key, so amplitude, offset, phase and most
+ * frequency changes are served without recomputing any sample.
+ */
+static const float* getWaveTable(rp_waveform_t waveform, int param) {
+    wave_table_t *table = NULL;
+
+    for (int i = 0; i < WAVE_CACHE_SIZE; i++) {
+        wave_table_t *entry = &wave_cache[i];
+        if (entry->valid && entry->waveform == waveform && entry->param == param) {
+            entry->used = ++wave_cache_clock;
+            return entry->data;
+        }
+        if (table == NULL || !entry->valid || (table->valid && entry->used < table->used)) {
+            table = entry;
+        }
+    }
+
+    switch (waveform) {
+        case RP_WAVEFORM_SINE     : synthesis_sin      (table->data);        break;
+        case RP_WAVEFORM_TRIANGLE : synthesis_triangle (table->data);        break;
+        case RP_WAVEFORM_SQUARE   : squareTable        (param, table->data); break;
+        case RP_WAVEFORM_RAMP_UP  : synthesis_rampUp   (table->data);        break;
+        case RP_WAVEFORM_RAMP_DOWN: synthesis_rampDown (table->data);        break;
+        case RP_WAVEFORM_DC       : synthesis_DC       (table->data);        break;
+        case RP_WAVEFORM_PWM      : pwmTable           (param, table->data); break;
+        default:                    return NULL;
+    }
+    table->valid = true;
+    table->waveform = waveform;
+    table->param = param;
+    table->used = ++wave_cache_clock;
+    return table->data;
+}
+
 int synthesize_signal(rp_channel_t channel) {
     float data[BUFFER_LENGTH];
+    const float *table;
     rp_waveform_t waveform;
-    float dutyCycle, frequency;
-    uint32_t size, phase;
+    float dutyCycle, frequency, phase;
+    uint32_t size;
+    int param = 0;
 
     if (channel == RP_CH_1) {
         waveform = chA_waveform;
         dutyCycle = chA_dutyCycle;
         frequency = chA_frequency;
         size = chA_size;
-        phase = (uint32_t) (chA_phase * BUFFER_LENGTH / 360.0);
+        phase = chA_phase;
     }
     else if (channel == RP_CH_2) {
         waveform = chB_waveform;
         dutyCycle = chB_dutyCycle;
         frequency = chB_frequency;
     	size = chB_size;
-        phase = (uint32_t) (chB_phase * BUFFER_LENGTH / 360.0);
+        phase = chB_phase;
     }
     else{
         return RP_EPN;
     }
 
-    switch (waveform) {
-        case RP_WAVEFORM_SINE     : synthesis_sin      (data);                 break;
-        case RP_WAVEFORM_TRIANGLE : synthesis_triangle (data);                 break;
-        case RP_WAVEFORM_SQUARE   : synthesis_square   (frequency, data);      break;
-        case RP_WAVEFORM_RAMP_UP  : synthesis_rampUp   (data);                 break;
-        case RP_WAVEFORM_RAMP_DOWN: synthesis_rampDown (data);                 break;
-        case RP_WAVEFORM_DC       : synthesis_DC       (data);                 break;
-        case RP_WAVEFORM_PWM      : synthesis_PWM      (dutyCycle, data);      break;
-        case RP_WAVEFORM_ARBITRARY: synthesis_arbitrary(channel, data, &size); break;
-        default:                    return RP_EIPV;
+    wave_loaded_t *loaded = &wave_loaded[channel == RP_CH_1 ? 0 : 1];
+
+    // The phase is a start offset in units of the table size, which the waveform may change
+    ECHECK(generate_setPhase(channel, phase, getTableSize(channel)));
+
+    if (waveform == RP_WAVEFORM_ARBITRARY) {
+        // User data may change without a change of the key, it is always written; the counts are ready
+        arb_wave_t *arb = &arb_wave[channel == RP_CH_1 ? 0 : 1];
+        loaded->valid = false;
+        if (arb->cnts_valid) {
+            return generate_writeCounts(channel, arb->cnts, size);
+        }
+        synthesis_arbitrary(channel, data, &size);
+        return generate_writeData(channel, data, 0, size);
+    }
+
+    // In DDS mode one period of the base table is resampled to the DDS table length
+    size = getTableSize(channel);
+    if (waveform == RP_WAVEFORM_SQUARE) {
+        param = squareTransition(frequency);
+    }
+    else if (waveform == RP_WAVEFORM_PWM) {
+        param = pwmHighSamples(dutyCycle);
+    }
+
+    // The buffer already holds these samples, only registers have changed
+    if (loaded->valid && loaded->waveform == waveform && loaded->param == param && loaded->size == size) {
+        return RP_OK;
+    }
+
+    table = getWaveTable(waveform, param);
+    if (table == NULL) {
+        return RP_EIPV;
+    }
+    if (size != BUFFER_LENGTH) {
+        resampleTable(table, size, data);
+        table = data;
     }
-    return generate_writeData(channel, data, phase, size);
+    ECHECK(generate_writeData(channel, table, 0, size));
+
+    loaded->valid = true;
+    loaded->waveform = waveform;
+    loaded->param = param;
+    loaded->size = size;
+    return RP_OK;
 }
 
+/**
+ * The periodic waveforms are built in closed form over one quarter or the
+ * whole period, without a transcendental call per sample. Only the sine needs
+ * sin(), for the first quarter, the rest follows from its symmetry.
+ */
 int synthesis_sin(float *data_out) {
-    for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
+    const int quarter = BUFFER_LENGTH / 4;
+
+    for (int i = 0; i <= quarter; i++) {
         data_out[i] = (float) (sin(2 * M_PI * (float) i / (float) BUFFER_LENGTH));
     }
+    for (int i = 1; i < quarter; i++) {
+        data_out[2 * quarter - i] = data_out[i];
+    }
+    for (int i = 0; i < 2 * quarter; i++) {
+        data_out[2 * quarter + i] = -data_out[i];
+    }
     return RP_OK;
 }
 
 int synthesis_triangle(float *data_out) {
-    for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
-        data_out[i] = (float) ((asin(sin(2 * M_PI * (float) i / (float) BUFFER_LENGTH)) / M_PI * 2));
+    const float step = 4.0f / BUFFER_LENGTH;
+
+    for (int i = 0; i < BUFFER_LENGTH / 4; i++) {
+        data_out[i] = step * i;
+    }
+    for (int i = BUFFER_LENGTH / 4; i < BUFFER_LENGTH * 3 / 4; i++) {
+        data_out[i] = 2.0f - step * i;
+    }
+    for (int i = BUFFER_LENGTH * 3 / 4; i < BUFFER_LENGTH; i++) {
+        data_out[i] = step * i - 4.0f;
     }
     return RP_OK;
 }
 
 int synthesis_rampUp(float *data_out) {
-    data_out[BUFFER_LENGTH -1] = 0;
-    for(int unsigned i = 0; i < BUFFER_LENGTH-1; i++) {
-        data_out[BUFFER_LENGTH - i-2] = (float) (-1.0 * (acos(cos(M_PI * (float) i / (float) BUFFER_LENGTH)) / M_PI - 1));
+    const float step = 1.0f / BUFFER_LENGTH;
+
+    for (int i = 0; i < BUFFER_LENGTH - 1; i++) {
+        data_out[i] = step * (i + 2);
     }
+    data_out[BUFFER_LENGTH - 1] = 0;
     return RP_OK;
 }
 
 int synthesis_rampDown(float *data_out) {
-    for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
-        data_out[i] = (float) (-1.0 * (acos(cos(M_PI * (float) i / (float) BUFFER_LENGTH)) / M_PI - 1));
+    const float step = 1.0f / BUFFER_LENGTH;
+
+    for (int i = 0; i < BUFFER_LENGTH; i++) {
+        data_out[i] = 1.0f - step * i;
     }
     return RP_OK;
 }
@@ -520,36 +908,33 @@ int synthesis_DC(float *data_out) {
     return RP_OK;
 }
 
-int synthesis_PWM(float ratio, float *data_out) {
-    // calculate number of samples that need to be high
-    int h = (int) (BUFFER_LENGTH/2 * ratio);
+/* Number of samples at the beginning and at the end of the period that are high */
+static int pwmHighSamples(float ratio) {
+    return (int) (BUFFER_LENGTH/2 * ratio);
+}
 
-    for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
-        if (i < h || i >= BUFFER_LENGTH - h) {
-            data_out[i] = 1.0;
-        }
-        else {
-            data_out[i] = (float) -1.0;
-        }
+static void pwmTable(int h, float *data_out) {
+    for(int i = 0; i < BUFFER_LENGTH; i++) {
+        data_out[i] = (i < h || i >= BUFFER_LENGTH - h) ? 1.0f : -1.0f;
     }
+}
+
+int synthesis_PWM(float ratio, float *data_out) {
+    pwmTable(pwmHighSamples(ratio), data_out);
     return RP_OK;
 }
 
 int synthesis_arbitrary(rp_channel_t channel, float *data_out, uint32_t * size) {
-    float *pointer;
-    CHANNEL_ACTION(channel,
-            pointer = chA_arbitraryData,
-            pointer = chB_arbitraryData)
-    for (int unsigned i = 0; i < BUFFER_LENGTH; i++) {
-        data_out[i] = pointer[i];
-    }
     CHANNEL_ACTION(channel,
             *size = chA_arb_size,
             *size = chB_arb_size)
+    memcpy(data_out, arb_wave[channel == RP_CH_1 ? 0 : 1].data, *size * sizeof(float));
+    memset(data_out + *size, 0, (BUFFER_LENGTH - *size) * sizeof(float));
     return RP_OK;
 }
 
-int synthesis_square(float frequency, float *data_out) {
+/* Length of the square wave edges in samples, the only frequency dependent part of any table */
+static int squareTransition(float frequency) {
     // Various locally used constants - HW specific parameters
     const int trans0 = 30;
     const int trans1 = 300;
@@ -557,14 +942,42 @@ int synthesis_square(float frequency, float *data_out) {
     int trans = (int) (frequency / 1e6 * trans1); // 300 samples at 1 MHz
 
     if (trans <= 10)  trans = trans0;
+    return trans;
+}
 
-    for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
-        if      ((0 <= i                      ) && (i <  BUFFER_LENGTH/2 - trans))  data_out[i] =  1.0f;
-        else if ((i >= BUFFER_LENGTH/2 - trans) && (i <  BUFFER_LENGTH/2        ))  data_out[i] =  1.0f - (2.0f / trans) * (i - (BUFFER_LENGTH/2 - trans));
-        else if ((0 <= BUFFER_LENGTH/2        ) && (i <  BUFFER_LENGTH   - trans))  data_out[i] = -1.0f;
-        else if ((i >= BUFFER_LENGTH   - trans) && (i <  BUFFER_LENGTH          ))  data_out[i] = -1.0f + (2.0f / trans) * (i - (BUFFER_LENGTH   - trans));
+static void squareTable(int trans, float *data_out) {
+    const int half = BUFFER_LENGTH / 2;
+    const float slope = 2.0f / trans;
+
+    for (int i = 0; i < half - trans; i++) {
+        data_out[i] = 1.0f;
+    }
+    // Above 27 MHz the edges take the whole half period
+    for (int i = MAX(half - trans, 0); i < half; i++) {
+        data_out[i] = 1.0f - slope * (i - (half - trans));
+    }
+    for (int i = half; i < BUFFER_LENGTH - trans; i++) {
+        data_out[i] = -1.0f;
     }
+    for (int i = MAX(BUFFER_LENGTH - trans, half); i < BUFFER_LENGTH; i++) {
+        data_out[i] = -1.0f + slope * (i - (BUFFER_LENGTH - trans));
+    }
+}
+
+/* One period of a base table in 'size' samples, linearly interpolated; the rest of the buffer is cleared */
+static void resampleTable(const float *table, uint32_t size, float *data_out) {
+    const double ratio = (double) BUFFER_LENGTH / size;
+    for (uint32_t i = 0; i < size; i++) {
+        double pos = i * ratio;
+        uint32_t j = (uint32_t) pos;
+        float frac = (float) (pos - j);
+        data_out[i] = table[j] + frac * (table[(j + 1) % BUFFER_LENGTH] - table[j]);
+    }
+    memset(data_out + size, 0, (BUFFER_LENGTH - size) * sizeof(float));
+}
 
+int synthesis_square(float frequency, float *data_out) {
+    squareTable(squareTransition(frequency), data_out);
     return RP_OK;
 }
 
@@ -18,6 +18,18 @@
 
 #include "redpitaya/rp.h"
 
+/* @brief Burst and trigger settings of both channels, as kept by the handler and set in the FPGA. */
+typedef struct {
+    int burstCount[2];
+    int burstRepetition[2];
+    uint32_t burstPeriod[2];
+    uint32_t cycles[2];         // FPGA burst count, 0 in continuous mode
+    uint32_t repetitions[2];
+    uint32_t delay[2];
+    uint32_t gated[2];
+    uint32_t trigSelector[2];
+} gen_burst_state_t;
+
 int gen_SetDefaultValues();
 int gen_Disable(rp_channel_t chanel);
 int gen_Enable(rp_channel_t chanel);
@@ -28,12 +40,21 @@ int gen_setOffset(rp_channel_t channel, float offset) ;
 int gen_getOffset(rp_channel_t channel, float *offset) ;
 int gen_setFrequency(rp_channel_t channel, float frequency);
 int gen_getFrequency(rp_channel_t channel, float *frequency);
+int gen_planDds(const double *frequencies, uint32_t count, double accuracy, uint32_t *size, double *error);
+int gen_setDdsSize(rp_channel_t channel, uint32_t size);
+int gen_setDdsFrequency(rp_channel_t channel, double frequency, double accuracy, double *actual);
+uint32_t gen_cnvFrequency(rp_channel_t channel, double frequency);
+int gen_checkSweepPoint(rp_channel_t channel, double frequency, float amplitude);
+int gen_setSweepPoint(rp_channel_t channel, double frequency, float amplitude);
+int gen_Reload(rp_channel_t channel);
 int gen_setPhase(rp_channel_t channel, float phase);
 int gen_getPhase(rp_channel_t channel, float *phase);
 int gen_setWaveform(rp_channel_t channel, rp_waveform_t type);
 int gen_getWaveform(rp_channel_t channel, rp_waveform_t *type);
 int gen_setArbWaveform(rp_channel_t channel, float *data, uint32_t length);
+int gen_moveArbWaveform(rp_channel_t channel, float *data, uint32_t length);
 int gen_getArbWaveform(rp_channel_t channel, float *data, uint32_t *length);
+int gen_Release();
 int gen_setDutyCycle(rp_channel_t channel, float ratio);
 int gen_getDutyCycle(rp_channel_t channel, float *ratio);
 int gen_setGenMode(rp_channel_t channel, rp_gen_mode_t mode);
@@ -42,6 +63,9 @@ int gen_setBurstCount(rp_channel_t channel, int num);
 int gen_getBurstCount(rp_channel_t channel, int *num);
 int gen_setBurstRepetitions(rp_channel_t channel, int repetitions);
 int gen_getBurstRepetitions(rp_channel_t channel, int *repetitions);
+int gen_setBursts(int num);
+int gen_getBurstState(gen_burst_state_t *state);
+int gen_setBurstState(const gen_burst_state_t *state);
 int gen_setBurstPeriod(rp_channel_t channel, uint32_t period);
 int gen_getBurstPeriod(rp_channel_t channel, uint32_t *period);
 int gen_setTriggerSource(rp_channel_t chanel, rp_trig_src_t src);
@@ -20,17 +20,24 @@
 #include "common.h"
 #include "generate.h"
 #include "calib.h"
+#include "simulator.h"
 
 static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_chA = NULL;
 static volatile int32_t *data_chB = NULL;
 
+/* @brief Counts last written to the buffer of each channel, an upload only writes the samples that differ. */
+static uint32_t loaded_cnts[2][BUFFER_LENGTH];
+static bool loaded_valid[2] = { false, false };
+
 
 int generate_Init() {
 //  ECHECK(cmn_Init());
     ECHECK(cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void **) &generate));
     data_chA = (int32_t *) ((char *) generate + (CHA_DATA_OFFSET));
     data_chB = (int32_t *) ((char *) generate + (CHB_DATA_OFFSET));
+    loaded_valid[0] = false;
+    loaded_valid[1] = false;
     return RP_OK;
 }
 
@@ -71,14 +78,21 @@ int generate_getOutputEnabled(rp_channel_t channel, bool *enabled) {
     return RP_OK;
 }
 
-int generate_setAmplitude(rp_channel_t channel, float amplitude) {
-    volatile ch_properties_t *ch_properties;
-
+uint32_t generate_cnvAmplitude(rp_channel_t channel, float amplitude) {
     rp_calib_params_t calib = calib_GetParams();
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
+    return cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
+}
+
+int generate_setAmplitude(rp_channel_t channel, float amplitude) {
+    return generate_setAmplitudeScale(channel, generate_cnvAmplitude(channel, amplitude));
+}
+
+int generate_setAmplitudeScale(rp_channel_t channel, uint32_t scale) {
+    volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
+    ch_properties->amplitudeScale = scale;
     return RP_OK;
 }
 
@@ -117,11 +131,32 @@ int generate_getDCOffset(rp_channel_t channel, float *offset) {
     return RP_OK;
 }
 
+uint32_t generate_cnvFrequency(float frequency) {
+    return generate_cnvFrequencySize(frequency, BUFFER_LENGTH);
+}
+
+uint32_t generate_cnvFrequencySize(double frequency, uint32_t size) {
+    return (uint32_t) round(65536 * frequency / DAC_FREQUENCY * size);
+}
+
 int generate_setFrequency(rp_channel_t channel, float frequency) {
+    return generate_setStep(channel, generate_cnvFrequency(frequency));
+}
+
+int generate_setStep(rp_channel_t channel, uint32_t step) {
+    ECHECK(generate_setCounterStep(channel, step));
+    channel == RP_CH_1 ? (generate->ASM_WrapPointer = 1) : (generate->BSM_WrapPointer = 1);
+    return RP_OK;
+}
+
+/**
+ * Changes only the pointer step. The pointer keeps running, so the signal
+ * changes frequency without a phase jump.
+ */
+int generate_setCounterStep(rp_channel_t channel, uint32_t step) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->counterStep = (uint32_t) round(65536 * frequency / DAC_FREQUENCY * BUFFER_LENGTH);
-    channel == RP_CH_1 ? (generate->ASM_WrapPointer = 1) : (generate->BSM_WrapPointer = 1);
+    ch_properties->counterStep = step;
     return RP_OK;
 }
 
@@ -132,6 +167,20 @@ int generate_getFrequency(rp_channel_t channel, float *frequency) {
     return RP_OK;
 }
 
+/**
+ * The phase is the start offset the read pointer is loaded with on a reset or
+ * a trigger. In wrap mode the pointer keeps that offset through every period,
+ * so a phase shift does not touch the buffer. Like the former rotation of the
+ * data, a positive phase delays the signal.
+ */
+int generate_setPhase(rp_channel_t channel, float phase, uint32_t size) {
+    volatile ch_properties_t *ch_properties;
+    ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
+    uint64_t wrap = 65536ULL * size;
+    ch_properties->startOffset = (uint32_t) ((uint64_t) round((360.0 - phase) / 360.0 * wrap) % wrap);
+    return RP_OK;
+}
+
 int generate_setWrapCounter(rp_channel_t channel, uint32_t size) {
     CHANNEL_ACTION(channel,
             generate->properties_chA.counterWrap = 65536 * size - 1,
@@ -139,10 +188,21 @@ int generate_setWrapCounter(rp_channel_t channel, uint32_t size) {
     return RP_OK;
 }
 
+int generate_getReadPointer(rp_channel_t channel, uint32_t *pos) {
+    CHANNEL_ACTION(channel,
+            *pos = generate->properties_chA.buffReadPointer,
+            *pos = generate->properties_chB.buffReadPointer)
+    return RP_OK;
+}
+
 int generate_setTriggerSource(rp_channel_t channel, unsigned short value) {
     CHANNEL_ACTION(channel,
             generate->AtriggerSelector = value,
             generate->BtriggerSelector = value)
+    // Selecting the internal source is a software trigger, which the simulator cannot see in the registers
+    if (value == 1 && cmn_GetBackend() == RP_BACKEND_SIM) {
+        ECHECK(sim_GenTrigger(channel == RP_CH_1 ? 0x1 : 0x2));
+    }
     return RP_OK;
 }
 
@@ -211,10 +271,13 @@ int generate_getBurstDelay(rp_channel_t channel, uint32_t *delay) {
 
 int generate_simultaneousTrigger() {
     // simultaneously trigger both channels
-    return cmn_SetBits((uint32_t *) generate, 0x00010001, 0xFFFFFFFF);
+    ECHECK(cmn_SetBits((uint32_t *) generate, 0x00010001, 0xFFFFFFFF));
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        ECHECK(sim_GenTrigger(0x3));
+    }
+    return RP_OK;
 }
 
-
 int generate_Synchronise() {
     // Both channels must be reset simultaneously
     ECHECK(cmn_SetBits((uint32_t *) generate, 0x00400040, 0xFFFFFFFF));
@@ -222,22 +285,67 @@ int generate_Synchronise() {
     return RP_OK;
 }
 
-int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length) {
+int generate_setReset(rp_channel_t channel, bool reset) {
+    CHANNEL_ACTION(channel,
+            generate->ASM_reset = reset ? 1 : 0,
+            generate->BSM_reset = reset ? 1 : 0)
+    return RP_OK;
+}
+
+int generate_writeData(rp_channel_t channel, const float *data, uint32_t start, uint32_t length) {
+    //rp_calib_params_t calib = calib_GetParams();
+    int dc_offs = 0;//channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
+
+    // Convert the whole period at once without calibration scaling, rotated so that it begins at 'start'
+    uint32_t cnts[BUFFER_LENGTH];
+    start %= BUFFER_LENGTH;
+    cmn_CnvVToCntBlock(DATA_BIT_LENGTH, data, cnts + start, BUFFER_LENGTH - start, AMPLITUDE_MAX, dc_offs);
+    cmn_CnvVToCntBlock(DATA_BIT_LENGTH, data + BUFFER_LENGTH - start, cnts, start, AMPLITUDE_MAX, dc_offs);
+    return generate_writeCounts(channel, cnts, length);
+}
+
+int generate_writeCounts(rp_channel_t channel, const uint32_t *cnts, uint32_t length) {
     volatile int32_t *dataOut;
     CHANNEL_ACTION(channel,
             dataOut = data_chA,
             dataOut = data_chB)
-
-    volatile ch_properties_t *properties;
-    ECHECK(getChannelPropertiesAddress(&properties, channel));
     generate_setWrapCounter(channel, length);
 
-    //rp_calib_params_t calib = calib_GetParams();
-    int dc_offs = 0;//channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
-    uint32_t amp_max = 0; //channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    // Writes to the uncached buffer dominate, so only the samples that changed since the last upload are written
+    int idx = channel == RP_CH_1 ? 0 : 1;
+    uint32_t *loaded = loaded_cnts[idx];
+    for(int i = 0; i < BUFFER_LENGTH; i++) {
+        if (!loaded_valid[idx] || cnts[i] != loaded[i]) {
+            dataOut[i] = cnts[i];
+            loaded[i] = cnts[i];
+        }
+    }
+    loaded_valid[idx] = true;
+    return RP_OK;
+}
 
-    for(int i = start; i < start+BUFFER_LENGTH; i++) {
-        dataOut[i % BUFFER_LENGTH] = cmn_CnvVToCnt(DATA_BIT_LENGTH, data[i-start], AMPLITUDE_MAX, false, amp_max, dc_offs, 0.0);
+/**
+ * Writes 'length' samples at buffer offset 'start' without touching the other
+ * samples or the wrap counter, as needed when the buffer is refilled while it
+ * is played. Every sample is written.
+ */
+int generate_writeBlock(rp_channel_t channel, const float *data, uint32_t start, uint32_t length) {
+    volatile int32_t *dataOut;
+    CHANNEL_ACTION(channel,
+            dataOut = data_chA,
+            dataOut = data_chB)
+
+    if (start + length > BUFFER_LENGTH) {
+        return RP_EOOR;
     }
+
+    uint32_t cnts[BUFFER_LENGTH];
+    cmn_CnvVToCntBlock(DATA_BIT_LENGTH, data, cnts, length, AMPLITUDE_MAX, 0);
+    for (uint32_t i = 0; i < length; i++) {
+        dataOut[start + i] = cnts[i];
+    }
+
+    // The next upload of a whole period cannot rely on the samples it wrote last
+    loaded_valid[channel == RP_CH_1 ? 0 : 1] = false;
     return RP_OK;
 }
@@ -88,12 +88,20 @@ int generate_Release();
 int generate_setOutputDisable(rp_channel_t channel, bool disable);
 int generate_getOutputEnabled(rp_channel_t channel, bool *disabled);
 int generate_setAmplitude(rp_channel_t channel, float amplitude);
+int generate_setAmplitudeScale(rp_channel_t channel, uint32_t scale);
+uint32_t generate_cnvAmplitude(rp_channel_t channel, float amplitude);
 int generate_getAmplitude(rp_channel_t channel, float *amplitude);
 int generate_setDCOffset(rp_channel_t channel, float offset);
 int generate_getDCOffset(rp_channel_t channel, float *offset);
 int generate_setFrequency(rp_channel_t channel, float frequency);
+int generate_setStep(rp_channel_t channel, uint32_t step);
+int generate_setCounterStep(rp_channel_t channel, uint32_t step);
+uint32_t generate_cnvFrequency(float frequency);
+uint32_t generate_cnvFrequencySize(double frequency, uint32_t size);
 int generate_getFrequency(rp_channel_t channel, float *frequency);
+int generate_setPhase(rp_channel_t channel, float phase, uint32_t size);
 int generate_setWrapCounter(rp_channel_t channel, uint32_t size);
+int generate_getReadPointer(rp_channel_t channel, uint32_t *pos);
 int generate_setTriggerSource(rp_channel_t channel, unsigned short value);
 int generate_getTriggerSource(rp_channel_t channel, uint32_t *value);
 int generate_setGatedBurst(rp_channel_t channel, uint32_t value);
@@ -107,7 +115,10 @@ int generate_getBurstDelay(rp_channel_t channel, uint32_t *delay);
 
 int generate_simultaneousTrigger();
 int generate_Synchronise();
+int generate_setReset(rp_channel_t channel, bool reset);
 
-int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length);
+int generate_writeData(rp_channel_t channel, const float *data, uint32_t start, uint32_t length);
+int generate_writeCounts(rp_channel_t channel, const uint32_t *cnts, uint32_t length);
+int generate_writeBlock(rp_channel_t channel, const float *data, uint32_t start, uint32_t length);
 
 #endif //__GENERATE_H
@@ -0,0 +1,18 @@
+/*
+ Single precision build of kiss_fft.c. The symbols are renamed so that it
+ links into the same library as the double precision build.
+*/
+
+#define kiss_fft_scalar             float
+#define kiss_fft_cpx                kiss_fftf_cpx
+#define kiss_fft_state              kiss_fftf_state
+#define kiss_fft_cfg                kiss_fftf_cfg
+#define kiss_fft_alloc              kiss_fftf_alloc
+#define kiss_fft_stride             kiss_fftf_stride
+#define kiss_fft                    kiss_fftf
+#define kiss_fft_cleanup            kiss_fftf_cleanup
+#define kiss_fft_next_fast_size     kiss_fftf_next_fast_size
+#define kf_work                     kf_work_f
+#define kf_factor                   kf_factor_f
+
+#include "kiss_fft.c"
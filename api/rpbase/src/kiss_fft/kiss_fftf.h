@@ -0,0 +1,30 @@
+#ifndef KISS_FFTF_H
+#define KISS_FFTF_H
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Single precision build of kiss_fft, see kiss_fftf.c. It links next to the
+ double precision kiss_fft and is used the same way.
+*/
+
+typedef struct {
+    float r;
+    float i;
+}kiss_fftf_cpx;
+
+typedef struct kiss_fftf_state* kiss_fftf_cfg;
+
+kiss_fftf_cfg kiss_fftf_alloc(int nfft,int inverse_fft,void * mem,size_t * lenmem);
+
+void kiss_fftf(kiss_fftf_cfg cfg,const kiss_fftf_cpx *fin,kiss_fftf_cpx *fout);
+
+#ifdef __cplusplus
+} 
+#endif
+
+#endif
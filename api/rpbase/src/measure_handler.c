@@ -0,0 +1,82 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library stimulus-response measurement implementation
+ *
+ * Both generator channels are set up for a burst that waits for a trigger,
+ * and the oscilloscope for a capture that starts on the generator trigger and
+ * holds as many samples as requested. Every repeat then arms the scope and
+ * triggers both channels with one register write; the scope triggers on the
+ * same clock as the burst starts, so the captures line up sample by sample
+ * and can be summed into the caller buffers without any alignment.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "generate.h"
+#include "gen_handler.h"
+#include "sweep_handler.h"
+#include "awg_stream_handler.h"
+#include "measure_handler.h"
+
+static int meas_Capture(const rp_measure_config_t* config, float* buffer1, float* buffer2)
+{
+    const uint64_t timeout_ns = (uint64_t) config->timeout_us * 1000;
+
+    for (uint32_t i = 0; i < config->repeats; ++i) {
+        ECHECK(acq_Start());
+        ECHECK(osc_SetTriggerSource(RP_TRIG_SRC_AWG_PE));
+        ECHECK(generate_simultaneousTrigger());
+        ECHECK(acq_WaitCaptured(timeout_ns));
+
+        uint32_t pos, size = config->size;
+        ECHECK(acq_GetWritePointerAtTrig(&pos));
+        if (i == 0 && !config->accumulate) {
+            ECHECK(acq_GetDataV2(pos, &size, buffer1, buffer2));
+        }
+        else {
+            ECHECK(acq_AddDataV2(pos, &size, buffer1, buffer2));
+        }
+    }
+    return RP_OK;
+}
+
+int meas_Response(const rp_measure_config_t* config, float* buffer1, float* buffer2)
+{
+    if (config->size == 0 || config->size > ADC_BUFFER_SIZE || config->repeats == 0) {
+        return RP_EOOR;
+    }
+    // Both channels are reprogrammed, which would break a running sweep or stream
+    if (sweep_IsRunning() || awg_StreamIsRunning()) {
+        return RP_EUF;
+    }
+
+    // The generator and the capture are set up for the measurement; the settings of the user are brought back afterwards
+    gen_burst_state_t gen_state;
+    uint32_t trig_delay;
+    ECHECK(gen_getBurstState(&gen_state));
+    ECHECK(osc_GetTriggerDelay(&trig_delay));
+
+    int ret = gen_setBursts(config->burst_count);
+    if (ret == RP_OK) {
+        // The capture ends 'size' samples after the trigger
+        ret = osc_SetTriggerDelay(config->size);
+    }
+    if (ret == RP_OK) {
+        ret = meas_Capture(config, buffer1, buffer2);
+    }
+
+    osc_SetTriggerSource(RP_TRIG_SRC_DISABLED);
+    osc_SetTriggerDelay(trig_delay);
+    gen_setBurstState(&gen_state);
+    return ret;
+}
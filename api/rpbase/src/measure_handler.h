@@ -0,0 +1,24 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library stimulus-response measurement interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_MEASURE_HANDLER_H_
+#define SRC_MEASURE_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+int meas_Response(const rp_measure_config_t* config, float* buffer1, float* buffer2);
+
+#endif /* SRC_MEASURE_HANDLER_H_ */
@@ -24,6 +24,42 @@ static volatile uint32_t *osc_cha = NULL;
 // The FPGA input signal buffer pointer for channel B
 static volatile uint32_t *osc_chb = NULL;
 
+// Copy of the configuration registers, which only the CPU writes. The copy is per
+// process, osc_LoadShadow() picks up changes made by other processes.
+static osc_control_t osc_shadow;
+
+// Serializes shadow updates, so setters of fields in the same register do not lose writes
+static pthread_mutex_t osc_shadow_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Trigger interrupt line, -1 if the FPGA does not provide it
+static int trig_irq_fd = -1;
+
+/**
+ * Writes a configuration register through its shadow copy. The register is never
+ * read back and the bus write is skipped when the value does not change.
+ */
+static int osc_SetShadowValue(volatile uint32_t* field, uint32_t* shadow, uint32_t value, uint32_t mask)
+{
+    VALIDATE_BITS(value, mask);
+    pthread_mutex_lock(&osc_shadow_mutex);
+    uint32_t currentValue = (*shadow & ~mask) | value;
+    if (currentValue != *shadow) {
+        SET_VALUE(*field, currentValue);
+        *shadow = currentValue;
+    }
+    pthread_mutex_unlock(&osc_shadow_mutex);
+    return RP_OK;
+}
+
+static int osc_GetShadowValue(const uint32_t* shadow, uint32_t* value, uint32_t mask)
+{
+    *value = *shadow & mask;
+    return RP_OK;
+}
+
+#define SET_SHADOW(field, value, mask) osc_SetShadowValue(&osc_reg->field, &osc_shadow.field, value, mask)
+#define GET_SHADOW(field, value, mask) osc_GetShadowValue(&osc_shadow.field, value, mask)
+
 
 /**
  * general
@@ -35,11 +71,16 @@ int osc_Init()
     ECHECK(cmn_Map(OSC_BASE_SIZE, OSC_BASE_ADDR, (void**)&osc_reg));
     osc_cha = (uint32_t*)((char*)osc_reg + OSC_CHA_OFFSET);
     osc_chb = (uint32_t*)((char*)osc_reg + OSC_CHB_OFFSET);
-    return RP_OK;
+    // Trigger interrupt is optional, without it triggers are polled
+    if (cmn_IrqOpen(OSC_TRIG_IRQ_NAME, &trig_irq_fd) != RP_OK) {
+        trig_irq_fd = -1;
+    }
+    return osc_LoadShadow();
 }
 
 int osc_Release()
 {
+    cmn_IrqClose(&trig_irq_fd);
     ECHECK(cmn_Unmap(OSC_BASE_SIZE, (void**)&osc_reg));
     osc_cha = NULL;
     osc_chb = NULL;
@@ -48,33 +89,54 @@ int osc_Release()
 }
 
 
+/**
+ * Reads all configuration registers into the shadow copy, e.g. after another
+ * process might have changed them.
+ */
+int osc_LoadShadow()
+{
+    pthread_mutex_lock(&osc_shadow_mutex);
+    osc_shadow.data_dec = osc_reg->data_dec;
+    osc_shadow.other = osc_reg->other;
+    osc_shadow.trigger_delay = osc_reg->trigger_delay;
+    osc_shadow.cha_thr = osc_reg->cha_thr;
+    osc_shadow.chb_thr = osc_reg->chb_thr;
+    osc_shadow.cha_hystersis = osc_reg->cha_hystersis;
+    osc_shadow.chb_hystersis = osc_reg->chb_hystersis;
+    osc_shadow.cha_filt_aa = osc_reg->cha_filt_aa;
+    osc_shadow.cha_filt_bb = osc_reg->cha_filt_bb;
+    osc_shadow.cha_filt_kk = osc_reg->cha_filt_kk;
+    osc_shadow.cha_filt_pp = osc_reg->cha_filt_pp;
+    osc_shadow.chb_filt_aa = osc_reg->chb_filt_aa;
+    osc_shadow.chb_filt_bb = osc_reg->chb_filt_bb;
+    osc_shadow.chb_filt_kk = osc_reg->chb_filt_kk;
+    osc_shadow.chb_filt_pp = osc_reg->chb_filt_pp;
+    pthread_mutex_unlock(&osc_shadow_mutex);
+    return RP_OK;
+}
+
 /**
  * decimation
  */
 
 int osc_SetDecimation(uint32_t decimation)
 {
-    return cmn_SetValue(&osc_reg->data_dec, decimation, DATA_DEC_MASK);
+    return SET_SHADOW(data_dec, decimation, DATA_DEC_MASK);
 }
 
 int osc_GetDecimation(uint32_t* decimation)
 {
-    return cmn_GetValue(&osc_reg->data_dec, decimation, DATA_DEC_MASK);
+    return GET_SHADOW(data_dec, decimation, DATA_DEC_MASK);
 }
 
 int osc_SetAveraging(bool enable)
 {
-    if (enable) {
-        return cmn_SetBits(&osc_reg->other, 0x1, DATA_AVG_MASK);
-    }
-    else {
-        return cmn_UnsetBits(&osc_reg->other, 0x1, DATA_AVG_MASK);
-    }
+    return SET_SHADOW(other, enable ? 0x1 : 0x0, DATA_AVG_MASK);
 }
 
 int osc_GetAveraging(bool* enable)
 {
-    return cmn_AreBitsSet(osc_reg->other, 0x1, DATA_AVG_MASK, enable);
+    return cmn_AreBitsSet(osc_shadow.other, 0x1, DATA_AVG_MASK, enable);
 }
 
 /**
@@ -106,6 +168,20 @@ int osc_ResetWriteStateMachine()
     return cmn_SetBits(&osc_reg->conf, (0x1 << 1), RST_WR_ST_MCH_MASK);
 }
 
+/**
+ * The FPGA always reads the reset bit as 0, the simulated backend until the
+ * model has applied the reset.
+ */
+int osc_IsResetPending(bool *pending)
+{
+    return cmn_AreBitsSet(osc_reg->conf, (0x1 << 1), RST_WR_ST_MCH_MASK, pending);
+}
+
+int osc_IsWritingDataIntoMemory(bool *enabled)
+{
+    return cmn_AreBitsSet(osc_reg->conf, 0x1, START_DATA_WRITE_MASK, enabled);
+}
+
 int osc_SetArmKeep(bool enable)
 {
     if (enable)
@@ -119,6 +195,27 @@ int osc_GetTriggerState(bool *received)
     return cmn_AreBitsSet(osc_reg->conf, (0x1 << 2), TRIG_ST_MCH_MASK, received);
 }
 
+bool osc_HasTriggerIrq()
+{
+    return trig_irq_fd != -1;
+}
+
+int osc_EnableTriggerIrq()
+{
+    if (trig_irq_fd == -1) {
+        return RP_EOOR;
+    }
+    return cmn_IrqEnable(trig_irq_fd);
+}
+
+int osc_WaitTriggerIrq(uint64_t timeout_ns)
+{
+    if (trig_irq_fd == -1) {
+        return RP_EOOR;
+    }
+    return cmn_IrqWait(trig_irq_fd, timeout_ns);
+}
+
 int osc_GetPreTriggerCounter(uint32_t *value)
 {
     return cmn_GetValue(&osc_reg->pre_trigger_counter, value, PRE_TRIGGER_COUNTER);
@@ -130,12 +227,12 @@ int osc_GetPreTriggerCounter(uint32_t *value)
 
 int osc_SetTriggerDelay(uint32_t decimated_data_num)
 {
-    return cmn_SetValue(&osc_reg->trigger_delay, decimated_data_num, TRIG_DELAY_MASK);
+    return SET_SHADOW(trigger_delay, decimated_data_num, TRIG_DELAY_MASK);
 }
 
 int osc_GetTriggerDelay(uint32_t* decimated_data_num)
 {
-    return cmn_GetValue(&osc_reg->trigger_delay, decimated_data_num, TRIG_DELAY_MASK);
+    return GET_SHADOW(trigger_delay, decimated_data_num, TRIG_DELAY_MASK);
 }
 
 /**
@@ -144,22 +241,22 @@ int osc_GetTriggerDelay(uint32_t* decimated_data_num)
 
 int osc_SetThresholdChA(uint32_t threshold)
 {
-    return cmn_SetValue(&osc_reg->cha_thr, threshold, THRESHOLD_MASK);
+    return SET_SHADOW(cha_thr, threshold, THRESHOLD_MASK);
 }
 
 int osc_GetThresholdChA(uint32_t* threshold)
 {
-    return cmn_GetValue(&osc_reg->cha_thr, threshold, THRESHOLD_MASK);
+    return GET_SHADOW(cha_thr, threshold, THRESHOLD_MASK);
 }
 
 int osc_SetThresholdChB(uint32_t threshold)
 {
-    return cmn_SetValue(&osc_reg->chb_thr, threshold, THRESHOLD_MASK);
+    return SET_SHADOW(chb_thr, threshold, THRESHOLD_MASK);
 }
 
 int osc_GetThresholdChB(uint32_t* threshold)
 {
-    return cmn_GetValue(&osc_reg->chb_thr, threshold, THRESHOLD_MASK);
+    return GET_SHADOW(chb_thr, threshold, THRESHOLD_MASK);
 }
 
 /**
@@ -167,22 +264,22 @@ int osc_GetThresholdChB(uint32_t* threshold)
  */
 int osc_SetHysteresisChA(uint32_t hysteresis)
 {
-    return cmn_SetValue(&osc_reg->cha_hystersis, hysteresis, HYSTERESIS_MASK);
+    return SET_SHADOW(cha_hystersis, hysteresis, HYSTERESIS_MASK);
 }
 
 int osc_GetHysteresisChA(uint32_t* hysteresis)
 {
-    return cmn_GetValue(&osc_reg->cha_hystersis, hysteresis, HYSTERESIS_MASK);
+    return GET_SHADOW(cha_hystersis, hysteresis, HYSTERESIS_MASK);
 }
 
 int osc_SetHysteresisChB(uint32_t hysteresis)
 {
-    return cmn_SetValue(&osc_reg->chb_hystersis, hysteresis, HYSTERESIS_MASK);
+    return SET_SHADOW(chb_hystersis, hysteresis, HYSTERESIS_MASK);
 }
 
 int osc_GetHysteresisChB(uint32_t* hysteresis)
 {
-    return cmn_GetValue(&osc_reg->chb_hystersis, hysteresis, HYSTERESIS_MASK);
+    return GET_SHADOW(chb_hystersis, hysteresis, HYSTERESIS_MASK);
 }
 
 /**
@@ -190,37 +287,37 @@ int osc_GetHysteresisChB(uint32_t* hysteresis)
  */
 int osc_SetEqFiltersChA(uint32_t coef_aa, uint32_t coef_bb, uint32_t coef_kk, uint32_t coef_pp)
 {
-    ECHECK(cmn_SetValue(&osc_reg->cha_filt_aa, coef_aa, EQ_FILTER_AA));
-    ECHECK(cmn_SetValue(&osc_reg->cha_filt_bb, coef_bb, EQ_FILTER));
-    ECHECK(cmn_SetValue(&osc_reg->cha_filt_kk, coef_kk, EQ_FILTER));
-    ECHECK(cmn_SetValue(&osc_reg->cha_filt_pp, coef_pp, EQ_FILTER));
+    ECHECK(SET_SHADOW(cha_filt_aa, coef_aa, EQ_FILTER_AA));
+    ECHECK(SET_SHADOW(cha_filt_bb, coef_bb, EQ_FILTER));
+    ECHECK(SET_SHADOW(cha_filt_kk, coef_kk, EQ_FILTER));
+    ECHECK(SET_SHADOW(cha_filt_pp, coef_pp, EQ_FILTER));
     return RP_OK;
 }
 
 int osc_GetEqFiltersChA(uint32_t* coef_aa, uint32_t* coef_bb, uint32_t* coef_kk, uint32_t* coef_pp)
 {
-    ECHECK(cmn_GetValue(&osc_reg->cha_filt_aa, coef_aa, EQ_FILTER_AA));
-    ECHECK(cmn_GetValue(&osc_reg->cha_filt_bb, coef_bb, EQ_FILTER));
-    ECHECK(cmn_GetValue(&osc_reg->cha_filt_kk, coef_kk, EQ_FILTER));
-    ECHECK(cmn_GetValue(&osc_reg->cha_filt_pp, coef_pp, EQ_FILTER));
+    ECHECK(GET_SHADOW(cha_filt_aa, coef_aa, EQ_FILTER_AA));
+    ECHECK(GET_SHADOW(cha_filt_bb, coef_bb, EQ_FILTER));
+    ECHECK(GET_SHADOW(cha_filt_kk, coef_kk, EQ_FILTER));
+    ECHECK(GET_SHADOW(cha_filt_pp, coef_pp, EQ_FILTER));
     return RP_OK;
 }
 
 int osc_SetEqFiltersChB(uint32_t coef_aa, uint32_t coef_bb, uint32_t coef_kk, uint32_t coef_pp)
 {
-    ECHECK(cmn_SetValue(&osc_reg->chb_filt_aa, coef_aa, EQ_FILTER_AA));
-    ECHECK(cmn_SetValue(&osc_reg->chb_filt_bb, coef_bb, EQ_FILTER));
-    ECHECK(cmn_SetValue(&osc_reg->chb_filt_kk, coef_kk, EQ_FILTER));
-    ECHECK(cmn_SetValue(&osc_reg->chb_filt_pp, coef_pp, EQ_FILTER));
+    ECHECK(SET_SHADOW(chb_filt_aa, coef_aa, EQ_FILTER_AA));
+    ECHECK(SET_SHADOW(chb_filt_bb, coef_bb, EQ_FILTER));
+    ECHECK(SET_SHADOW(chb_filt_kk, coef_kk, EQ_FILTER));
+    ECHECK(SET_SHADOW(chb_filt_pp, coef_pp, EQ_FILTER));
     return RP_OK;
 }
 
 int osc_GetEqFiltersChB(uint32_t* coef_aa, uint32_t* coef_bb, uint32_t* coef_kk, uint32_t* coef_pp)
 {
-    ECHECK(cmn_GetValue(&osc_reg->chb_filt_aa, coef_aa, EQ_FILTER_AA));
-    ECHECK(cmn_GetValue(&osc_reg->chb_filt_bb, coef_bb, EQ_FILTER));
-    ECHECK(cmn_GetValue(&osc_reg->chb_filt_kk, coef_kk, EQ_FILTER));
-    ECHECK(cmn_GetValue(&osc_reg->chb_filt_pp, coef_pp, EQ_FILTER));
+    ECHECK(GET_SHADOW(chb_filt_aa, coef_aa, EQ_FILTER_AA));
+    ECHECK(GET_SHADOW(chb_filt_bb, coef_bb, EQ_FILTER));
+    ECHECK(GET_SHADOW(chb_filt_kk, coef_kk, EQ_FILTER));
+    ECHECK(GET_SHADOW(chb_filt_pp, coef_pp, EQ_FILTER));
     return RP_OK;
 }
 
@@ -237,6 +334,63 @@ int osc_GetWritePointerAtTrig(uint32_t* pos)
     return cmn_GetValue(&osc_reg->wr_ptr_trigger, pos, WRITE_POINTER_MASK);
 }
 
+/**
+ * AXI DDR recorders
+ */
+int osc_SetAxiBufferChA(uint32_t start, uint32_t stop)
+{
+    ECHECK(cmn_SetValue(&osc_reg->cha_axi_low, start, AXI_ADDR_MASK));
+    ECHECK(cmn_SetValue(&osc_reg->cha_axi_high, stop, AXI_ADDR_MASK));
+    return RP_OK;
+}
+
+int osc_SetAxiTriggerDelayChA(uint32_t decimated_data_num)
+{
+    return cmn_SetValue(&osc_reg->cha_trig_delay, decimated_data_num, AXI_DELAY_MASK);
+}
+
+int osc_SetAxiEnableChA(bool enable)
+{
+    return cmn_SetValue(&osc_reg->cha_enable_axi_m, enable ? 0x1 : 0x0, AXI_ENABLE_MASK);
+}
+
+int osc_GetAxiWritePointerChA(uint32_t* address)
+{
+    return cmn_GetValue(&osc_reg->cha_w_ptr_curr, address, AXI_ADDR_MASK);
+}
+
+int osc_GetAxiWritePointerAtTrigChA(uint32_t* address)
+{
+    return cmn_GetValue(&osc_reg->cha_w_ptr_trig, address, AXI_ADDR_MASK);
+}
+
+int osc_SetAxiBufferChB(uint32_t start, uint32_t stop)
+{
+    ECHECK(cmn_SetValue(&osc_reg->chb_axi_low, start, AXI_ADDR_MASK));
+    ECHECK(cmn_SetValue(&osc_reg->chb_axi_high, stop, AXI_ADDR_MASK));
+    return RP_OK;
+}
+
+int osc_SetAxiTriggerDelayChB(uint32_t decimated_data_num)
+{
+    return cmn_SetValue(&osc_reg->chb_trig_delay, decimated_data_num, AXI_DELAY_MASK);
+}
+
+int osc_SetAxiEnableChB(bool enable)
+{
+    return cmn_SetValue(&osc_reg->chb_enable_axi_m, enable ? 0x1 : 0x0, AXI_ENABLE_MASK);
+}
+
+int osc_GetAxiWritePointerChB(uint32_t* address)
+{
+    return cmn_GetValue(&osc_reg->chb_w_ptr_curr, address, AXI_ADDR_MASK);
+}
+
+int osc_GetAxiWritePointerAtTrigChB(uint32_t* address)
+{
+    return cmn_GetValue(&osc_reg->chb_w_ptr_trig, address, AXI_ADDR_MASK);
+}
+
 /**
  * Raw buffers
  */
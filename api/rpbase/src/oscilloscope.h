@@ -23,6 +23,9 @@
 static const int OSC_BASE_ADDR = 0x40100000;
 static const int OSC_BASE_SIZE = 0x30000;
 
+// Name of the UIO device signalling the oscilloscope trigger
+#define OSC_TRIG_IRQ_NAME "rp-osc-trigger"
+
 // Oscilloscope Channel A input signal buffer offset
 #define OSC_CHA_OFFSET 0x10000
 
@@ -278,10 +281,14 @@ static const uint32_t RST_WR_ST_MCH_MASK    = 0x2;          // (1st bit)
 static const uint32_t TRIG_ST_MCH_MASK      = 0x4;          // (2st bit)
 static const uint32_t PRE_TRIGGER_COUNTER   = 0xFFFFFFFF;   // (32 bit)
 static const uint32_t ARM_KEEP_MASK         = 0xF;          // (4 bit)
+static const uint32_t AXI_ADDR_MASK         = 0xFFFFFFFF;   // (32 bit)
+static const uint32_t AXI_DELAY_MASK        = 0xFFFFFFFF;   // (32 bit)
+static const uint32_t AXI_ENABLE_MASK       = 0x1;          // (1 bit)
 
 
 int osc_Init();
 int osc_Release();
+int osc_LoadShadow();
 
 int osc_SetDecimation(uint32_t decimation);
 int osc_GetDecimation(uint32_t* decimation);
@@ -290,9 +297,14 @@ int osc_GetAveraging(bool* enable);
 int osc_SetTriggerSource(uint32_t source);
 int osc_GetTriggerSource(uint32_t* source);
 int osc_WriteDataIntoMemory(bool enable);
+int osc_IsWritingDataIntoMemory(bool *enabled);
 int osc_ResetWriteStateMachine();
+int osc_IsResetPending(bool *pending);
 int osc_SetArmKeep(bool enable);
 int osc_GetTriggerState(bool *received);
+bool osc_HasTriggerIrq();
+int osc_EnableTriggerIrq();
+int osc_WaitTriggerIrq(uint64_t timeout_ns);
 int osc_GetPreTriggerCounter(uint32_t *value);
 int osc_SetThresholdChA(uint32_t threshold);
 int osc_GetThresholdChA(uint32_t* threshold);
@@ -311,6 +323,17 @@ int osc_GetEqFiltersChA(uint32_t* coef_aa, uint32_t* coef_bb, uint32_t* coef_kk,
 int osc_SetEqFiltersChB(uint32_t coef_aa, uint32_t coef_bb, uint32_t coef_kk, uint32_t coef_pp);
 int osc_GetEqFiltersChB(uint32_t* coef_aa, uint32_t* coef_bb, uint32_t* coef_kk, uint32_t* coef_pp);
 
+int osc_SetAxiBufferChA(uint32_t start, uint32_t stop);
+int osc_SetAxiTriggerDelayChA(uint32_t decimated_data_num);
+int osc_SetAxiEnableChA(bool enable);
+int osc_GetAxiWritePointerChA(uint32_t* address);
+int osc_GetAxiWritePointerAtTrigChA(uint32_t* address);
+int osc_SetAxiBufferChB(uint32_t start, uint32_t stop);
+int osc_SetAxiTriggerDelayChB(uint32_t decimated_data_num);
+int osc_SetAxiEnableChB(bool enable);
+int osc_GetAxiWritePointerChB(uint32_t* address);
+int osc_GetAxiWritePointerAtTrigChB(uint32_t* address);
+
 const volatile uint32_t* osc_GetDataBufferChA();
 const volatile uint32_t* osc_GetDataBufferChB();
 
@@ -18,12 +18,21 @@
 #include "version.h"
 #include "common.h"
 #include "housekeeping.h"
+#include "dpin_handler.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
 #include "analog_mixed_signals.h"
+#include "ams_handler.h"
 #include "calib.h"
 #include "generate.h"
 #include "gen_handler.h"
+#include "simulator.h"
+#include "stream_handler.h"
+#include "segment_handler.h"
+#include "sweep_handler.h"
+#include "awg_stream_handler.h"
+#include "measure_handler.h"
+#include "fft_handler.h"
 
 static char version[50];
 
@@ -37,6 +46,7 @@ int rp_Init()
 	
     ECHECK(calib_Init());
     ECHECK(hk_Init());
+    ECHECK(dpin_Init());
     ECHECK(ams_Init());
     ECHECK(generate_Init());
     ECHECK(osc_Init());
@@ -48,6 +58,12 @@ int rp_Init()
     return RP_OK;
 }
 
+int rp_InitBackend(rp_backend_t backend)
+{
+    ECHECK(cmn_SetBackend(backend));
+    return rp_Init();
+}
+
 int rp_CalibInit()
 {
     ECHECK(calib_Init());
@@ -57,9 +73,18 @@ int rp_CalibInit()
 
 int rp_Release()
 {
+    if (stream_IsRunning()) {
+        ECHECK(stream_Stop());
+    }
+    ECHECK(sweep_Stop());
+    ECHECK(awg_StreamStop());
     ECHECK(osc_Release())
+    ECHECK(gen_Release());
     ECHECK(generate_Release());
+    ECHECK(ams_SamplerStop());
     ECHECK(ams_Release());
+    ECHECK(dpin_SequenceStop());
+    ECHECK(dpin_Release());
     ECHECK(hk_Release());
     ECHECK(calib_Release());
     ECHECK(cmn_Release());
@@ -131,11 +156,40 @@ const char* rp_GetError(int errorCode) {
             return "Failed to read from the bus";
         case RP_EFWB:
             return "Failed to write to the bus";
+        case RP_ETIM:
+            return "Timeout expired";
         default:
             return "Unknown error";
     }
 }
 
+/**
+ * Simulation methods
+ */
+
+int rp_SimSetSignalSource(rp_sim_source_t source, void *ctx)
+{
+    return sim_SetSignalSource(source, ctx);
+}
+
+int rp_SimSetOutputSink(rp_sim_sink_t sink, void *ctx)
+{
+    return sim_SetOutputSink(sink, ctx);
+}
+
+int rp_SimSetTriggerIrq(bool enable)
+{
+    return sim_SetTriggerIrq(enable);
+}
+
+int rp_SimStep(uint32_t samples)
+{
+    if (cmn_GetBackend() != RP_BACKEND_SIM) {
+        return RP_EUF;
+    }
+    return sim_Step(samples);
+}
+
 /**
  * Calibrate methods
  */
@@ -259,6 +313,7 @@ int rp_GPIOpGetState(uint32_t *state) {
  */
 
 int rp_DpinReset() {
+    ECHECK(dpin_SequenceStop());
     iowrite32(0, &hk->ex_cd_p);
     iowrite32(0, &hk->ex_cd_n);
     iowrite32(0, &hk->ex_co_p);
@@ -344,6 +399,39 @@ int rp_DpinGetState(rp_dpin_t pin, rp_pinState_t* state) {
     return RP_OK;
 }
 
+int rp_DpinSetStateMask(uint32_t mask, uint32_t state) {
+    return dpin_SetStateMask(mask, state);
+}
+
+int rp_DpinGetStateAll(uint32_t* state) {
+    return dpin_GetStateAll(state);
+}
+
+int rp_DpinSetDirectionMask(uint32_t mask, uint32_t direction) {
+    return dpin_SetDirectionMask(mask, direction);
+}
+
+int rp_DpinGetDirectionAll(uint32_t* direction) {
+    return dpin_GetDirectionAll(direction);
+}
+
+int rp_DpinSequenceStart(const rp_dpin_transition_t* transitions, uint32_t count) {
+    return dpin_SequenceStart(transitions, count);
+}
+
+int rp_DpinSequenceIsRunning(bool* running) {
+    *running = dpin_SequenceIsRunning();
+    return RP_OK;
+}
+
+int rp_DpinSequenceGetLateness(uint64_t* max_late_ns) {
+    return dpin_SequenceGetLateness(max_late_ns);
+}
+
+int rp_DpinSequenceStop() {
+    return dpin_SequenceStop();
+}
+
 
 /**
  * Digital loop
@@ -420,6 +508,22 @@ int rp_ApinGetRange(rp_apin_t pin, float* min_val, float* max_val) {
     return RP_OK;
 }
 
+int rp_ApinSamplerStart(uint32_t period_us, uint32_t window) {
+    return ams_SamplerStart(period_us, window);
+}
+
+int rp_ApinSamplerStop() {
+    return ams_SamplerStop();
+}
+
+int rp_ApinResetMinMax() {
+    return ams_ResetMinMax();
+}
+
+int rp_ApinGetAll(rp_ams_snapshot_t* snapshot) {
+    return ams_GetAll(snapshot);
+}
+
 
 /**
  * Analog Inputs
@@ -561,6 +665,11 @@ int rp_AcqGetTriggerState(rp_acq_trig_state_t* state)
     return acq_GetTriggerState(state);
 }
 
+int rp_AcqWaitTrigger(uint64_t timeout_ns, uint64_t* latency_ns)
+{
+    return acq_WaitTrigger(timeout_ns, latency_ns);
+}
+
 int rp_AcqSetTriggerDelay(int32_t decimated_data_num)
 {
     return acq_SetTriggerDelay(decimated_data_num, false);
@@ -669,6 +778,31 @@ int rp_AcqGetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t*
     return acq_GetDataRawV2(pos, size, buffer, buffer2);
 }
 
+int rp_AcqGetConfig(rp_acq_config_t* config)
+{
+    return acq_GetConfig(config);
+}
+
+int rp_AcqConfigure(const rp_acq_config_t* config)
+{
+    return acq_Configure(config);
+}
+
+int rp_AcqSyncShadow()
+{
+    return acq_SyncShadow();
+}
+
+int rp_AcqGetRawView(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_view_t* view)
+{
+    return acq_GetRawView(channel, pos, size, view);
+}
+
+int rp_AcqIsRawViewValid(const rp_acq_view_t* view, bool* valid)
+{
+    return acq_IsRawViewValid(view, valid);
+}
+
 int rp_AcqGetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
     return acq_GetOldestDataRaw(channel, size, buffer);
@@ -689,6 +823,11 @@ int rp_AcqGetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2
     return acq_GetDataV2(pos, size, buffer1, buffer2);
 }
 
+int rp_AcqGetDataV2Scratch(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2, void* scratch, uint32_t scratch_size)
+{
+    return acq_GetDataV2Scratch(pos, size, buffer1, buffer2, scratch, scratch_size);
+}
+
 int rp_AcqGetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 {
     return acq_GetOldestDataV(channel, size, buffer);
@@ -703,6 +842,36 @@ int rp_AcqGetBufSize(uint32_t *size) {
     return acq_GetBufferSize(size);
 }
 
+int rp_AcqCaptureSegments(const rp_acq_seg_config_t* config, uint64_t timeout_ns, int16_t* buffer1, int16_t* buffer2,
+                          rp_acq_segment_t* segments, uint32_t* count)
+{
+    return seg_Capture(config, timeout_ns, buffer1, buffer2, segments, count);
+}
+
+/**
+ * Streaming methods
+ */
+
+int rp_StreamStart(const rp_stream_config_t* config)
+{
+    return stream_Start(config);
+}
+
+int rp_StreamRead(rp_stream_block_t* block, int16_t* buffer1, int16_t* buffer2, uint32_t timeout_us)
+{
+    return stream_Read(block, buffer1, buffer2, timeout_us);
+}
+
+int rp_StreamGetStats(rp_stream_stats_t* stats)
+{
+    return stream_GetStats(stats);
+}
+
+int rp_StreamStop()
+{
+    return stream_Stop();
+}
+
 /**
 * Generate methods
 */
@@ -747,6 +916,10 @@ int rp_GenGetFreq(rp_channel_t channel, float *frequency) {
     return gen_getFrequency(channel, frequency);
 }
 
+int rp_GenDdsFreq(rp_channel_t channel, double frequency, double accuracy, double *actual) {
+    return gen_setDdsFrequency(channel, frequency, accuracy, actual);
+}
+
 int rp_GenPhase(rp_channel_t channel, float phase) {
     return gen_setPhase(channel, phase);
 }
@@ -767,6 +940,10 @@ int rp_GenArbWaveform(rp_channel_t channel, float *waveform, uint32_t length) {
     return gen_setArbWaveform(channel, waveform, length);
 }
 
+int rp_GenArbWaveformMove(rp_channel_t channel, float *waveform, uint32_t length) {
+    return gen_moveArbWaveform(channel, waveform, length);
+}
+
 int rp_GenGetArbWaveform(rp_channel_t channel, float *waveform, uint32_t *length) {
     return gen_getArbWaveform(channel, waveform, length);
 }
@@ -823,6 +1000,75 @@ int rp_GenTrigger(uint32_t channel) {
     return gen_Trigger(channel);
 }
 
+int rp_GenSweepStart(const rp_gen_sweep_config_t* config, rp_gen_sweep_callback_t callback, void* ctx) {
+    return sweep_Start(config, callback, ctx);
+}
+
+int rp_GenSweepGetEventFd(int* fd) {
+    return sweep_GetEventFd(fd);
+}
+
+int rp_GenSweepIsRunning(bool* running) {
+    *running = sweep_IsRunning();
+    return RP_OK;
+}
+
+int rp_GenSweepStop() {
+    return sweep_Stop();
+}
+
+int rp_GenStreamStart(const rp_gen_stream_config_t* config) {
+    return awg_StreamStart(config);
+}
+
+int rp_GenStreamWrite(const float* data, uint32_t* size, uint32_t timeout_us) {
+    return awg_StreamWrite(data, size, timeout_us);
+}
+
+int rp_GenStreamGetStats(rp_gen_stream_stats_t* stats) {
+    return awg_StreamGetStats(stats);
+}
+
+int rp_GenStreamStop() {
+    return awg_StreamStop();
+}
+
+int rp_MeasureResponse(const rp_measure_config_t* config, float* buffer1, float* buffer2) {
+    return meas_Response(config, buffer1, buffer2);
+}
+
+int rp_FftSetBackend(rp_fft_backend_t backend) {
+    return fft_SetBackend(backend);
+}
+
+int rp_FftGetBackend(rp_fft_backend_t* backend) {
+    return fft_GetBackend(backend);
+}
+
+int rp_FftPlanGet(uint32_t size, rp_fft_type_t type, rp_fft_plan_t** plan) {
+    return fft_PlanGet(size, type, plan);
+}
+
+int rp_FftExecute(const rp_fft_plan_t* plan, const void* in, rp_fft_cpx_t* out) {
+    return fft_Execute(plan, in, out);
+}
+
+int rp_FftAvgAdd(rp_fft_avg_t* avg, float* acc, const float* frame, uint32_t bins) {
+    return fft_AvgAdd(avg, acc, frame, bins);
+}
+
+int rp_FftWelch(const float* in, uint32_t in_len, uint32_t seg_len, uint32_t overlap, float* power) {
+    return fft_Welch(in, in_len, seg_len, overlap, power);
+}
+
+int rp_FftZoom(const float* in, uint32_t in_len, float center, uint32_t decimation, uint32_t fft_len, float* power) {
+    return fft_Zoom(in, in_len, center, decimation, fft_len, power);
+}
+
+int rp_FftCleanup() {
+    return fft_Cleanup();
+}
+
 float rp_CmnCnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off)
 {
 	return cmn_CnvCntToV(field_len, cnts, adc_max_v, calibScale, calib_dc_off, user_dc_off);
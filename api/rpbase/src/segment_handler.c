@@ -0,0 +1,378 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library segmented acquisition handler implementation
+ *
+ * The oscilloscope keeps writing its buffers (arm keep) while the trigger
+ * source is re-armed right after every trigger, so closely spaced events are
+ * captured without a reset and pre-trigger fill in between. Segments are
+ * copied out of the ADC buffers or the DDR buffers of the AXI recorders in
+ * short chunks as their samples arrive, and the trigger is checked between
+ * the chunks. Sample indexes are counted from the write pointer, which gives
+ * every trigger a timestamp in sample clock resolution.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <sched.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "stream_handler.h"
+#include "segment_handler.h"
+
+/* @brief Samples per channel copied between two trigger checks. */
+#define SEG_COPY_CHUNK          1024
+
+/* @brief Sampling period (non-decimated) - 8 [ns]. */
+#define SEG_SAMPLE_PERIOD_NS    8
+
+/* @brief Bytes in one word written by the AXI recorders. */
+#define SEG_DDR_WORD            8
+
+/* @brief Limits of calibrated 14 bit counts. */
+#define SEG_CNTS_MIN            (-(1 << 13))
+#define SEG_CNTS_MAX            (1 << 13)
+
+static const uint32_t seg_ram_addr[2] = { STREAM_RAM_A_ADDR, STREAM_RAM_B_ADDR };
+
+typedef struct {
+    rp_acq_seg_config_t config;
+    uint32_t decimation;
+    uint32_t wp;                    // write pointer at the last update
+    uint64_t cur;                   // index of the sample at wp since the start
+    uint64_t last_ns;               // time of the last update
+    int32_t dc_offs[2];
+    const volatile int16_t* ram[2];
+    bool ddr_synced;                // ddr_base is known
+    int64_t ddr_base[2];            // unwrapped DDR byte offset of sample 0
+} seg_ctx_t;
+
+
+/* Positive remainder of x / y */
+static int64_t seg_Mod(int64_t x, int64_t y)
+{
+    int64_t m = x % y;
+    return m < 0 ? m + y : m;
+}
+
+/* Unwrapped DDR byte offset of sample 'k' of a channel */
+static int64_t seg_DdrByte(const seg_ctx_t* ctx, int ch, uint64_t k)
+{
+    return ctx->ddr_base[ch] + 2 * (int64_t) k;
+}
+
+/**
+ * Advances the sample counter by the distance the write pointer moved. The
+ * pointer alone cannot tell whole laps of the buffer, so on the board these
+ * are recovered from the time since the last update.
+ */
+static int seg_Update(seg_ctx_t* ctx)
+{
+    uint32_t wp;
+    ECHECK(osc_GetWritePointer(&wp));
+    uint64_t delta = (wp + ADC_BUFFER_SIZE - ctx->wp) % ADC_BUFFER_SIZE;
+
+    uint64_t now = cmn_NowNs();
+    if (cmn_GetBackend() == RP_BACKEND_DEVMEM) {
+        uint64_t recorded = (now - ctx->last_ns) / (SEG_SAMPLE_PERIOD_NS * ctx->decimation);
+        if (recorded >= delta + ADC_BUFFER_SIZE / 2) {
+            delta += (recorded - delta + ADC_BUFFER_SIZE / 2) / ADC_BUFFER_SIZE * ADC_BUFFER_SIZE;
+        }
+    }
+
+    ctx->last_ns = now;
+    ctx->wp = wp;
+    ctx->cur += delta;
+    return RP_OK;
+}
+
+/**
+ * Unwrapped write pointer of a recorder. The pointer is resolved around the
+ * position of the current sample, which it trails by the recorder FIFO.
+ */
+static int seg_DdrWritten(const seg_ctx_t* ctx, int ch, int64_t* written)
+{
+    uint32_t addr;
+    ECHECK(ch == 0 ? osc_GetAxiWritePointerChA(&addr) : osc_GetAxiWritePointerChB(&addr));
+
+    int64_t expected = seg_DdrByte(ctx, ch, ctx->cur);
+    int64_t diff = seg_Mod((int64_t) (addr - seg_ram_addr[ch]) - expected, STREAM_RAM_SIZE);
+    if (diff >= STREAM_RAM_SIZE / 2) {
+        diff -= STREAM_RAM_SIZE;
+    }
+    *written = expected + diff;
+    return RP_OK;
+}
+
+/* Checks whether all samples before 'end' are in the capture memory */
+static int seg_IsWritten(const seg_ctx_t* ctx, uint64_t end, bool* written)
+{
+    *written = ctx->cur + 1 >= end;
+    if (!*written || ctx->config.source == RP_SEG_SRC_BUFFER) {
+        return RP_OK;
+    }
+
+    // Recorders write whole words, so the word holding the last sample must be complete
+    for (int ch = 0; ch < 2; ++ch) {
+        int64_t ddr_written;
+        int64_t ddr_end = seg_DdrByte(ctx, ch, end);
+        ECHECK(seg_DdrWritten(ctx, ch, &ddr_written));
+        *written &= ddr_written >= ddr_end + seg_Mod(-ddr_end, SEG_DDR_WORD);
+    }
+    return RP_OK;
+}
+
+/* Copies and calibrates 'size' samples from a DDR buffer, starting at sample 'idx' */
+static void seg_CopyDdr(int16_t* dst, const volatile int16_t* ring, uint32_t idx, uint32_t size, int32_t dc_offs)
+{
+    const uint32_t ring_samples = STREAM_RAM_SIZE / sizeof(int16_t);
+
+    for (uint32_t i = 0; i < size; ) {
+        uint32_t len = MIN(size - i, ring_samples - idx);
+        for (uint32_t j = 0; j < len; ++j) {
+            int32_t m = ring[idx + j] - dc_offs;
+            dst[i + j] = MAX(MIN(m, SEG_CNTS_MAX), SEG_CNTS_MIN);
+        }
+        i += len;
+        idx = (idx + len) % ring_samples;
+    }
+}
+
+/**
+ * Copies samples [k, k + size) of both channels and checks afterwards that the
+ * oldest one, and so the whole chunk, was not overwritten in the meantime.
+ */
+static int seg_CopyChunk(seg_ctx_t* ctx, const rp_acq_segment_t* seg, uint64_t k, uint32_t size,
+                         int16_t* buffer1, int16_t* buffer2, bool* intact)
+{
+    int16_t* dst[2] = { buffer1, buffer2 };
+
+    if (ctx->config.source == RP_SEG_SRC_BUFFER) {
+        uint32_t pos = (seg->first_pos + (k - (seg->trig_sample - ctx->config.pre_samples))) % ADC_BUFFER_SIZE;
+        for (int ch = 0; ch < 2; ++ch) {
+            uint32_t len = size;
+            ECHECK(acq_GetDataRaw((rp_channel_t) ch, pos, &len, dst[ch]));
+        }
+        ECHECK(seg_Update(ctx));
+        *intact = ctx->cur < k + ADC_BUFFER_SIZE;
+        return RP_OK;
+    }
+
+    for (int ch = 0; ch < 2; ++ch) {
+        uint32_t idx = seg_Mod(seg_DdrByte(ctx, ch, k), STREAM_RAM_SIZE) / sizeof(int16_t);
+        seg_CopyDdr(dst[ch], ctx->ram[ch], idx, size, ctx->dc_offs[ch]);
+    }
+    ECHECK(seg_Update(ctx));
+    *intact = true;
+    for (int ch = 0; ch < 2; ++ch) {
+        int64_t ddr_written;
+        int64_t ddr_first = seg_DdrByte(ctx, ch, k);
+        ECHECK(seg_DdrWritten(ctx, ch, &ddr_written));
+        *intact &= ddr_written < ddr_first - seg_Mod(ddr_first, SEG_DDR_WORD) + STREAM_RAM_SIZE;
+    }
+    return RP_OK;
+}
+
+/**
+ * Records the trigger that has just cleared the trigger source. The trigger
+ * sample is located from its distance to the current write pointer.
+ */
+static int seg_RecordTrigger(seg_ctx_t* ctx, rp_acq_segment_t* seg)
+{
+    const uint32_t pre = ctx->config.pre_samples;
+    uint32_t wp_trig;
+
+    ECHECK(osc_GetWritePointerAtTrig(&wp_trig));
+    ECHECK(seg_Update(ctx));
+
+    uint64_t age = (ctx->wp + ADC_BUFFER_SIZE - wp_trig) % ADC_BUFFER_SIZE;
+    seg->trig_sample = ctx->cur - MIN(age, ctx->cur);
+    seg->timestamp_ns = seg->trig_sample * ctx->decimation * SEG_SAMPLE_PERIOD_NS;
+    seg->valid = true;
+
+    if (ctx->config.source == RP_SEG_SRC_BUFFER) {
+        seg->trig_pos = wp_trig;
+        seg->first_pos = (wp_trig + ADC_BUFFER_SIZE - pre) % ADC_BUFFER_SIZE;
+        return RP_OK;
+    }
+
+    // Recorders latch their pointer only at the first trigger, which maps sample indexes to DDR
+    if (!ctx->ddr_synced) {
+        uint32_t addr[2];
+        ECHECK(osc_GetAxiWritePointerAtTrigChA(&addr[0]));
+        ECHECK(osc_GetAxiWritePointerAtTrigChB(&addr[1]));
+        for (int ch = 0; ch < 2; ++ch) {
+            ctx->ddr_base[ch] = (int64_t) (addr[ch] - seg_ram_addr[ch]) - 2 * (int64_t) seg->trig_sample;
+        }
+        ctx->ddr_synced = true;
+    }
+    seg->trig_pos = seg_Mod(seg_DdrByte(ctx, 0, seg->trig_sample), STREAM_RAM_SIZE);
+    seg->first_pos = seg_Mod(seg_DdrByte(ctx, 0, seg->trig_sample - pre), STREAM_RAM_SIZE);
+    return RP_OK;
+}
+
+static int seg_Run(seg_ctx_t* ctx, uint64_t timeout_ns, int16_t* buffer1, int16_t* buffer2,
+                   rp_acq_segment_t* segments, uint32_t* count)
+{
+    const rp_acq_seg_config_t* config = &ctx->config;
+    const uint32_t seg_size = config->pre_samples + config->post_samples;
+    uint64_t start = cmn_NowNs();
+    uint32_t triggered = 0;     // segments with a recorded trigger
+    uint32_t captured = 0;      // segments copied completely
+    uint32_t copied = 0;        // samples copied of the next segment
+    bool armed = false;
+
+    // Sample counting starts once the model or the FPGA applied the reset
+    for (bool pending = true; pending; ) {
+        ECHECK(osc_IsResetPending(&pending));
+        if (cmn_NowNs() - start >= timeout_ns) {
+            return RP_ETIM;
+        }
+        CPU_RELAX();
+    }
+    ECHECK(osc_GetWritePointer(&ctx->wp));
+    ctx->cur = 0;
+    ctx->last_ns = cmn_NowNs();
+
+    while (captured < config->segments) {
+        uint32_t source = config->trigger_source;
+        if (armed) {
+            ECHECK(osc_GetTriggerSource(&source));
+        }
+        if (source == RP_TRIG_SRC_DISABLED) {
+            ECHECK(seg_RecordTrigger(ctx, &segments[triggered++]));
+            armed = false;
+        }
+        else {
+            ECHECK(seg_Update(ctx));
+        }
+
+        // The first trigger is armed once its pre trigger samples are recorded
+        if (!armed && triggered < config->segments && ctx->cur >= config->pre_samples) {
+            ECHECK(osc_SetTriggerSource(config->trigger_source));
+            armed = true;
+        }
+
+        if (captured < triggered) {
+            rp_acq_segment_t* seg = &segments[captured];
+            uint64_t k = seg->trig_sample - config->pre_samples + copied;
+            uint32_t size = MIN(SEG_COPY_CHUNK, seg_size - copied);
+            bool written;
+
+            ECHECK(seg_IsWritten(ctx, k + size, &written));
+            if (written) {
+                size_t offset = (size_t) captured * seg_size + copied;
+                bool intact;
+                ECHECK(seg_CopyChunk(ctx, seg, k, size, buffer1 + offset, buffer2 + offset, &intact));
+                seg->valid &= intact;
+                copied += size;
+                if (copied == seg_size) {
+                    copied = 0;
+                    *count = ++captured;
+                }
+                continue;
+            }
+        }
+
+        if (cmn_NowNs() - start >= timeout_ns) {
+            return RP_ETIM;
+        }
+        // Lets other threads on this core run without giving up the time slice to the idle task
+        sched_yield();
+    }
+
+    return RP_OK;
+}
+
+/* Keeps the scope writing across triggers and starts it, with the recorders for DDR segments */
+static int seg_Start(const seg_ctx_t* ctx)
+{
+    // Keep writing after the trigger, which only clears the trigger source
+    ECHECK(osc_SetTriggerSource(RP_TRIG_SRC_DISABLED));
+    ECHECK(osc_SetTriggerDelay(0));
+    ECHECK(osc_SetArmKeep(true));
+    if (ctx->config.source == RP_SEG_SRC_DDR) {
+        // Recorders stop after their trigger delay, so it is set to the maximum
+        ECHECK(osc_SetAxiBufferChA(STREAM_RAM_A_ADDR, STREAM_RAM_A_ADDR + STREAM_RAM_SIZE));
+        ECHECK(osc_SetAxiBufferChB(STREAM_RAM_B_ADDR, STREAM_RAM_B_ADDR + STREAM_RAM_SIZE));
+        ECHECK(osc_SetAxiTriggerDelayChA(AXI_DELAY_MASK));
+        ECHECK(osc_SetAxiTriggerDelayChB(AXI_DELAY_MASK));
+        ECHECK(osc_SetAxiEnableChA(true));
+        ECHECK(osc_SetAxiEnableChB(true));
+    }
+    ECHECK(osc_ResetWriteStateMachine());
+    ECHECK(acq_Start());
+    return RP_OK;
+}
+
+/* Stops the capture and brings back the settings of the user, whatever part of seg_Start() succeeded */
+static void seg_Teardown(seg_ctx_t* ctx, uint32_t trig_delay)
+{
+    osc_SetTriggerSource(RP_TRIG_SRC_DISABLED);
+    acq_Stop();
+    osc_SetArmKeep(false);
+    osc_SetTriggerDelay(trig_delay);
+    if (ctx->config.source == RP_SEG_SRC_DDR) {
+        osc_SetAxiEnableChA(false);
+        osc_SetAxiEnableChB(false);
+    }
+    for (int ch = 0; ch < 2; ++ch) {
+        if (ctx->ram[ch] != NULL) {
+            cmn_Unmap(STREAM_RAM_SIZE, (void**) &ctx->ram[ch]);
+        }
+    }
+}
+
+int seg_Capture(const rp_acq_seg_config_t* config, uint64_t timeout_ns, int16_t* buffer1, int16_t* buffer2,
+                rp_acq_segment_t* segments, uint32_t* count)
+{
+    const uint32_t seg_size = config->pre_samples + config->post_samples;
+    const bool ddr = config->source == RP_SEG_SRC_DDR;
+    seg_ctx_t ctx = { .config = *config };
+
+    *count = 0;
+    if (config->segments == 0 || seg_size == 0 || config->trigger_source == RP_TRIG_SRC_DISABLED
+            || config->trigger_source > RP_TRIG_SRC_AWG_NE) {
+        return RP_EIPV;
+    }
+    if ((config->source == RP_SEG_SRC_BUFFER && seg_size > ADC_BUFFER_SIZE)
+            || (ddr && seg_size * sizeof(int16_t) > STREAM_RAM_SIZE / 2)
+            || (config->source != RP_SEG_SRC_BUFFER && !ddr)) {
+        return RP_EIPV;
+    }
+    if (stream_IsRunning()) {
+        return RP_EUF;
+    }
+
+    ECHECK(acq_GetDecimationFactor(&ctx.decimation));
+    ECHECK(acq_GetDcOffset(RP_CH_1, &ctx.dc_offs[0]));
+    ECHECK(acq_GetDcOffset(RP_CH_2, &ctx.dc_offs[1]));
+
+    uint32_t trig_delay;
+    ECHECK(osc_GetTriggerDelay(&trig_delay));
+
+    int ret = RP_OK;
+    if (ddr) {
+        ret = cmn_Map(STREAM_RAM_SIZE, STREAM_RAM_A_ADDR, (void**) &ctx.ram[0]);
+        if (ret == RP_OK) {
+            ret = cmn_Map(STREAM_RAM_SIZE, STREAM_RAM_B_ADDR, (void**) &ctx.ram[1]);
+        }
+    }
+    if (ret == RP_OK) {
+        ret = seg_Start(&ctx);
+    }
+    if (ret == RP_OK) {
+        ret = seg_Run(&ctx, timeout_ns, buffer1, buffer2, segments, count);
+    }
+
+    seg_Teardown(&ctx, trig_delay);
+    return ret;
+}
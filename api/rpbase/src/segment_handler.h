@@ -0,0 +1,24 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library segmented acquisition handler interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_SEGMENT_HANDLER_H_
+#define SRC_SEGMENT_HANDLER_H_
+
+#include <stdint.h>
+#include "redpitaya/rp.h"
+
+int seg_Capture(const rp_acq_seg_config_t* config, uint64_t timeout_ns, int16_t* buffer1, int16_t* buffer2,
+                rp_acq_segment_t* segments, uint32_t* count);
+
+#endif /* SRC_SEGMENT_HANDLER_H_ */
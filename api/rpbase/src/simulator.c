@@ -0,0 +1,642 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA backend implementation
+ *
+ * The simulated backend replaces /dev/mem mappings with anonymous memory so
+ * the library can run on machines without Red Pitaya hardware. A small
+ * software model of the oscilloscope write state machine moves the write
+ * pointers, detects triggers and fills the ADC buffers from a pluggable
+ * signal source each time sim_Step() is called. The read pointers of the
+ * signal generator advance in the same steps, and the samples they pass can
+ * be handed to an output sink. The slow analog channels read back fixed
+ * values with a small ripple.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "generate.h"
+#include "simulator.h"
+
+/* Configuration register bits */
+#define SIM_CONF_ARM        0x1
+#define SIM_CONF_RST        0x2
+#define SIM_CONF_TRIG       0x4
+#define SIM_CONF_KEEP       0x8
+
+/* Trigger sources, as decoded by the FPGA */
+#define SIM_TRIG_NOW        1
+#define SIM_TRIG_CHA_PE     2
+#define SIM_TRIG_CHA_NE     3
+#define SIM_TRIG_CHB_PE     4
+#define SIM_TRIG_CHB_NE     5
+#define SIM_TRIG_AWG_PE     8
+#define SIM_TRIG_AWG_NE     9
+
+/* Number of samples produced by the signal source in one call */
+#define SIM_CHUNK_SIZE      1024
+
+/* Default signal source - sine with given frequency and amplitude */
+#define SIM_DEFAULT_FREQ    1e6         // Hz
+#define SIM_DEFAULT_AMP     4096        // ADC counts
+#define SIM_SAMPLE_RATE     125e6       // Hz
+
+/* Slow analog channel model */
+#define SIM_AMS_RIPPLE      0.01        // peak to peak, relative to the value
+#define SIM_AMS_PERIOD      16          // reads per ripple period
+
+typedef struct sim_region_s {
+    size_t   offset;
+    size_t   size;
+    void     *mem;
+    int      refs;
+} sim_region_t;
+
+typedef struct sim_osc_state_s {
+    bool     writing;       // last seen state of the arm bit
+    bool     triggered;     // trigger arrived, post trigger delay is counting
+    uint32_t wp;            // position of the next sample in the buffers
+    uint32_t dly_cnt;       // remaining post trigger samples
+    uint64_t sample;        // decimated samples produced since initialization
+    bool     arm_p[2];      // schmitt trigger states for positive edges
+    bool     arm_n[2];      // schmitt trigger states for negative edges
+    bool     axi_we[2];     // AXI recorder is writing
+    bool     axi_dly_do[2]; // AXI recorder post trigger delay is counting
+    uint32_t axi_dly_cnt[2];// remaining AXI post trigger samples
+    uint32_t axi_sel[2];    // samples collected in the current 64 bit word
+    uint64_t axi_word[2];   // 64 bit word being collected
+    uint32_t axi_addr[2];   // bus address of the next word
+    bool     awg_trig;      // generator channel A was triggered before this step
+} sim_osc_state_t;
+
+typedef struct sim_gen_state_s {
+    uint64_t clock;         // DAC clocks since initialization
+    uint64_t pnt[2];        // read pointers, 16.16 fixed point as on the FPGA
+    uint32_t trig;          // software triggers since the last step, bit 0 channel A
+} sim_gen_state_t;
+
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sim_region_t regions[SIM_MAX_REGIONS];
+static sim_osc_state_t osc_state;
+static sim_gen_state_t gen_state;
+
+static void sim_DefaultSource(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx);
+
+static rp_sim_source_t source = sim_DefaultSource;
+static void *source_ctx = NULL;
+
+// Values of the slow analog channels, see rp_ams_channel_t
+static const float sim_ams_nominal[RP_AMS_CHANNELS] = { 0.5f, 1.0f, 1.5f, 2.0f, 45.0f, 1.0f, 1.8f, 1.0f };
+static uint32_t sim_ams_reads[RP_AMS_CHANNELS];
+
+static rp_sim_sink_t sink = NULL;
+static void *sink_ctx = NULL;
+
+/* Trigger interrupt, delivered through an eventfd */
+static bool trig_irq_enabled = true;
+static int trig_irq_fd = -1;
+
+
+static void sim_DefaultSource(rp_channel_t channel, uint64_t sample, uint32_t decimation, int16_t *buffer, uint32_t size, void *ctx)
+{
+    double step = 2 * M_PI * SIM_DEFAULT_FREQ * decimation / SIM_SAMPLE_RATE;
+    double phase = (channel == RP_CH_1) ? 0 : M_PI / 2;
+
+    for (uint32_t i = 0; i < size; ++i) {
+        buffer[i] = (int16_t) round(SIM_DEFAULT_AMP * sin(fmod((sample + i) * step, 2 * M_PI) + phase));
+    }
+}
+
+/* Converts 14 bit two's complement register value to signed number */
+static int32_t sim_ToSigned(uint32_t cnts)
+{
+    cnts &= 0x3FFF;
+    return (cnts & 0x2000) ? (int32_t) cnts - 0x4000 : (int32_t) cnts;
+}
+
+static sim_region_t* sim_FindRegion(size_t offset)
+{
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL && regions[i].offset == offset) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+/* Returns the region covering the given bus address */
+static sim_region_t* sim_FindRegionAt(size_t address)
+{
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL && address >= regions[i].offset && address < regions[i].offset + regions[i].size) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+int sim_Init()
+{
+    pthread_mutex_lock(&sim_mutex);
+    osc_state = (sim_osc_state_t) { 0 };
+    gen_state = (sim_gen_state_t) { 0 };
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+int sim_Release()
+{
+    pthread_mutex_lock(&sim_mutex);
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL) {
+            munmap(regions[i].mem, regions[i].size);
+            regions[i] = (sim_region_t) { 0 };
+        }
+    }
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+/**
+ * Maps simulated register region. Regions are identified by their physical
+ * address, so mapping the same address twice returns the same memory just
+ * like two mappings of /dev/mem would.
+ */
+int sim_Map(size_t size, size_t offset, void** mapped)
+{
+    int ret = RP_OK;
+    pthread_mutex_lock(&sim_mutex);
+
+    sim_region_t *region = sim_FindRegion(offset);
+    if (region != NULL) {
+        if (region->size < size) {
+            ret = RP_EMMD;
+        }
+        else {
+            region->refs++;
+            *mapped = region->mem;
+        }
+        pthread_mutex_unlock(&sim_mutex);
+        return ret;
+    }
+
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem == NULL) {
+            region = &regions[i];
+            break;
+        }
+    }
+
+    if (region == NULL) {
+        ret = RP_EMMD;
+    }
+    else {
+        void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            ret = RP_EMMD;
+        }
+        else {
+            *region = (sim_region_t) { .offset = offset, .size = size, .mem = mem, .refs = 1 };
+            *mapped = mem;
+        }
+    }
+
+    pthread_mutex_unlock(&sim_mutex);
+    return ret;
+}
+
+int sim_Unmap(size_t size, void** mapped)
+{
+    int ret = RP_EUMD;
+    pthread_mutex_lock(&sim_mutex);
+
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL && regions[i].mem == *mapped) {
+            if (--regions[i].refs == 0) {
+                munmap(regions[i].mem, regions[i].size);
+                regions[i] = (sim_region_t) { 0 };
+            }
+            *mapped = NULL;
+            ret = RP_OK;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&sim_mutex);
+    return ret;
+}
+
+int sim_SetSignalSource(rp_sim_source_t src, void *ctx)
+{
+    pthread_mutex_lock(&sim_mutex);
+    source = src ? src : sim_DefaultSource;
+    source_ctx = src ? ctx : NULL;
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+int sim_SetOutputSink(rp_sim_sink_t snk, void *ctx)
+{
+    pthread_mutex_lock(&sim_mutex);
+    sink = snk;
+    sink_ctx = snk ? ctx : NULL;
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+/**
+ * Reports a software trigger of the generator channels in 'mask' (bit 0
+ * channel A, bit 1 channel B). The model cannot see write pulses in the
+ * registers, so the generator module passes them on; they take effect with
+ * the next step.
+ */
+int sim_GenTrigger(uint32_t mask)
+{
+    pthread_mutex_lock(&sim_mutex);
+    gen_state.trig |= mask;
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+/**
+ * Reads a slow analog channel: its nominal value with a triangle ripple
+ * over SIM_AMS_PERIOD reads, whose mean is the nominal value.
+ */
+int sim_AmsRead(rp_ams_channel_t channel, float* value)
+{
+    if (channel >= RP_AMS_CHANNELS) {
+        return RP_EPN;
+    }
+    uint32_t k = __atomic_fetch_add(&sim_ams_reads[channel], 1, __ATOMIC_RELAXED) % SIM_AMS_PERIOD;
+    double triangle = (double) (k < SIM_AMS_PERIOD / 2 ? k : SIM_AMS_PERIOD - k) / (SIM_AMS_PERIOD / 2) - 0.5;
+    *value = sim_ams_nominal[channel] * (1 + SIM_AMS_RIPPLE * triangle);
+    return RP_OK;
+}
+
+int sim_SetTriggerIrq(bool enable)
+{
+    pthread_mutex_lock(&sim_mutex);
+    trig_irq_enabled = enable;
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+/**
+ * Opens the simulated interrupt line. Only the oscilloscope trigger is
+ * modelled; it is an eventfd signalled every time the model triggers.
+ */
+int sim_IrqOpen(const char* name, int* irq_fd)
+{
+    int ret = RP_OK;
+    pthread_mutex_lock(&sim_mutex);
+
+    if (!trig_irq_enabled || strcmp(name, OSC_TRIG_IRQ_NAME) != 0 || trig_irq_fd != -1) {
+        ret = RP_EOMD;
+    }
+    else if ((trig_irq_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+        ret = RP_EOMD;
+    }
+    else {
+        *irq_fd = trig_irq_fd;
+    }
+
+    pthread_mutex_unlock(&sim_mutex);
+    return ret;
+}
+
+int sim_IrqClose(int* irq_fd)
+{
+    pthread_mutex_lock(&sim_mutex);
+    if (*irq_fd == trig_irq_fd) {
+        trig_irq_fd = -1;
+    }
+    close(*irq_fd);
+    *irq_fd = -1;
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
+
+static void sim_RaiseTriggerIrq()
+{
+    uint64_t one = 1;
+    if (trig_irq_fd != -1 && write(trig_irq_fd, &one, sizeof(one)) != sizeof(one)) {
+        // Counter is saturated, so the waiter is woken anyway
+    }
+}
+
+/**
+ * Evaluates both schmitt triggers of a channel for one sample and returns
+ * true when the requested edge was detected.
+ */
+static bool sim_EdgeDetect(int ch, int32_t value, int32_t thr, int32_t hyst, bool positive)
+{
+    bool edge = false;
+
+    if (value < thr - hyst) {
+        osc_state.arm_p[ch] = true;
+    }
+    else if (value >= thr) {
+        edge |= positive && osc_state.arm_p[ch];
+        osc_state.arm_p[ch] = false;
+    }
+
+    if (value > thr + hyst) {
+        osc_state.arm_n[ch] = true;
+    }
+    else if (value <= thr) {
+        edge |= !positive && osc_state.arm_n[ch];
+        osc_state.arm_n[ch] = false;
+    }
+
+    return edge;
+}
+
+/**
+ * Feeds one sample to the AXI recorder of a channel. Samples are packed into
+ * 64 bit words which are written between the start and stop address, wrapping
+ * around like the axi_wr_fifo in the FPGA.
+ */
+static void sim_AxiWrite(volatile osc_control_t *osc, int ch, int16_t value, bool trig)
+{
+    volatile uint32_t *start = ch == 0 ? &osc->cha_axi_low : &osc->chb_axi_low;
+    volatile uint32_t *stop  = ch == 0 ? &osc->cha_axi_high : &osc->chb_axi_high;
+    volatile uint32_t *dly   = ch == 0 ? &osc->cha_trig_delay : &osc->chb_trig_delay;
+    volatile uint32_t *w_trig = ch == 0 ? &osc->cha_w_ptr_trig : &osc->chb_w_ptr_trig;
+    volatile uint32_t *w_cur = ch == 0 ? &osc->cha_w_ptr_curr : &osc->chb_w_ptr_curr;
+
+    if (trig && !osc_state.axi_dly_do[ch]) {
+        *w_trig = osc_state.axi_addr[ch] | (osc_state.axi_sel[ch] << 1);
+        osc_state.axi_dly_do[ch] = true;
+        osc_state.axi_dly_cnt[ch] = *dly;
+    }
+
+    osc_state.axi_word[ch] |= (uint64_t)(uint16_t) value << (16 * osc_state.axi_sel[ch]);
+    if (++osc_state.axi_sel[ch] == 4) {
+        sim_region_t *ram = sim_FindRegionAt(osc_state.axi_addr[ch]);
+        if (ram != NULL && osc_state.axi_addr[ch] + 8 <= ram->offset + ram->size) {
+            *(uint64_t *)((char *) ram->mem + (osc_state.axi_addr[ch] - ram->offset)) = osc_state.axi_word[ch];
+        }
+        osc_state.axi_addr[ch] += 8;
+        if (osc_state.axi_addr[ch] >= *stop) {
+            osc_state.axi_addr[ch] = *start;
+        }
+        *w_cur = osc_state.axi_addr[ch];
+        osc_state.axi_word[ch] = 0;
+        osc_state.axi_sel[ch] = 0;
+    }
+
+    if (osc_state.axi_dly_do[ch]) {
+        if (osc_state.axi_dly_cnt[ch] > 0) {
+            osc_state.axi_dly_cnt[ch]--;
+        }
+        if (osc_state.axi_dly_cnt[ch] == 0) {
+            osc_state.axi_dly_do[ch] = false;
+            osc_state.axi_we[ch] = false;
+        }
+    }
+}
+
+/**
+ * Advances the oscilloscope model by the given number of decimated samples.
+ * Behaviour follows the write state machine in red_pitaya_scope.v: arming
+ * enables writing, the trigger latches the write pointer and starts the post
+ * trigger delay, and writing stops (unless arm keep is set) when the delay
+ * reaches zero. Enabled AXI recorders are armed together with the buffer and
+ * keep writing into DDR until their own post trigger delay expires.
+ */
+static void sim_OscStep(volatile osc_control_t *osc, uint32_t samples)
+{
+    int16_t data[2][SIM_CHUNK_SIZE];
+    volatile uint32_t *buf_a = (volatile uint32_t *)((char *)osc + OSC_CHA_OFFSET);
+    volatile uint32_t *buf_b = (volatile uint32_t *)((char *)osc + OSC_CHB_OFFSET);
+
+    while (samples > 0) {
+        uint32_t conf = osc->conf;
+
+        /* Reset and arm are write pulses on the FPGA. Here both bits stay set
+         * until the model runs, so an arm written after the reset is kept. */
+        if (conf & SIM_CONF_RST) {
+            osc->wr_ptr_cur = 0;
+            osc->wr_ptr_trigger = 0;
+            osc->pre_trigger_counter = 0;
+            osc->trig_source = 0;
+            conf &= ~(SIM_CONF_RST | SIM_CONF_TRIG);
+            osc_state.wp = 0;
+            osc_state.writing = false;
+            osc_state.triggered = false;
+            for (int ch = 0; ch < 2; ++ch) {
+                osc_state.axi_we[ch] = false;
+                osc_state.axi_dly_do[ch] = false;
+                osc_state.axi_sel[ch] = 0;
+                osc_state.axi_word[ch] = 0;
+            }
+            osc_state.axi_addr[0] = osc->cha_axi_low;
+            osc_state.axi_addr[1] = osc->chb_axi_low;
+            osc->cha_w_ptr_trig = 0;
+            osc->chb_w_ptr_trig = 0;
+            osc->cha_w_ptr_curr = osc->cha_axi_low;
+            osc->chb_w_ptr_curr = osc->chb_axi_low;
+        }
+
+        bool armed = (conf & SIM_CONF_ARM) != 0;
+        if (armed && !osc_state.writing) {
+            osc->pre_trigger_counter = 0;
+            osc_state.triggered = false;
+            conf &= ~SIM_CONF_TRIG;
+            osc_state.axi_we[0] = osc->cha_enable_axi_m & 0x1;
+            osc_state.axi_we[1] = osc->chb_enable_axi_m & 0x1;
+        }
+        osc_state.writing = armed;
+
+        uint32_t decimation = osc->data_dec ? osc->data_dec : 1;
+        uint32_t chunk = MIN(samples, SIM_CHUNK_SIZE);
+        source(RP_CH_1, osc_state.sample, decimation, data[0], chunk, source_ctx);
+        source(RP_CH_2, osc_state.sample, decimation, data[1], chunk, source_ctx);
+        osc_state.sample += chunk;
+        samples -= chunk;
+
+        if (!osc_state.writing && !osc_state.axi_we[0] && !osc_state.axi_we[1]) {
+            osc->conf = conf;
+            continue;
+        }
+
+        uint32_t trig_src = osc->trig_source & TRIG_SRC_MASK;
+        int32_t thr[2]  = { sim_ToSigned(osc->cha_thr), sim_ToSigned(osc->chb_thr) };
+        int32_t hyst[2] = { osc->cha_hystersis & HYSTERESIS_MASK, osc->chb_hystersis & HYSTERESIS_MASK };
+        uint32_t pre_trigger = osc->pre_trigger_counter;
+        bool keep = (conf & SIM_CONF_KEEP) != 0;
+        bool irq = false;
+
+        for (uint32_t i = 0; i < chunk; ++i) {
+            bool trig = false;
+
+            if (osc_state.writing) {
+                uint32_t wp = osc_state.wp;
+                buf_a[wp] = (uint32_t) data[0][i] & 0x3FFF;
+                buf_b[wp] = (uint32_t) data[1][i] & 0x3FFF;
+                osc->wr_ptr_cur = wp;
+                osc_state.wp = (wp + 1) % ADC_BUFFER_SIZE;
+
+                if (osc_state.triggered) {
+                    if (osc_state.dly_cnt > 0) {
+                        osc_state.dly_cnt--;
+                    }
+                    if (osc_state.dly_cnt == 0) {
+                        osc_state.triggered = false;
+                        conf &= ~SIM_CONF_TRIG;
+                        trig_src = 0;
+                        osc->trig_source = 0;
+                        if (!keep) {
+                            conf &= ~SIM_CONF_ARM;
+                            osc_state.writing = false;
+                        }
+                    }
+                }
+                else {
+                    if (pre_trigger != 0xFFFFFFFF) {
+                        pre_trigger++;
+                    }
+
+                    switch (trig_src) {
+                    case SIM_TRIG_NOW:
+                        trig = true;
+                        break;
+                    case SIM_TRIG_CHA_PE:
+                    case SIM_TRIG_CHA_NE:
+                        trig = sim_EdgeDetect(0, data[0][i], thr[0], hyst[0], trig_src == SIM_TRIG_CHA_PE);
+                        break;
+                    case SIM_TRIG_CHB_PE:
+                    case SIM_TRIG_CHB_NE:
+                        trig = sim_EdgeDetect(1, data[1][i], thr[1], hyst[1], trig_src == SIM_TRIG_CHB_PE);
+                        break;
+                    case SIM_TRIG_AWG_PE:
+                    case SIM_TRIG_AWG_NE:
+                        // The burst starts with the step, both edges of the trigger are seen at once
+                        trig = osc_state.awg_trig;
+                        break;
+                    default:
+                        // External triggers are never raised by the model
+                        break;
+                    }
+                    osc_state.awg_trig = false;
+
+                    if (trig) {
+                        osc->wr_ptr_trigger = wp;
+                        osc_state.triggered = true;
+                        osc_state.dly_cnt = osc->trigger_delay;
+                        conf |= SIM_CONF_TRIG;
+                        irq = true;
+                    }
+                }
+            }
+
+            for (int ch = 0; ch < 2; ++ch) {
+                if (osc_state.axi_we[ch]) {
+                    sim_AxiWrite(osc, ch, data[ch][i], trig);
+                }
+            }
+        }
+
+        osc->pre_trigger_counter = pre_trigger;
+        osc->conf = conf;
+
+        // Interrupt is raised once the trigger state is visible in the registers
+        if (irq) {
+            sim_RaiseTriggerIrq();
+        }
+    }
+}
+
+/**
+ * Advances the generator read pointers by the given number of DAC clocks.
+ * Only continuous playback in wrap mode is modelled: a pointer is held at the
+ * start offset while its state machine is reset, and otherwise runs whenever
+ * a trigger source is selected. Reset pulses written between two steps are
+ * not seen, a step of zero clocks lets the model sample the reset bits.
+ * Software triggers, reported by sim_GenTrigger(), move the pointer to the
+ * start offset; one of channel A is passed on to the oscilloscope.
+ */
+static void sim_GenStep(volatile generate_control_t *gen, uint64_t clocks)
+{
+    int16_t data[SIM_CHUNK_SIZE];
+
+    for (int ch = 0; ch < 2; ++ch) {
+        volatile ch_properties_t *props = ch == 0 ? &gen->properties_chA : &gen->properties_chB;
+        volatile int32_t *buf = (volatile int32_t *)((char *) gen + (ch == 0 ? CHA_DATA_OFFSET : CHB_DATA_OFFSET));
+        bool reset = ch == 0 ? gen->ASM_reset : gen->BSM_reset;
+        bool running = (ch == 0 ? gen->AtriggerSelector : gen->BtriggerSelector) != 0;
+        uint64_t wrap = (uint64_t) props->counterWrap + 1;
+        uint64_t step = props->counterStep;
+        uint64_t pnt = gen_state.pnt[ch];
+
+        if (gen_state.trig & (1 << ch)) {
+            // A software trigger restarts the signal from the start offset
+            pnt = props->startOffset % wrap;
+        }
+        if (reset) {
+            pnt = props->startOffset % wrap;
+        }
+        else if (running && sink == NULL) {
+            pnt = (pnt + step * clocks) % wrap;
+        }
+        else if (running) {
+            for (uint64_t done = 0; done < clocks; ) {
+                uint32_t chunk = MIN(clocks - done, SIM_CHUNK_SIZE);
+                for (uint32_t i = 0; i < chunk; ++i) {
+                    data[i] = sim_ToSigned(buf[(pnt >> 16) % BUFFER_LENGTH]);
+                    pnt = (pnt + step) % wrap;
+                }
+                sink(ch == 0 ? RP_CH_1 : RP_CH_2, gen_state.clock + done, data, chunk, sink_ctx);
+                done += chunk;
+            }
+        }
+
+        gen_state.pnt[ch] = pnt;
+        props->buffReadPointer = (pnt >> 16) % BUFFER_LENGTH;
+    }
+    // A step of zero clocks keeps the triggers for the next one, as the oscilloscope sees no sample
+    if (clocks > 0) {
+        osc_state.awg_trig = (gen_state.trig & 0x1) != 0;
+        gen_state.trig = 0;
+    }
+    gen_state.clock += clocks;
+}
+
+int sim_Step(uint32_t samples)
+{
+    pthread_mutex_lock(&sim_mutex);
+
+    sim_region_t *region = sim_FindRegion(OSC_BASE_ADDR);
+    if (region == NULL) {
+        pthread_mutex_unlock(&sim_mutex);
+        return RP_EMMD;
+    }
+    volatile osc_control_t *osc = (volatile osc_control_t *) region->mem;
+    uint32_t decimation = osc->data_dec ? osc->data_dec : 1;
+
+    // The generator goes first, so that its trigger is seen by the oscilloscope in the same step
+    sim_region_t *gen_region = sim_FindRegion(GENERATE_BASE_ADDR);
+    if (gen_region != NULL) {
+        sim_GenStep((volatile generate_control_t *) gen_region->mem, (uint64_t) samples * decimation);
+    }
+    sim_OscStep(osc, samples);
+    osc_state.awg_trig = false;
+
+    pthread_mutex_unlock(&sim_mutex);
+    return RP_OK;
+}
@@ -0,0 +1,43 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA backend interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_SIMULATOR_H_
+#define SRC_SIMULATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "redpitaya/rp.h"
+
+// Maximal number of register regions mapped at the same time
+#define SIM_MAX_REGIONS 8
+
+int sim_Init();
+int sim_Release();
+
+int sim_Map(size_t size, size_t offset, void** mapped);
+int sim_Unmap(size_t size, void** mapped);
+
+int sim_SetSignalSource(rp_sim_source_t source, void *ctx);
+int sim_SetOutputSink(rp_sim_sink_t sink, void *ctx);
+int sim_Step(uint32_t samples);
+
+int sim_GenTrigger(uint32_t mask);
+int sim_AmsRead(rp_ams_channel_t channel, float* value);
+int sim_SetTriggerIrq(bool enable);
+int sim_IrqOpen(const char* name, int* irq_fd);
+int sim_IrqClose(int* irq_fd);
+
+#endif /* SRC_SIMULATOR_H_ */
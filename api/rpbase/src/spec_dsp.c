@@ -20,10 +20,17 @@
 #include <math.h>
 #include <stdlib.h>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "spec_dsp.h"
 //#include "spectrometerApp.h"
 #include "spec_fpga.h"
 #include "kiss_fftr.h"
+#include "fft_handler.h"
 
 extern float g_spectr_fpga_adc_max_v;
 extern const int c_spectr_fpga_adc_bits;
@@ -36,6 +43,26 @@ kiss_fft_cpx         *rp_kiss_fft_out1 = NULL;
 kiss_fft_cpx         *rp_kiss_fft_out2 = NULL;
 kiss_fftr_cfg         rp_kiss_fft_cfg  = NULL;
 
+/* Number of transform lengths the single precision pipeline keeps windows for */
+#define SPECTR_PLAN_CACHE 4
+
+/* Window and buffers of the single precision pipeline for one length.
+ * A plan is pinned by every call using it and is only replaced or freed
+ * when no call holds it.
+ */
+typedef struct {
+    int            len;
+    int            refs;
+    int            cached;   /* 0 for a plan built because every cache slot was pinned */
+    float         *window;
+    rp_fft_cpx_t  *in;
+    rp_fft_cpx_t  *out;
+} rp_spectr_plan_t;
+
+static rp_spectr_plan_t rp_spectr_plans[SPECTR_PLAN_CACHE];
+static int              rp_spectr_plan_next = 0;
+static pthread_mutex_t  rp_spectr_plan_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* constants - calibration dependant */
 /* Power calc. impedance*/
 const double c_imp = 50;
@@ -195,7 +222,7 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
                        int in_len, int out_len)
 {
     int step;
-    int i, j;
+    int i, j, k, end;
     float *cha_o = *cha_out;
     float *chb_o = *chb_out;
 
@@ -206,36 +233,331 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
     if(step < 1)
         step = 1;
 
-    for(i = 0, j = 0; i < out_len; i++, j+=step) {
-        int k=j;
+    /* Conversion factor from ADC counts to Volts */
+    double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+    /* Amplitude^2 -> power (Watts) into c_imp = 50 Ohms, the transmission line
+     * impedance, x 2 for unilateral spectral density representation */
+    double scale = c2v * c2v / c_imp /
+        (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2;
 
+    for(i = 0, j = 0; i < out_len; i++, j+=step) {
         if(j >= in_len) {
             fprintf(stderr, "rp_spectr_decimate() index too high\n");
             return -1;
         }
-        cha_o[i] = 0;
-        chb_o[i] = 0;
-	
-	/* Conversion factor from ADC counts to Volts */
-    	double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
-	
-        for(k=j; k < j+step; k++) {
-	
-	/* Conversion to power (Watts) */  
-        double cha_p = pow(cha_in[k] * c2v, 2) / c_imp /
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2; // x 2 for unilateral spectral density representation
-        double chb_p = pow(chb_in[k] * c2v, 2) / c_imp /                   // c_imp = 50 Ohms, is the transmission line impdeance   
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2;
-	  
-	  
-            cha_o[i] += (float)cha_p;  // Summing the power expressed in Watts associated to each FFT bin
-            chb_o[i] += (float)chb_p;
+        end = j + step <= in_len ? j + step : in_len;
+
+        /* Summing the squared amplitudes of the FFT bins of both channels;
+         * 32 bit NEON has no double precision lanes */
+        double cha_p = 0, chb_p = 0;
+        k = j;
+#if defined(__aarch64__)
+        float64x2_t acc_a = vdupq_n_f64(0), acc_b = vdupq_n_f64(0);
+        for(; k + 2 <= end; k += 2) {
+            float64x2_t a = vld1q_f64(cha_in + k), b = vld1q_f64(chb_in + k);
+            acc_a = vfmaq_f64(acc_a, a, a);
+            acc_b = vfmaq_f64(acc_b, b, b);
         }
+        cha_p = vaddvq_f64(acc_a);
+        chb_p = vaddvq_f64(acc_b);
+#elif defined(__SSE2__)
+        __m128d acc_a = _mm_setzero_pd(), acc_b = _mm_setzero_pd();
+        for(; k + 2 <= end; k += 2) {
+            __m128d a = _mm_loadu_pd(cha_in + k), b = _mm_loadu_pd(chb_in + k);
+            acc_a = _mm_add_pd(acc_a, _mm_mul_pd(a, a));
+            acc_b = _mm_add_pd(acc_b, _mm_mul_pd(b, b));
+        }
+        /* (a0 + a1, b0 + b1) */
+        __m128d sum = _mm_add_pd(_mm_unpacklo_pd(acc_a, acc_b), _mm_unpackhi_pd(acc_a, acc_b));
+        cha_p = _mm_cvtsd_f64(sum);
+        chb_p = _mm_cvtsd_f64(_mm_unpackhi_pd(sum, sum));
+#endif
+        for(; k < end; k++) {
+            cha_p += cha_in[k] * cha_in[k];
+            chb_p += chb_in[k] * chb_in[k];
+        }
+
+        /* Power expressed in Watts */
+        cha_o[i] = (float)(cha_p * scale);
+        chb_o[i] = (float)(chb_p * scale);
+    }
+
+    return 0;
+}
+
+static void rp_spectr_plan_free(rp_spectr_plan_t *plan)
+{
+    free(plan->window);
+    free(plan->in);
+    free(plan->out);
+    memset(plan, 0, sizeof(*plan));
+}
+
+/* Allocates the window and buffers of a plan for len */
+static int rp_spectr_plan_init(rp_spectr_plan_t *plan, int len)
+{
+    int i;
+
+    plan->window = (float *)malloc(len * sizeof(float));
+    plan->in     = (rp_fft_cpx_t *)malloc(len * sizeof(rp_fft_cpx_t));
+    plan->out    = (rp_fft_cpx_t *)malloc(len * sizeof(rp_fft_cpx_t));
+    if(!plan->window || !plan->in || !plan->out) {
+        fprintf(stderr, "rp_spectr_plan_get() can not allocate mem\n");
+        rp_spectr_plan_free(plan);
+        return -1;
+    }
+    /* Same window as rp_spectr_hann_init() */
+    for(i = 0; i < len; i++) {
+        plan->window[i] = RP_SPECTR_HANN_AMP *
+            (1 - cos(2*M_PI*i / (double)(len-1)));
+    }
+    plan->len = len;
+    return 0;
+}
+
+/* Returns the pinned window and buffers for len, replacing the oldest unpinned
+ * plan when the cache is full. Release with rp_spectr_plan_put().
+ */
+static rp_spectr_plan_t *rp_spectr_plan_get(int len)
+{
+    rp_spectr_plan_t *plan = NULL;
+    int i;
+
+    pthread_mutex_lock(&rp_spectr_plan_mutex);
+    for(i = 0; i < SPECTR_PLAN_CACHE; i++) {
+        if(rp_spectr_plans[i].len == len) {
+            plan = &rp_spectr_plans[i];
+            break;
+        }
+    }
+
+    if(!plan) {
+        for(i = 0; i < SPECTR_PLAN_CACHE; i++) {
+            rp_spectr_plan_t *slot = &rp_spectr_plans[rp_spectr_plan_next];
+            rp_spectr_plan_next = (rp_spectr_plan_next + 1) % SPECTR_PLAN_CACHE;
+            if(slot->refs == 0) {
+                rp_spectr_plan_free(slot);
+                plan = slot;
+                break;
+            }
+        }
+        if(plan) {
+            if(rp_spectr_plan_init(plan, len) < 0) {
+                plan = NULL;
+            } else {
+                plan->cached = 1;
+            }
+        } else {
+            /* Every slot is in use by another length, the plan lives for this call only */
+            plan = (rp_spectr_plan_t *)calloc(1, sizeof(rp_spectr_plan_t));
+            if(plan && rp_spectr_plan_init(plan, len) < 0) {
+                free(plan);
+                plan = NULL;
+            }
+        }
+    }
+    if(plan) {
+        plan->refs++;
+    }
+    pthread_mutex_unlock(&rp_spectr_plan_mutex);
+
+    return plan;
+}
+
+/* Releases a plan returned by rp_spectr_plan_get() */
+static void rp_spectr_plan_put(rp_spectr_plan_t *plan)
+{
+    pthread_mutex_lock(&rp_spectr_plan_mutex);
+    if(--plan->refs == 0 && !plan->cached) {
+        rp_spectr_plan_free(plan);
+        free(plan);
+    }
+    pthread_mutex_unlock(&rp_spectr_plan_mutex);
+}
+
+int rp_spectr_fft_power_f(const float *cha_in, const float *chb_in,
+                          float *cha_out, float *chb_out, int len)
+{
+    rp_spectr_plan_t *plan;
+    rp_fft_plan_t *fft;
+    const rp_fft_cpx_t *z;
+    int i, half = len / 2;
+
+    if(!cha_in || !chb_in || !cha_out || !chb_out || len < 2 || (len & 1))
+        return -1;
+
+    /* The FFT plan is looked up on every call, so it follows rp_FftSetBackend() */
+    plan = rp_spectr_plan_get(len);
+    if(!plan)
+        return -1;
+    if(fft_PlanGet(len, RP_FFT_COMPLEX, &fft) != RP_OK) {
+        rp_spectr_plan_put(plan);
+        return -1;
+    }
+
+    /* Window, with channel A as the real and channel B as the imaginary part */
+    for(i = 0; i < len; i++) {
+        plan->in[i].r = cha_in[i] * plan->window[i];
+        plan->in[i].i = chb_in[i] * plan->window[i];
+    }
+
+    fft_Execute(fft, plan->in, plan->out);
+
+    /* A[k] = (Z[k] + conj(Z[N-k])) / 2, B[k] = (Z[k] - conj(Z[N-k])) / 2j;
+     * bin 0 pairs with itself, so both are real there. */
+    z = plan->out;
+    cha_out[0] = z[0].r * z[0].r;
+    chb_out[0] = z[0].i * z[0].i;
+    for(i = 1; i < half; i++) {
+        rp_fft_cpx_t a = z[i], b = z[len - i];
+        float ar = a.r + b.r, ai = a.i - b.i;
+        float br = a.i + b.i, bi = b.r - a.r;
+        cha_out[i] = 0.25f * (ar * ar + ai * ai);
+        chb_out[i] = 0.25f * (br * br + bi * bi);
+    }
+
+    rp_spectr_plan_put(plan);
+    return 0;
+}
+
+/* Sum of n samples */
+static float rp_spectr_sum(const float *x, int n)
+{
+    float sum = 0;
+    int k = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc = vdupq_n_f32(0);
+    for(; k + 4 <= n; k += 4) {
+        acc = vaddq_f32(acc, vld1q_f32(x + k));
+    }
+    float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(half, half), 0);
+#elif defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for(; k + 4 <= n; k += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(x + k));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#endif
+    for(; k < n; k++) {
+        sum += x[k];
+    }
+    return sum;
+}
+
+int rp_spectr_decimate_f(const float *cha_in, const float *chb_in,
+                         float *cha_out, float *chb_out,
+                         int in_len, int out_len)
+{
+    int step;
+    int i, j;
+
+    if(!cha_in || !chb_in || !cha_out || !chb_out || out_len < 1)
+        return -1;
+
+    step = (int)round((float)in_len / (float)out_len);
+    if(step < 1)
+        step = 1;
+    if((out_len - 1) * step + step > in_len) {
+        fprintf(stderr, "rp_spectr_decimate_f() index too high\n");
+        return -1;
+    }
+
+    /* Counts^2 -> W as in rp_spectr_decimate(), for a transform of 2*in_len samples */
+    double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+    float scale = c2v * c2v / c_imp / (2.0 * in_len) / (2.0 * in_len) * 2;
+
+    for(i = 0, j = 0; i < out_len; i++, j += step) {
+        cha_out[i] = rp_spectr_sum(&cha_in[j], step) * scale;
+        chb_out[i] = rp_spectr_sum(&chb_in[j], step) * scale;
     }
 
     return 0;
 }
 
+int rp_spectr_fft_f_clean()
+{
+    int i;
+
+    pthread_mutex_lock(&rp_spectr_plan_mutex);
+    for(i = 0; i < SPECTR_PLAN_CACHE; i++) {
+        /* A plan pinned by a running call is freed by a later clean */
+        if(rp_spectr_plans[i].refs == 0) {
+            rp_spectr_plan_free(&rp_spectr_plans[i]);
+        }
+    }
+    pthread_mutex_unlock(&rp_spectr_plan_mutex);
+    return 0;
+}
+
+float rp_spectr_log10f(float x)
+{
+    union { float f; uint32_t u; } v = { .f = x };
+    int e = (int)(v.u >> 23) - 127;
+
+    /* x = m * 2^e with m in [sqrt(1/2), sqrt(2)) */
+    v.u = (v.u & 0x007fffff) | 0x3f800000;
+    if(v.f > (float)M_SQRT2) {
+        v.f *= 0.5f;
+        e++;
+    }
+    /* ln(m) = 2 atanh(t) = 2 (t + t^3/3 + t^5/5 + ...), |t| <= 0.1716,
+     * the omitted terms are below 1.3e-6 */
+    float t = (v.f - 1) / (v.f + 1), t2 = t * t;
+    float ln = 2 * t * (1 + t2 * (1.0f / 3 + t2 * (1.0f / 5)));
+    return ln * (float)M_LOG10E + e * (float)(M_LN2 * M_LOG10E);
+}
+
+int rp_spectr_dBm_peaks(const float *in, float *out, int len,
+                        rp_spectr_peak_t *peaks, int k)
+{
+    int i, m, found = 0;
+
+    if(!in || !out || len < 1 || k < 0 || (k > 0 && !peaks))
+        return -1;
+
+    for(i = 0; i <= len; i++) {
+        if(i < len) {
+            /* W -> mW -> dBm, avoiding -Inf due to log10(0.0) */
+            float p = in[i] * c_w2mw;
+            out[i] = p > 1.0e-12f ? 10 * rp_spectr_log10f(p) : -120;
+        }
+
+        /* Bin m = i-1 is a peak if it is higher than the bin before and not
+         * lower than the bin after; bins outside of the signal are -Inf */
+        m = i - 1;
+        if(m < 0 || k == 0)
+            continue;
+        float a = m > 0 ? out[m - 1] : -INFINITY;
+        float b = out[m];
+        float c = i < len ? out[i] : -INFINITY;
+        if(!(b > a && b >= c))
+            continue;
+
+        /* Vertex of the parabola through the three bins */
+        float d = 0, level = b;
+        if(m > 0 && i < len && a - 2 * b + c < 0) {
+            d = 0.5f * (a - c) / (a - 2 * b + c);
+            level = b - 0.25f * (a - c) * d;
+        }
+        if(found == k && level <= peaks[k - 1].level)
+            continue;
+
+        /* Insert sorted by level, dropping the lowest of a full list */
+        int j = found < k ? found++ : k - 1;
+        for(; j > 0 && peaks[j - 1].level < level; j--) {
+            peaks[j] = peaks[j - 1];
+        }
+        peaks[j].bin   = m + d;
+        peaks[j].level = level;
+    }
+
+    return found;
+}
+
 int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
                          float **cha_out, float **chb_out,
                          float *peak_power_cha, float *peak_freq_cha,
@@ -273,51 +595,23 @@ int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
         return -1;
     }
 
-    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
-
-        /* Conversion to power (Watts) */
-    	
-	    
-	double cha_p=cha_in[i];
-        double chb_p=chb_in[i];    
+    /* Issue #3369: Remove DC component */
+    const float c_dc_noise = -80.0; /* [dBm] */
+    const int   c_dc_span  =  2;    /* [output samples] */
+    rp_spectr_peak_t peak_cha, peak_chb;
 
-	
-	
-    
-	// Avoiding -Inf due to log10(0.0) 
-	
-	if (cha_p * c_w2mw > 1.0e-12 )	
-        cha_o[i] = 10 * log10(cha_p * c_w2mw);  // W -> mW -> dBm
-	else	
-	cha_o[i]=10 * log10(1.0e-12);  
-	
-	
-        if (chb_p * c_w2mw > 1.0e-12 )        	
-        chb_o[i] = 10 * log10(chb_p * c_w2mw);
-	else	
-	 chb_o[i]=10 * log10(1.0e-12);
-	
-
-	
-
-        /* Issue #3369: Remove DC component */
-        const float c_dc_noise = -80.0; /* [dBm] */
-        const int   c_dc_span  =  2;    /* [output samples] */
-        if (i < c_dc_span) {
-            cha_o[i] = c_dc_noise;
-            chb_o[i] = c_dc_noise;
-        }
-
-        /* Find peaks */
-        if(cha_o[i] > max_pw_cha) {
-            max_pw_cha     = cha_o[i];
-            max_pw_idx_cha = i;
-        }
-        if(chb_o[i] > max_pw_chb) {
-            max_pw_chb     = chb_o[i];
-            max_pw_idx_chb = i;
-        }
+    /* Conversion to dBm and the highest peak in one pass, without the DC bins */
+    if(rp_spectr_dBm_peaks(cha_in + c_dc_span, cha_o + c_dc_span,
+                           SPECTR_OUT_SIG_LEN - c_dc_span, &peak_cha, 1) < 1 ||
+       rp_spectr_dBm_peaks(chb_in + c_dc_span, chb_o + c_dc_span,
+                           SPECTR_OUT_SIG_LEN - c_dc_span, &peak_chb, 1) < 1)
+        return -1;
+    for(i = 0; i < c_dc_span; i++) {
+        cha_o[i] = c_dc_noise;
+        chb_o[i] = c_dc_noise;
     }
+    max_pw_idx_cha = (int)lrintf(peak_cha.bin) + c_dc_span;
+    max_pw_idx_chb = (int)lrintf(peak_chb.bin) + c_dc_span;
 
 	// Power correction (summing contributions of contiguous bins)
 	const int c_pwr_int_cnts=3; // Number of bins on the left and right side of the max
@@ -355,10 +649,10 @@ int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
 
        
     *peak_power_cha = max_pw_cha;
-    *peak_freq_cha = ((float)max_pw_idx_cha / (float)SPECTR_OUT_SIG_LEN * 
+    *peak_freq_cha = ((peak_cha.bin + c_dc_span) / (float)SPECTR_OUT_SIG_LEN * 
                       freq_smpl  / 2) / unit_div;
     *peak_power_chb = max_pw_chb;
-    *peak_freq_chb = ((float)max_pw_idx_chb / (float)SPECTR_OUT_SIG_LEN * 
+    *peak_freq_chb = ((peak_chb.bin + c_dc_span) / (float)SPECTR_OUT_SIG_LEN * 
                       freq_smpl / 2) / unit_div;
 
     return 0;
@@ -53,6 +53,48 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
                        float **cha_out, float **chb_out,
                        int in_len, int out_len);
 
+/* Single precision pipeline
+ * Both channels are windowed and transformed together, as the real and the
+ * imaginary part of one complex FFT, and separated when the power of the bins
+ * is taken. The FFT plans come from rp_FftPlanGet(); windows and buffers are
+ * cached per transform length and pinned while a call uses them, so calls
+ * with different lengths may run concurrently. Calls with the same length
+ * share buffers and must not run concurrently.
+ */
+
+/* Hann window + FFT + power of both channels.
+ * Inputs of length len (even), outputs of len/2 bins of |FFT|^2 [counts^2].
+ */
+int rp_spectr_fft_power_f(const float *cha_in, const float *chb_in,
+                          float *cha_out, float *chb_out, int len);
+
+/* Decimation of power spectra from rp_spectr_fft_power_f(), as rp_spectr_decimate() */
+int rp_spectr_decimate_f(const float *cha_in, const float *chb_in,
+                         float *cha_out, float *chb_out,
+                         int in_len, int out_len);
+
+/* Frees the cached windows and buffers not in use by a running call */
+int rp_spectr_fft_f_clean();
+
+/* Fast log10() for display paths: x must be a positive normal number, the
+ * error is below 1e-5 (1e-4 dB).
+ */
+float rp_spectr_log10f(float x);
+
+/* Peak of a spectrum, refined by parabolic interpolation */
+typedef struct {
+    float bin;      /* Fractional bin index */
+    float level;    /* Level [dBm] */
+} rp_spectr_peak_t;
+
+/* Converts len bins of power [W] to dBm with rp_spectr_log10f(), down to
+ * -120 dBm, and in the same pass finds the k highest local maxima, sorted
+ * from the highest. Output may be the input. Returns the number of peaks
+ * found (at most k) or -1.
+ */
+int rp_spectr_dBm_peaks(const float *in, float *out, int len,
+                        rp_spectr_peak_t *peaks, int k);
+
 /* Converts amplitude of the signal to Voltage (k_c2v - counts 2 voltage) and
  * to dBm (k_dBm) & convert to linear scale (20*log10())
  * Input & Outputs of length SPECTR_OUT_SIG_LEN (decimated length)
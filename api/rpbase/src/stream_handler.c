@@ -0,0 +1,349 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming acquisition handler implementation
+ *
+ * The AXI recorders of the oscilloscope write both channels continuously into
+ * two DDR ring buffers. A producer thread follows their write pointers, copies
+ * every completed block into cacheable memory and publishes it in a ring that
+ * any number of readers take blocks from without locks. Slow readers lose the
+ * oldest blocks; the losses are counted instead of stalling the producer.
+ * Readers are counted so that stopping waits for them before the ring and the
+ * DDR mappings are released.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "stream_handler.h"
+
+/* @brief Samples in one 64 bit word written by the recorders. */
+#define STREAM_WORD_SAMPLES 4
+
+/* @brief Limits of the producer polling period, in [ns]. */
+#define STREAM_POLL_MIN_NS  20000
+#define STREAM_POLL_MAX_NS  1000000
+
+/* @brief Sampling period (non-decimated) - 8 [ns]. */
+#define STREAM_SAMPLE_PERIOD_NS 8
+
+/* One published block; the samples of both channels live in stream.data */
+typedef struct {
+    uint64_t seq;           // block number + 1 once published, 0 while it is written
+    uint64_t first_sample;  // index of the first sample since start
+} stream_slot_t;
+
+static struct {
+    bool running;
+    rp_stream_config_t config;
+    uint64_t poll_ns;
+    const volatile int16_t* ram[2];
+    stream_slot_t* slots;
+    int16_t* data;
+    pthread_t thread;
+    uint64_t write_idx;     // blocks published by the producer
+    uint64_t read_idx;      // blocks claimed by readers
+    uint32_t readers;       // threads inside stream_Read()
+    uint64_t consumed;
+    uint64_t ring_overruns;
+    uint64_t dma_overruns;
+} stream;
+
+
+/* Copies 'bytes' from a DDR ring starting at offset 'pos', wrapping at its end; offsets and sizes are whole words */
+static void stream_CopyFromRing(int16_t* dst, const volatile int16_t* ring, uint32_t pos, uint32_t bytes)
+{
+    uint32_t first = MIN(bytes, STREAM_RAM_SIZE - pos);
+    const volatile uint32_t* words = (const volatile uint32_t*) ring;
+    cmn_CopyFromDevice((uint32_t*) dst, words + pos / sizeof(uint32_t), first / sizeof(uint32_t));
+    cmn_CopyFromDevice((uint32_t*) ((char*) dst + first), words, (bytes - first) / sizeof(uint32_t));
+}
+
+/**
+ * Copies the block at DDR offset 'pos' of both channels into the next slot.
+ * The slot sequence acts as a seqlock: it is cleared before the data changes
+ * and set to the block number + 1 once the copy is complete.
+ */
+static void stream_Publish(uint32_t pos, uint64_t first_sample)
+{
+    uint32_t block_size = stream.config.block_size;
+    uint64_t n = stream.write_idx;
+    uint32_t slot_idx = n % stream.config.ring_blocks;
+    stream_slot_t* slot = &stream.slots[slot_idx];
+    int16_t* data = stream.data + (size_t) slot_idx * 2 * block_size;
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    stream_CopyFromRing(data, stream.ram[0], pos, block_size * sizeof(int16_t));
+    stream_CopyFromRing(data + block_size, stream.ram[1], pos, block_size * sizeof(int16_t));
+    __atomic_store_n(&slot->first_sample, first_sample, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->seq, n + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&stream.write_idx, n + 1, __ATOMIC_RELEASE);
+}
+
+static void* stream_Worker(void* arg)
+{
+    const uint32_t block_bytes = stream.config.block_size * sizeof(int16_t);
+    uint32_t decimation;
+    uint32_t pos = 0;
+    uint64_t sample = 0;
+    uint64_t last = cmn_NowNs();
+
+    if (acq_GetDecimationFactor(&decimation) != RP_OK) {
+        decimation = 1;
+    }
+
+    while (__atomic_load_n(&stream.running, __ATOMIC_ACQUIRE)) {
+        uint32_t cur_a, cur_b;
+        osc_GetAxiWritePointerChA(&cur_a);
+        osc_GetAxiWritePointerChB(&cur_b);
+        cur_a -= STREAM_RAM_A_ADDR;
+        cur_b -= STREAM_RAM_B_ADDR;
+
+        uint32_t avail_a = (cur_a + STREAM_RAM_SIZE - pos) % STREAM_RAM_SIZE;
+        uint32_t avail_b = (cur_b + STREAM_RAM_SIZE - pos) % STREAM_RAM_SIZE;
+        uint32_t avail = MIN(avail_a, avail_b);
+
+        /* The pointers alone cannot tell a full lap of the recorder, so on the
+         * board the time since the last poll is checked as well. The simulated
+         * recorder only moves on rp_SimStep() and cannot lap unnoticed. */
+        uint64_t now = cmn_NowNs();
+        uint64_t recorded = (now - last) / (STREAM_SAMPLE_PERIOD_NS * decimation);
+        last = now;
+        if (cmn_GetBackend() == RP_BACKEND_DEVMEM && recorded * sizeof(int16_t) + block_bytes >= STREAM_RAM_SIZE) {
+            __atomic_add_fetch(&stream.dma_overruns, 1, __ATOMIC_RELAXED);
+            sample += recorded;
+            pos = cur_a - cur_a % (STREAM_WORD_SAMPLES * sizeof(int16_t));
+            continue;
+        }
+
+        while (avail >= block_bytes) {
+            stream_Publish(pos, sample);
+            pos = (pos + block_bytes) % STREAM_RAM_SIZE;
+            sample += stream.config.block_size;
+            avail -= block_bytes;
+        }
+
+        cmn_SleepNs(stream.poll_ns);
+    }
+
+    return NULL;
+}
+
+/* Points the AXI recorders at the DDR rings and starts them */
+static int stream_StartRecorders()
+{
+    // Record continuously: without a trigger source the recorders never stop
+    ECHECK(acq_SetTriggerSrc(RP_TRIG_SRC_DISABLED));
+    ECHECK(osc_SetAxiBufferChA(STREAM_RAM_A_ADDR, STREAM_RAM_A_ADDR + STREAM_RAM_SIZE));
+    ECHECK(osc_SetAxiBufferChB(STREAM_RAM_B_ADDR, STREAM_RAM_B_ADDR + STREAM_RAM_SIZE));
+    ECHECK(osc_SetAxiTriggerDelayChA(0));
+    ECHECK(osc_SetAxiTriggerDelayChB(0));
+    ECHECK(osc_SetAxiEnableChA(true));
+    ECHECK(osc_SetAxiEnableChB(true));
+    ECHECK(osc_ResetWriteStateMachine());
+    ECHECK(acq_Start());
+    return RP_OK;
+}
+
+/**
+ * Stops the recorders and releases the DDR mappings and the ring, whatever
+ * part of stream_Start() succeeded. Every step is taken even if an earlier
+ * one fails; the first error is returned.
+ */
+static int stream_Teardown()
+{
+    int ret = osc_SetAxiEnableChA(false);
+    int ret_b = osc_SetAxiEnableChB(false);
+    int ret_stop = acq_Stop();
+
+    if (stream.ram[0] != NULL) {
+        cmn_Unmap(STREAM_RAM_SIZE, (void**) &stream.ram[0]);
+    }
+    if (stream.ram[1] != NULL) {
+        cmn_Unmap(STREAM_RAM_SIZE, (void**) &stream.ram[1]);
+    }
+    free(stream.slots);
+    free(stream.data);
+    stream.slots = NULL;
+    stream.data = NULL;
+
+    if (ret == RP_OK) {
+        ret = ret_b;
+    }
+    if (ret == RP_OK) {
+        ret = ret_stop;
+    }
+    return ret;
+}
+
+int stream_Start(const rp_stream_config_t* config)
+{
+    if (stream.running) {
+        return RP_EUF;
+    }
+
+    uint32_t block_size = config->block_size;
+    if (block_size == 0 || block_size % STREAM_WORD_SAMPLES != 0
+            || block_size * sizeof(int16_t) > STREAM_RAM_SIZE / 2 || config->ring_blocks < 2) {
+        return RP_EIPV;
+    }
+
+    uint32_t decimation;
+    ECHECK(acq_GetDecimationFactor(&decimation));
+
+    stream.config = *config;
+    stream.write_idx = 0;
+    stream.read_idx = 0;
+    stream.consumed = 0;
+    stream.ring_overruns = 0;
+    stream.dma_overruns = 0;
+
+    // Poll about twice per block
+    stream.poll_ns = (uint64_t) block_size * STREAM_SAMPLE_PERIOD_NS * decimation / 2;
+    stream.poll_ns = MAX(MIN(stream.poll_ns, STREAM_POLL_MAX_NS), STREAM_POLL_MIN_NS);
+
+    stream.slots = calloc(config->ring_blocks, sizeof(stream_slot_t));
+    stream.data = malloc((size_t) config->ring_blocks * 2 * block_size * sizeof(int16_t));
+
+    int ret = RP_OK;
+    if (stream.slots == NULL || stream.data == NULL) {
+        ret = RP_EOOR;
+    }
+    if (ret == RP_OK) {
+        ret = cmn_Map(STREAM_RAM_SIZE, STREAM_RAM_A_ADDR, (void**) &stream.ram[0]);
+    }
+    if (ret == RP_OK) {
+        ret = cmn_Map(STREAM_RAM_SIZE, STREAM_RAM_B_ADDR, (void**) &stream.ram[1]);
+    }
+    if (ret == RP_OK) {
+        ret = stream_StartRecorders();
+    }
+    if (ret == RP_OK) {
+        stream.running = true;
+        if (pthread_create(&stream.thread, NULL, stream_Worker, NULL) != 0) {
+            stream.running = false;
+            ret = RP_EOOR;
+        }
+    }
+    if (ret != RP_OK) {
+        stream_Teardown();
+        return ret;
+    }
+
+    return RP_OK;
+}
+
+/* Leaves stream_Read(), letting stream_Stop() release the ring once no reader is left */
+static int stream_ReadLeave(int ret)
+{
+    __atomic_sub_fetch(&stream.readers, 1, __ATOMIC_RELEASE);
+    return ret;
+}
+
+int stream_Read(rp_stream_block_t* block, int16_t* buffer1, int16_t* buffer2, uint32_t timeout_us)
+{
+    // Registered before running is checked, so stream_Stop() either sees this
+    // reader or this reader sees the stream stopped
+    __atomic_add_fetch(&stream.readers, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&stream.running, __ATOMIC_SEQ_CST)) {
+        return stream_ReadLeave(RP_EUF);
+    }
+
+    const uint32_t ring_blocks = stream.config.ring_blocks;
+    const uint32_t block_size = stream.config.block_size;
+    uint64_t deadline = cmn_NowNs() + (uint64_t) timeout_us * 1000;
+
+    for (;;) {
+        uint64_t r = __atomic_load_n(&stream.read_idx, __ATOMIC_ACQUIRE);
+        uint64_t w = __atomic_load_n(&stream.write_idx, __ATOMIC_ACQUIRE);
+
+        if (w - r > ring_blocks) {
+            // The oldest unread blocks were overwritten, skip them
+            if (__atomic_compare_exchange_n(&stream.read_idx, &r, w - ring_blocks, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_add_fetch(&stream.ring_overruns, w - ring_blocks - r, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
+
+        if (r == w) {
+            if (!__atomic_load_n(&stream.running, __ATOMIC_ACQUIRE)) {
+                return stream_ReadLeave(RP_EUF);
+            }
+            uint64_t now = cmn_NowNs();
+            if (now >= deadline) {
+                return stream_ReadLeave(RP_ETIM);
+            }
+            cmn_SleepNs(MIN(stream.poll_ns, deadline - now));
+            continue;
+        }
+
+        if (!__atomic_compare_exchange_n(&stream.read_idx, &r, r + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+
+        uint32_t slot_idx = r % ring_blocks;
+        stream_slot_t* slot = &stream.slots[slot_idx];
+        const int16_t* data = stream.data + (size_t) slot_idx * 2 * block_size;
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == r + 1) {
+            memcpy(buffer1, data, block_size * sizeof(int16_t));
+            memcpy(buffer2, data + block_size, block_size * sizeof(int16_t));
+            uint64_t first_sample = __atomic_load_n(&slot->first_sample, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == r + 1) {
+                block->sequence = r;
+                block->first_sample = first_sample;
+                block->size = block_size;
+                __atomic_add_fetch(&stream.consumed, 1, __ATOMIC_RELAXED);
+                return stream_ReadLeave(RP_OK);
+            }
+        }
+
+        // The producer lapped this reader while it was copying
+        __atomic_add_fetch(&stream.ring_overruns, 1, __ATOMIC_RELAXED);
+    }
+}
+
+int stream_GetStats(rp_stream_stats_t* stats)
+{
+    stats->produced = __atomic_load_n(&stream.write_idx, __ATOMIC_RELAXED);
+    stats->consumed = __atomic_load_n(&stream.consumed, __ATOMIC_RELAXED);
+    stats->ring_overruns = __atomic_load_n(&stream.ring_overruns, __ATOMIC_RELAXED);
+    stats->dma_overruns = __atomic_load_n(&stream.dma_overruns, __ATOMIC_RELAXED);
+    return RP_OK;
+}
+
+int stream_Stop()
+{
+    if (__atomic_exchange_n(&stream.running, false, __ATOMIC_SEQ_CST)) {
+        pthread_join(stream.thread, NULL);
+    }
+
+    // Waiting readers notice the stop within a poll period, copying ones finish their block
+    while (__atomic_load_n(&stream.readers, __ATOMIC_SEQ_CST) != 0) {
+        cmn_SleepNs(STREAM_POLL_MIN_NS);
+    }
+
+    return stream_Teardown();
+}
+
+bool stream_IsRunning()
+{
+    return __atomic_load_n(&stream.running, __ATOMIC_ACQUIRE);
+}
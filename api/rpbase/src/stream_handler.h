@@ -0,0 +1,33 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library streaming acquisition handler interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_STREAM_HANDLER_H_
+#define SRC_STREAM_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+// DDR regions reserved for the AXI recorders of channel A and B
+#define STREAM_RAM_A_ADDR   0x1e000000
+#define STREAM_RAM_B_ADDR   0x1f000000
+#define STREAM_RAM_SIZE     0x01000000
+
+int stream_Start(const rp_stream_config_t* config);
+int stream_Read(rp_stream_block_t* block, int16_t* buffer1, int16_t* buffer2, uint32_t timeout_us);
+int stream_GetStats(rp_stream_stats_t* stats);
+int stream_Stop();
+bool stream_IsRunning();
+
+#endif /* SRC_STREAM_HANDLER_H_ */
@@ -0,0 +1,247 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library generator sweep handler implementation
+ *
+ * The frequency and amplitude register values of every step are computed
+ * when the sweep starts. A dedicated thread, with real-time priority when
+ * the process may use it, then writes them on an absolute schedule: it
+ * sleeps until shortly before each step is due and spins for the rest, so
+ * dwell times are held to a few microseconds and errors do not accumulate.
+ * Steps write the pointer step and amplitude registers only; the pointer
+ * keeps running, so the signal stays phase continuous.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/eventfd.h>
+
+#include "common.h"
+#include "generate.h"
+#include "gen_handler.h"
+#include "sweep_handler.h"
+
+/* @brief Time before a step is due from which the thread spins instead of sleeping, in [ns]. */
+#define SWEEP_SPIN_NS       50000
+
+/* @brief Priority of the sweep thread when real-time scheduling is permitted. */
+#define SWEEP_RT_PRIORITY   50
+
+/* Register values and nominal values of one step */
+typedef struct {
+    uint32_t counter_step;
+    uint32_t amplitude_scale;
+    double frequency;
+    float amplitude;
+} sweep_point_t;
+
+static struct {
+    bool started;
+    rp_channel_t channel;
+    uint32_t steps;
+    uint64_t dwell_ns;
+    sweep_point_t* points;
+    uint32_t applied;       // steps written so far
+    rp_gen_sweep_callback_t callback;
+    void* ctx;
+    int event_fd;
+    cmn_worker_t worker;    // stopped by the thread when done, or by sweep_Stop()
+} sweep = { .event_fd = -1 };
+
+
+/* Frequency and amplitude of step i, unchecked */
+static void sweep_GetPoint(const rp_gen_sweep_config_t* config, uint32_t i, double* frequency, float* amplitude)
+{
+    if (config->mode == RP_GEN_SWEEP_LIST) {
+        *frequency = config->freq_list[i];
+        *amplitude = config->amp_list[i];
+        return;
+    }
+
+    double t = config->steps > 1 ? (double) i / (config->steps - 1) : 0.0;
+    if (config->mode == RP_GEN_SWEEP_LOG) {
+        *frequency = config->start_freq * pow(config->stop_freq / config->start_freq, t);
+    }
+    else {
+        *frequency = config->start_freq + (config->stop_freq - config->start_freq) * t;
+    }
+    *amplitude = config->start_amp + (config->stop_amp - config->start_amp) * t;
+}
+
+/* Plays the DDS table length that suits the frequencies of all steps best */
+static int sweep_SetDdsTable(const rp_gen_sweep_config_t* config, const sweep_point_t* points)
+{
+    double* frequencies = malloc((size_t) config->steps * sizeof(double));
+    if (frequencies == NULL) {
+        return RP_EOOR;
+    }
+    for (uint32_t i = 0; i < config->steps; ++i) {
+        frequencies[i] = points[i].frequency;
+    }
+
+    uint32_t size;
+    double error;
+    int ret = gen_planDds(frequencies, config->steps, config->dds_accuracy, &size, &error);
+    free(frequencies);
+    return ret == RP_OK ? gen_setDdsSize(config->channel, size) : ret;
+}
+
+static void* sweep_Worker(void* arg)
+{
+    uint64_t start = cmn_NowNs();
+
+    for (uint32_t i = 0; i < sweep.steps && sweep_IsRunning(); ++i) {
+        uint64_t due = start + i * sweep.dwell_ns;
+        cmn_WorkerWaitUntil(&sweep.worker, due, SWEEP_SPIN_NS);
+        if (!sweep_IsRunning()) {
+            break;
+        }
+
+        const sweep_point_t* point = &sweep.points[i];
+        generate_setCounterStep(sweep.channel, point->counter_step);
+        generate_setAmplitudeScale(sweep.channel, point->amplitude_scale);
+        __atomic_store_n(&sweep.applied, i + 1, __ATOMIC_RELEASE);
+
+        rp_gen_sweep_step_t step = {
+            .index = i,
+            .frequency = point->frequency,
+            .amplitude = point->amplitude,
+            .timestamp_ns = cmn_NowNs()
+        };
+        uint64_t one = 1;
+        if (write(sweep.event_fd, &one, sizeof(one)) != sizeof(one)) {
+            // Counter is saturated, so readers are woken anyway
+        }
+        if (sweep.callback) {
+            sweep.callback(&step, sweep.ctx);
+        }
+    }
+
+    // The last step is held for its dwell time as well
+    if (sweep_IsRunning()) {
+        cmn_WorkerWaitUntil(&sweep.worker, start + sweep.steps * sweep.dwell_ns, SWEEP_SPIN_NS);
+    }
+    cmn_WorkerDone(&sweep.worker);
+    return NULL;
+}
+
+int sweep_Start(const rp_gen_sweep_config_t* config, rp_gen_sweep_callback_t callback, void* ctx)
+{
+    if (sweep.started) {
+        return RP_EUF;
+    }
+    if (config->steps == 0 || config->dwell_ns == 0 || config->mode > RP_GEN_SWEEP_LIST) {
+        return RP_EIPV;
+    }
+    if (config->mode == RP_GEN_SWEEP_LIST && (config->freq_list == NULL || config->amp_list == NULL)) {
+        return RP_EIPV;
+    }
+    if (config->mode == RP_GEN_SWEEP_LOG && (config->start_freq <= 0 || config->stop_freq <= 0)) {
+        return RP_EOOR;
+    }
+    if (config->dds_accuracy < 0) {
+        return RP_EOOR;
+    }
+
+    sweep_point_t* points = malloc((size_t) config->steps * sizeof(sweep_point_t));
+    if (points == NULL) {
+        return RP_EOOR;
+    }
+
+    for (uint32_t i = 0; i < config->steps; ++i) {
+        sweep_point_t* point = &points[i];
+        sweep_GetPoint(config, i, &point->frequency, &point->amplitude);
+
+        int ret = gen_checkSweepPoint(config->channel, point->frequency, point->amplitude);
+        if (ret != RP_OK) {
+            free(points);
+            return ret;
+        }
+    }
+
+    // One DDS table serves all steps, so the sweep still only writes pointer steps
+    if (config->dds_accuracy > 0) {
+        int ret = sweep_SetDdsTable(config, points);
+        if (ret != RP_OK) {
+            free(points);
+            return ret;
+        }
+    }
+
+    for (uint32_t i = 0; i < config->steps; ++i) {
+        sweep_point_t* point = &points[i];
+        point->counter_step = gen_cnvFrequency(config->channel, point->frequency);
+        point->amplitude_scale = generate_cnvAmplitude(config->channel, point->amplitude);
+    }
+
+    sweep.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sweep.event_fd == -1) {
+        free(points);
+        return RP_EOOR;
+    }
+
+    sweep.channel = config->channel;
+    sweep.steps = config->steps;
+    sweep.dwell_ns = config->dwell_ns;
+    sweep.points = points;
+    sweep.applied = 0;
+    sweep.callback = callback;
+    sweep.ctx = ctx;
+
+    // Real-time priority keeps the dwell times when the system is loaded, without it the sweep still runs
+    if (cmn_WorkerStart(&sweep.worker, SWEEP_RT_PRIORITY, sweep_Worker) != RP_OK) {
+        close(sweep.event_fd);
+        sweep.event_fd = -1;
+        free(sweep.points);
+        sweep.points = NULL;
+        return RP_EOOR;
+    }
+
+    sweep.started = true;
+    return RP_OK;
+}
+
+int sweep_GetEventFd(int* fd)
+{
+    if (!sweep.started) {
+        return RP_EUF;
+    }
+    *fd = sweep.event_fd;
+    return RP_OK;
+}
+
+bool sweep_IsRunning()
+{
+    return cmn_WorkerIsRunning(&sweep.worker);
+}
+
+int sweep_Stop()
+{
+    if (!sweep.started) {
+        return RP_OK;
+    }
+
+    cmn_WorkerStop(&sweep.worker);
+
+    uint32_t applied = __atomic_load_n(&sweep.applied, __ATOMIC_ACQUIRE);
+    if (applied > 0) {
+        const sweep_point_t* last = &sweep.points[applied - 1];
+        gen_setSweepPoint(sweep.channel, last->frequency, last->amplitude);
+    }
+
+    close(sweep.event_fd);
+    sweep.event_fd = -1;
+    free(sweep.points);
+    sweep.points = NULL;
+    sweep.started = false;
+    return RP_OK;
+}
@@ -0,0 +1,27 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library generator sweep handler interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_SWEEP_HANDLER_H_
+#define SRC_SWEEP_HANDLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "redpitaya/rp.h"
+
+int sweep_Start(const rp_gen_sweep_config_t* config, rp_gen_sweep_callback_t callback, void* ctx);
+int sweep_GetEventFd(int* fd);
+bool sweep_IsRunning();
+int sweep_Stop();
+
+#endif /* SRC_SWEEP_HANDLER_H_ */
@@ -24,7 +24,7 @@
 #include "main.h"
 #include "fpga.h"
 #include "dsp.h"
-#include "kiss_fftr.h"
+#include "redpitaya/rp_fft.h"
 
 extern float g_spectr_fpga_adc_max_v;
 extern const int c_spectr_fpga_adc_bits;
@@ -34,9 +34,10 @@ const int c_dsp_sig_len = SPECTR_FPGA_SIG_LEN>>1;
 
 /* Internal structures used in DSP  */
 double                *rp_hann_window   = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out1 = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out2 = NULL;
-kiss_fftr_cfg         rp_kiss_fft_cfg  = NULL;
+float                *rp_fft_in        = NULL;
+rp_fft_cpx_t         *rp_fft_out1      = NULL;
+rp_fft_cpx_t         *rp_fft_out2      = NULL;
+rp_fft_plan_t        *rp_fft_plan      = NULL;
 
 /* constants - calibration dependant */
 /* Power calc. impedance*/
@@ -134,35 +135,41 @@ int rp_spectr_hann_filter(double *cha_in, double *chb_in,
 
 int rp_spectr_fft_init()
 {
-    if(rp_kiss_fft_out1 || rp_kiss_fft_out2 || rp_kiss_fft_cfg) {
+    if(rp_fft_in || rp_fft_out1 || rp_fft_out2) {
         rp_spectr_fft_clean();
     }
 
-    rp_kiss_fft_out1 = 
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
-    rp_kiss_fft_out2 =
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
+    rp_fft_in =
+        (float *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(float));
+    rp_fft_out1 = 
+        (rp_fft_cpx_t *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(rp_fft_cpx_t));
+    rp_fft_out2 =
+        (rp_fft_cpx_t *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(rp_fft_cpx_t));
 
-    rp_kiss_fft_cfg = kiss_fftr_alloc(SPECTR_FPGA_SIG_LEN, 0, NULL, NULL);
+    /* The plan is cached in librp and shared with its other users */
+    if(rp_FftPlanGet(SPECTR_FPGA_SIG_LEN, RP_FFT_REAL, &rp_fft_plan) != 0) {
+        fprintf(stderr, "rp_FftPlanGet() failed\n");
+        return -1;
+    }
 
     return 0;
 }
 
 int rp_spectr_fft_clean()
 {
-    kiss_fft_cleanup();
-    if(rp_kiss_fft_out1) {
-        free(rp_kiss_fft_out1);
-        rp_kiss_fft_out1 = NULL;
+    if(rp_fft_in) {
+        free(rp_fft_in);
+        rp_fft_in = NULL;
     }
-    if(rp_kiss_fft_out2) {
-        free(rp_kiss_fft_out2);
-        rp_kiss_fft_out2 = NULL;
+    if(rp_fft_out1) {
+        free(rp_fft_out1);
+        rp_fft_out1 = NULL;
     }
-    if(rp_kiss_fft_cfg) {
-        free(rp_kiss_fft_cfg);
-        rp_kiss_fft_cfg = NULL;
+    if(rp_fft_out2) {
+        free(rp_fft_out2);
+        rp_fft_out2 = NULL;
     }
+    rp_fft_plan = NULL;
     return 0;
 }
 
@@ -175,19 +182,23 @@ int rp_spectr_fft(double *cha_in, double *chb_in,
     if(!cha_in || !chb_in || !*cha_out || !*chb_out)
         return -1;
 
-    if(!rp_kiss_fft_out1 || !rp_kiss_fft_out2 || !rp_kiss_fft_cfg) {
+    if(!rp_fft_in || !rp_fft_out1 || !rp_fft_out2 || !rp_fft_plan) {
         fprintf(stderr, "rp_spect_fft not initialized");
         return -1;
     }
 
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)cha_in, rp_kiss_fft_out1);
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)chb_in, rp_kiss_fft_out2);
+    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++)
+        rp_fft_in[i] = cha_in[i];
+    rp_FftExecute(rp_fft_plan, rp_fft_in, rp_fft_out1);
+    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++)
+        rp_fft_in[i] = chb_in[i];
+    rp_FftExecute(rp_fft_plan, rp_fft_in, rp_fft_out2);
 
     for(i = 0; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of amplitudes
-        cha_o[i] = sqrt(pow(rp_kiss_fft_out1[i].r, 2) + 
-                        pow(rp_kiss_fft_out1[i].i, 2));
-        chb_o[i] = sqrt(pow(rp_kiss_fft_out2[i].r, 2) + 
-                        pow(rp_kiss_fft_out2[i].i, 2));
+        cha_o[i] = sqrt(pow(rp_fft_out1[i].r, 2) + 
+                        pow(rp_fft_out1[i].i, 2));
+        chb_o[i] = sqrt(pow(rp_fft_out2[i].r, 2) + 
+                        pow(rp_fft_out2[i].i, 2));
     }
     return 0;
 }
@@ -63,6 +63,15 @@ static rp_app_params_t rp_main_params[PARAMS_NUM+1] = {
 		   *    0 - disable
 		   *    1 - enable */
 		"en_avg_at_dec", 1, 0, 1,      0,         1 },
+    { /* avg_mode - averaging of successive spectra:
+       *    0 - off
+       *    1 - linear over avg_count frames, then held
+       *    2 - exponential with time constant avg_count frames
+       *    3 - peak hold
+       *    4 - min hold */
+        "avg_mode",   0, 0, 0,         0,         4 },
+    { /* avg_count - frames of the linear and exponential averaging */
+        "avg_count", 10, 0, 0,         1,      1000 },
     { /* Must be last! */
         NULL, 0.0, -1, -1, 0.0, 0.0 }
 };
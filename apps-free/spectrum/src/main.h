@@ -27,7 +27,7 @@ typedef struct rp_app_params_s {
 
 /* Parameters indexes - these defines should be in the same order as
  * rp_app_params_t structure defined in main.c */
-#define PARAMS_NUM             12
+#define PARAMS_NUM             14
 #define MIN_GUI_PARAM          0
 #define MAX_GUI_PARAM          1
 #define FREQ_RANGE_PARAM       2
@@ -40,6 +40,8 @@ typedef struct rp_app_params_s {
 #define PEAK_UNIT_CHB_PARAM    9
 #define JPG_FILE_IDX_PARAM     10
 #define EN_AVG_AT_DEC   		11
+#define AVG_MODE_PARAM         12
+#define AVG_COUNT_PARAM        13
 
 /* Output signals */
 #define SPECTR_OUT_SIG_LEN (2*1024)
@@ -27,6 +27,7 @@
 #include "fpga.h"
 #include "dsp.h"
 #include "waterfall.h"
+#include "redpitaya/rp_fft.h"
 
 /* JPG outputs: c_jpg_file_path+[1|2]+_+jpg_cnt(3 digits)+c_jpg_file_suf */
 const char c_jpg_dir_path[]="/tmp/ram";
@@ -54,6 +55,10 @@ double *rp_chb_in = NULL;
 double *rp_cha_fft = NULL;
 double *rp_chb_fft = NULL;
 
+/* Averaged power spectra, size = SPECTR_OUT_SIG_LEN */
+float *rp_cha_avg = NULL;
+float *rp_chb_avg = NULL;
+
 /* Output 3 x SPECTR_OUT_SIG signals - used internally for calculation */
 float               **rp_tmp_signals = NULL;
 
@@ -94,7 +99,10 @@ int rp_spectr_worker_init(void)
     rp_chb_in = (double *)malloc(sizeof(double) * SPECTR_FPGA_SIG_LEN);
     rp_cha_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
     rp_chb_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
-    if(!rp_cha_in || !rp_chb_in || !rp_cha_fft || !rp_chb_fft) {
+    rp_cha_avg = (float *)malloc(sizeof(float) * SPECTR_OUT_SIG_LEN);
+    rp_chb_avg = (float *)malloc(sizeof(float) * SPECTR_OUT_SIG_LEN);
+    if(!rp_cha_in || !rp_chb_in || !rp_cha_fft || !rp_chb_fft ||
+       !rp_cha_avg || !rp_chb_avg) {
         rp_spectr_worker_clean();
         return -1;
     }
@@ -186,6 +194,14 @@ int rp_spectr_worker_clean(void)
         free(rp_chb_fft);
         rp_chb_fft = NULL;
     }
+    if(rp_cha_avg) {
+        free(rp_cha_avg);
+        rp_cha_avg = NULL;
+    }
+    if(rp_chb_avg) {
+        free(rp_chb_avg);
+        rp_chb_avg = NULL;
+    }
 
     return 0;
 }
@@ -342,6 +358,10 @@ void *rp_spectr_worker_thread(void *args)
     /* depends on freq_range - do not save too much or too less */
     int                      jpg_write_div = 10;
     rp_spectr_worker_res_t   tmp_result;
+    /* averaging of the power spectra, avg_mode 0 is off */
+    int                      avg_mode = 0;
+    rp_fft_avg_t             avg_cha = { RP_FFT_AVG_LINEAR, 1, 0 };
+    rp_fft_avg_t             avg_chb = avg_cha;
 
     pthread_mutex_lock(&rp_spectr_ctrl_mutex);
     old_state = state = rp_spectr_ctrl;
@@ -359,6 +379,17 @@ void *rp_spectr_worker_thread(void *args)
                    sizeof(rp_app_params_t)*PARAMS_NUM);
             fpga_update = rp_spectr_params_fpga_update;
             rp_spectr_params_dirty = 0;
+
+            /* restart averaging when it or the frequency range changes */
+            if(fpga_update ||
+               (avg_mode != (int)curr_params[AVG_MODE_PARAM].value) ||
+               (avg_cha.count != (uint32_t)curr_params[AVG_COUNT_PARAM].value)) {
+                avg_mode = (int)curr_params[AVG_MODE_PARAM].value;
+                avg_cha.mode = avg_chb.mode = RP_FFT_AVG_LINEAR + avg_mode - 1;
+                avg_cha.count = avg_chb.count =
+                    (uint32_t)curr_params[AVG_COUNT_PARAM].value;
+                avg_cha.frames = avg_chb.frames = 0;
+            }
         }
         pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
 
@@ -453,7 +484,19 @@ void *rp_spectr_worker_thread(void *args)
                            (float **)&rp_tmp_signals[1], 
                            (float **)&rp_tmp_signals[2],
                            c_dsp_sig_len, SPECTR_OUT_SIG_LEN);
-        
+
+        /* Average the power in Watts, before the conversion to dBm */
+        if(avg_mode > 0) {
+            rp_FftAvgAdd(&avg_cha, rp_cha_avg, rp_tmp_signals[1],
+                         SPECTR_OUT_SIG_LEN);
+            rp_FftAvgAdd(&avg_chb, rp_chb_avg, rp_tmp_signals[2],
+                         SPECTR_OUT_SIG_LEN);
+            memcpy(rp_tmp_signals[1], rp_cha_avg,
+                   sizeof(float) * SPECTR_OUT_SIG_LEN);
+            memcpy(rp_tmp_signals[2], rp_chb_avg,
+                   sizeof(float) * SPECTR_OUT_SIG_LEN);
+        }
+
         rp_spectr_cnv_to_dBm(&rp_tmp_signals[1][0], &rp_tmp_signals[2][0], 
                              (float **)&rp_tmp_signals[1], 
                              (float **)&rp_tmp_signals[2], 
@@ -26,6 +26,11 @@
 
 rp_scpi_acq_unit_t unit     = RP_SCPI_VOLTS;        // default value
 
+/* Data query buffers, sized for the whole ADC buffer instead of the client
+ * supplied length. Every connection is served by its own process. */
+static float   data_volts[ADC_BUFFER_SIZE];
+static int16_t data_raw[ADC_BUFFER_SIZE];
+
 /* These structures are a direct API mirror 
 and should not be altered! */
 const scpi_choice_def_t scpi_RpUnits[] = {
@@ -631,9 +636,9 @@ scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size = end - start;
+    uint32_t size = ADC_BUFFER_SIZE;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
+        float *buffer = data_volts;
         result = rp_AcqGetDataPosV(channel, start, end, buffer, &size);
         
         if(result != RP_OK){
@@ -644,7 +649,7 @@ scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
 
     }else{
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetDataPosRaw(channel, start, end, buffer, &size);
         
         if(result != RP_OK){
@@ -682,10 +687,8 @@ scpi_result_t RP_AcqDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size_buff;
-    rp_AcqGetBufSize(&size_buff);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size_buff - start];
+        float *buffer = data_volts;
         result = rp_AcqGetDataV(channel, start, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to get "
@@ -696,7 +699,7 @@ scpi_result_t RP_AcqDataQ(scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
 
     }else{
-        int16_t buffer[size_buff - start];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetDataRaw(channel, start, &size, buffer);
 
         if(result != RP_OK){
@@ -724,7 +727,7 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t *context) {
     
     rp_AcqGetBufSize(&size);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
+        float *buffer = data_volts;
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
@@ -735,7 +738,7 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
 
     }else{
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to get raw data: %s\n", rp_GetError(result));
@@ -766,7 +769,7 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
     }
 
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
+        float *buffer = data_volts;
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
@@ -779,7 +782,7 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
 
     }else{
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:OLD:N? Failed to get raw data: %s\n", rp_GetError(result));
@@ -810,7 +813,7 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
     }
 
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
+        float *buffer = data_volts;
         result = rp_AcqGetLatestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
@@ -821,7 +824,7 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
 
         SCPI_ResultBufferFloat(context, buffer, size);
     }else{
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetLatestDataRaw(channel, &size, buffer);
 
         if(result != RP_OK){